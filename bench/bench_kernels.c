@@ -0,0 +1,338 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Micro-benchmarks for the integer kernels of librational.
+ *
+ * Usage: bench_kernels [n_rounds [filter]]
+ *
+ * Each benchmark runs over a fixed set of N_INPUTS pseudo-random operands;
+ * one round is one pass over all of them. Only benchmarks whose name
+ * contains <filter> are run. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "parse.h"
+#include "rn_fpdec.h"
+#include "rn_u64_quot.h"
+#include "rounding.h"
+
+#define N_INPUTS 1024
+#define DFLT_N_ROUNDS 2000
+#define MAX_LIT_LEN 64
+
+/*****************************************************************************
+*  Operands
+*****************************************************************************/
+
+static uint64_t rnd_state = 0x9E3779B97F4A7C15ULL;
+
+// xorshift64
+static uint64_t
+rnd_u64(void) {
+    rnd_state ^= rnd_state << 13U;
+    rnd_state ^= rnd_state >> 7U;
+    rnd_state ^= rnd_state << 17U;
+    return rnd_state;
+}
+
+// random value with a random number of significant bits (1 .. 64)
+static uint64_t
+rnd_u64_bits(void) {
+    unsigned n_bits = 1 + rnd_u64() % 64;
+    uint64_t t = rnd_u64();
+    return n_bits == 64 ? t : (t & ((1ULL << n_bits) - 1)) | 1ULL;
+}
+
+static uint64_t u64_x[N_INPUTS];
+static uint64_t u64_y[N_INPUTS];
+static uint128_t u128_x[N_INPUTS];
+static uint128_t u128_y[N_INPUTS];
+static uint128_t u128_y64[N_INPUTS];
+static uint128_t u128_mpt[N_INPUTS];
+static uint128_t coeffs[N_INPUTS];
+static rn_exp_t exps[N_INPUTS];
+static rn_prec_t precs[N_INPUTS];
+static uint8_t literals_ucs1[N_INPUTS][MAX_LIT_LEN];
+static uint32_t literals_ucs4[N_INPUTS][MAX_LIT_LEN];
+// same literals with non-ascii digits
+static uint32_t literals_intl[N_INPUTS][MAX_LIT_LEN];
+static size_t literal_lens[N_INPUTS];
+
+static const char *literal_templates[] = {
+    "0",
+    "17.8",
+    "-0.00014",
+    "  +1234567.890123  ",
+    "12345678901234567890",
+    "-123456789012345678901234567890.1234567",
+    "1.5e-7",
+    "-3E+12",
+    "5/7",
+    "-314159/100000",
+    "1.25/3",
+    "-2e3/7",
+    "0.000000000000000000001",
+    "99999999999999999999999999999999999999",
+    "3.1415926535897932384626433832795028",
+};
+
+#define N_LITERAL_TEMPLATES \
+    (sizeof(literal_templates) / sizeof(literal_templates[0]))
+
+static void
+init_operands(void) {
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        const char *lit;
+        size_t j;
+
+        u64_x[i] = rnd_u64_bits();
+        u64_y[i] = rnd_u64_bits();
+        U128_FROM_LO_HI(&u128_x[i], rnd_u64(), rnd_u64_bits());
+        U128_FROM_LO_HI(&u128_y[i], rnd_u64(), rnd_u64_bits() >> 8U);
+        U128_FROM_LO_HI(&u128_y64[i], rnd_u64_bits(), 0ULL);
+        U128_FROM_LO_HI(&u128_mpt[i], rnd_u64(), rnd_u64() % MPT);
+        // coefficients with 1 .. 38 decimal digits
+        do {
+            U128_FROM_LO_HI(&coeffs[i], rnd_u64(), rnd_u64_bits());
+            u128_idiv_u64(&coeffs[i], u64_10_pow_n(rnd_u64() % 20));
+        } while (U128_EQ_ZERO(coeffs[i]));
+        exps[i] = -(rn_exp_t)(rnd_u64() % 30);
+        precs[i] = (rn_prec_t)(rnd_u64() % 12);
+        lit = literal_templates[i % N_LITERAL_TEMPLATES];
+        for (j = 0; lit[j] != 0; ++j) {
+            literals_ucs1[i][j] = (uint8_t)lit[j];
+            literals_ucs4[i][j] = (uint32_t)lit[j];
+            // alternating fullwidth and arabic-indic digits
+            if (lit[j] >= '0' && lit[j] <= '9')
+                literals_intl[i][j] = (i & 1U ? 0xFF10U : 0x0660U) +
+                                      (uint32_t)(lit[j] - '0');
+            else
+                literals_intl[i][j] = (uint32_t)lit[j];
+        }
+        literal_lens[i] = j;
+    }
+}
+
+/*****************************************************************************
+*  Benchmarks
+*****************************************************************************/
+
+// Each function runs one round, i.e. N_INPUTS operations, and returns a
+// value depending on all results, so that nothing can be optimized away.
+
+static uint64_t
+bench_gcd(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i)
+        acc += gcd(u64_x[i], u64_y[i]);
+    return acc;
+}
+
+static uint64_t
+bench_u128_idiv_u128(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        uint128_t q = u128_x[i];
+        uint128_t r;
+        u128_idiv_u128(&r, &q, &u128_y[i]);
+        acc += U128_LO(q) + U128_LO(r);
+    }
+    return acc;
+}
+
+static uint64_t
+bench_u128_idiv_u128_64(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        uint128_t q = u128_x[i];
+        uint128_t r;
+        u128_idiv_u128(&r, &q, &u128_y64[i]);
+        acc += U128_LO(q) + U128_LO(r);
+    }
+    return acc;
+}
+
+static uint64_t
+bench_u128_idiv_mpt(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        uint128_t q = u128_mpt[i];
+        acc += u128_idiv_mpt(&q) + U128_LO(q);
+    }
+    return acc;
+}
+
+static uint64_t
+bench_rnd_to_chars(void) {
+    uint64_t acc = 0;
+    char buf[64];
+    for (size_t i = 0; i < N_INPUTS; ++i)
+        acc += rnd_to_chars(buf, i & 1U, coeffs[i], exps[i]) + buf[1];
+    return acc;
+}
+
+#define BENCH_PARSE(func, literals)                                         \
+    uint64_t acc = 0;                                                       \
+    struct rn_parsed_repr parsed;                                           \
+    for (size_t i = 0; i < N_INPUTS; ++i) {                                 \
+        if (func(&parsed, literals[i], literal_lens[i]) != 0)               \
+            abort();                                                        \
+        acc += U128_LO(parsed.coeff) + parsed.exp;                          \
+        if (parsed.is_quot)                                                 \
+            acc += U128_LO(parsed.den_coeff) + parsed.den_exp;              \
+    }                                                                       \
+    return acc
+
+static uint64_t
+bench_rn_from_ucs1_literal(void) {
+    BENCH_PARSE(rn_from_ucs1_literal, literals_ucs1);
+}
+
+static uint64_t
+bench_rn_from_ucs4_literal(void) {
+    BENCH_PARSE(rn_from_ucs4_literal, literals_ucs4);
+}
+
+static uint64_t
+bench_rn_from_ucs4_literal_intl(void) {
+    BENCH_PARSE(rn_from_ucs4_literal, literals_intl);
+}
+
+static enum RN_ROUNDING_MODE bench_rounding_mode;
+
+static uint64_t
+bench_rnd_adjust_coeff_exp(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        uint128_t coeff = coeffs[i];
+        rn_exp_t exp = exps[i];
+        if (rnd_adjust_coeff_exp(&coeff, &exp, i & 1U, precs[i],
+                                 bench_rounding_mode) == 0)
+            acc += U128_LO(coeff) + exp;
+    }
+    return acc;
+}
+
+static uint64_t
+bench_rnq_adjust_quot(void) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < N_INPUTS; ++i) {
+        uint64_t num = u64_x[i] >> 24U | 1U;
+        uint64_t den = u64_y[i] >> 24U | 1U;
+        if (rnq_adjust_quot(&num, &den, i & 1U, precs[i] % 8,
+                            bench_rounding_mode) == 0)
+            acc += num + den;
+    }
+    return acc;
+}
+
+/*****************************************************************************
+*  Driver
+*****************************************************************************/
+
+struct bench {
+    const char *name;
+    uint64_t (*run)(void);
+    enum RN_ROUNDING_MODE rounding_mode;
+};
+
+static const struct bench benchmarks[] = {
+    {"gcd", bench_gcd, 0},
+    {"u128_idiv_u128", bench_u128_idiv_u128, 0},
+    {"u128_idiv_u128 (64-bit divisor)", bench_u128_idiv_u128_64, 0},
+    {"u128_idiv_mpt", bench_u128_idiv_mpt, 0},
+    {"rnd_to_chars", bench_rnd_to_chars, 0},
+    {"rn_from_ucs1_literal", bench_rn_from_ucs1_literal, 0},
+    {"rn_from_ucs4_literal", bench_rn_from_ucs4_literal, 0},
+    {"rn_from_ucs4_literal (non-ascii)", bench_rn_from_ucs4_literal_intl, 0},
+#define ROUNDING_BENCHES(mode)                                              \
+    {"rnd_adjust_coeff_exp " #mode, bench_rnd_adjust_coeff_exp, RN_##mode}, \
+    {"rnq_adjust_quot " #mode, bench_rnq_adjust_quot, RN_##mode}
+    ROUNDING_BENCHES(ROUND_05UP),
+    ROUNDING_BENCHES(ROUND_CEILING),
+    ROUNDING_BENCHES(ROUND_DOWN),
+    ROUNDING_BENCHES(ROUND_FLOOR),
+    ROUNDING_BENCHES(ROUND_HALF_DOWN),
+    ROUNDING_BENCHES(ROUND_HALF_EVEN),
+    ROUNDING_BENCHES(ROUND_HALF_UP),
+    ROUNDING_BENCHES(ROUND_UP),
+#undef ROUNDING_BENCHES
+};
+
+#define N_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static inline uint64_t
+now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t
+now_cycles(void) {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int
+main(int argc, char *argv[]) {
+    long n_rounds = DFLT_N_ROUNDS;
+    const char *filter = NULL;
+    volatile uint64_t sink = 0;
+
+    if (argc > 1)
+        n_rounds = strtol(argv[1], NULL, 10);
+    if (argc > 2)
+        filter = argv[2];
+    if (n_rounds <= 0) {
+        fprintf(stderr, "usage: %s [n_rounds [filter]]\n", argv[0]);
+        return 2;
+    }
+
+    init_operands();
+    printf("%-40s %12s %12s\n", "benchmark", "ns/op", "cycles/op");
+    for (size_t b = 0; b < N_BENCHMARKS; ++b) {
+        const struct bench *bench = &benchmarks[b];
+        uint64_t t0, t1, c0, c1;
+        double n_ops = (double)n_rounds * N_INPUTS;
+
+        if (filter != NULL && strstr(bench->name, filter) == NULL)
+            continue;
+        bench_rounding_mode = bench->rounding_mode;
+        // warm up
+        sink += bench->run();
+        t0 = now_ns();
+        c0 = now_cycles();
+        for (long r = 0; r < n_rounds; ++r)
+            sink += bench->run();
+        c1 = now_cycles();
+        t1 = now_ns();
+#ifdef HAVE_RDTSC
+        printf("%-40s %12.2f %12.1f\n", bench->name,
+               (double)(t1 - t0) / n_ops, (double)(c1 - c0) / n_ops);
+#else
+        printf("%-40s %12.2f %12s\n", bench->name,
+               (double)(t1 - t0) / n_ops, "n/a");
+#endif
+    }
+    return 0;
+}
@@ -6,12 +6,17 @@ from setuptools import setup, Extension
 import sysconfig
 
 DEBUG = int(os.getenv("DEBUG", 0))
+# LIMITED_API=0 builds a version specific extension, parsing str objects
+# in place
+LIMITED_API = int(os.getenv("LIMITED_API", 1))
 extra_compile_args = sysconfig.get_config_var('CFLAGS').split()
 extra_compile_args += ["-Wall", "-Wextra"]
 if DEBUG:
     extra_compile_args += ["-g3", "-O0", f"-DDEBUG={DEBUG}", "-UNDEBUG"]
 else:
     extra_compile_args += ["-DNDEBUG", "-O3"]
+if not LIMITED_API:
+    extra_compile_args += ["-DRN_FULL_API"]
 
 ext_modules = [
     Extension(
@@ -21,7 +26,7 @@ ext_modules = [
         extra_compile_args=extra_compile_args,
         # extra_link_args="",
         language='c',
-        py_limited_api=True,
+        py_limited_api=bool(LIMITED_API),
         ),
     ]
 
@@ -13,7 +13,7 @@
 
 from fractions import Fraction
 
-from .rational import Rational
+from .rational import Parser, Rational, get_str_policy, set_str_policy
 from .rounding import Rounding, get_dflt_rounding_mode, set_dflt_rounding_mode
 from .version import version_tuple as __version__  # noqa: F401
 
@@ -25,8 +25,11 @@ except AttributeError:
 
 # define public namespace
 __all__ = [
+    'Parser',
     'Rational',
     'Rounding',
     'get_dflt_rounding_mode',
     'set_dflt_rounding_mode',
+    'get_str_policy',
+    'set_str_policy',
 ]
@@ -5,31 +5,41 @@ import numbers
 from abc import abstractmethod
 from enum import Enum
 from fractions import Fraction
-from typing import Any, Optional, Protocol, Tuple, Type, Union, overload
+from typing import Any, List, Optional, Protocol, Tuple, Type, Union, overload
 
 class SupportsConversionToRational(Protocol):
 
     @abstractmethod
     def as_integer_ratio(self) -> Tuple[int, int]:
         ...
+    def hex(self) -> str:
+        ...
 
 RationalT = Union[numbers.Rational, SupportsConversionToRational]
 
+Buffer = Union[bytes, bytearray, memoryview]
+
 class Rational(numbers.Rational):
 
     @overload
     def __new__(cls: Type[Rational], numerator: None = None,
-                denominator: None = None) \
+                denominator: None = None,
+                precision: Optional[numbers.Integral] = None,
+                rounding: Optional[Rounding] = None) \
             -> Rational:
         ...
     @overload
-    def __new__(cls: Type[Rational], numerator: str = ...,
-                denominator: None = None) \
+    def __new__(cls: Type[Rational], numerator: Union[str, Buffer] = ...,
+                denominator: None = None,
+                precision: Optional[numbers.Integral] = None,
+                rounding: Optional[Rounding] = None) \
             -> Rational:
         ...
     @overload
     def __new__(cls: Type[Rational], numerator: RationalT = ...,
-                denominator: Optional[RationalT] = ...) \
+                denominator: Optional[RationalT] = ...,
+                precision: Optional[numbers.Integral] = None,
+                rounding: Optional[Rounding] = None) \
             -> Rational:
         ...
     @classmethod
@@ -40,6 +50,21 @@ class Rational(numbers.Rational):
     def from_decimal(cls: Type[Rational], d: RationalT) -> Rational:
         ...
     @classmethod
+    def from_ascii(cls: Type[Rational], buffer: Buffer, start: int = ...,
+                   end: int = ...) -> Rational:
+        ...
+    @classmethod
+    def fromhex(cls: Type[Rational], s: str) -> Rational:
+        ...
+    @classmethod
+    def from_sort_key(cls: Type[Rational], key: Buffer) -> Rational:
+        ...
+    @classmethod
+    def parse(cls: Type[Rational], s: str, decimal_point: str = ...,
+              group_sep: Optional[str] = ..., paren_negative: bool = ...,
+              trailing_sign: bool = ...) -> Rational:
+        ...
+    @classmethod
     def rounded(cls: Type[Rational], numerator: RationalT,
                 denominator: RationalT, n_digits: numbers.Integral) \
             -> Rational:
@@ -70,6 +95,16 @@ class Rational(numbers.Rational):
         ...
     def as_integer_ratio(self) -> Tuple[int, int]:
         ...
+    def sort_key(self) -> bytes:
+        ...
+    def to_decimal_str(self, max_digits: Optional[numbers.Integral] = None) \
+            -> str:
+        ...
+    def to_sci_str(self, engineering: bool = False) -> str:
+        ...
+    def write_into(self, buffer: Union[bytearray, memoryview],
+                   offset: int = 0) -> int:
+        ...
     def __copy__(self) -> Rational:
         ...
     def __deepcopy__(self, memo: Any) -> Rational:
@@ -149,6 +184,17 @@ class Rational(numbers.Rational):
     def __round__(self, ndigits: numbers.Integral) -> Rational:
         ...
 
+class Parser:
+    def __init__(self) -> None:
+        ...
+    @property
+    def pending(self) -> bytes:
+        ...
+    def feed(self, data: Buffer) -> List[Rational]:
+        ...
+    def close(self) -> List[Rational]:
+        ...
+
 class Rounding(Enum):
     ROUND_05UP: Rounding = ...
     ROUND_CEILING: Rounding = ...
@@ -163,3 +209,9 @@ def get_dflt_rounding_mode() -> Rounding:
     ...
 def set_dflt_rounding_mode(rounding: Rounding) -> None:
     ...
+def get_str_policy() -> Tuple[Optional[int], bool]:
+    ...
+def set_str_policy(sci_threshold: Optional[int] = None,
+                   engineering: bool = False) \
+        -> Tuple[Optional[int], bool]:
+    ...
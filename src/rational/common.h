@@ -11,23 +11,10 @@ $Revision$
 #ifndef RATIONAL_COMMON_H
 #define RATIONAL_COMMON_H
 
-// sign indicator: 0 -> zero, -1 -> negative, 1 -> positive
-typedef int8_t rn_sign_t;
-#define RN_SIGN_ZERO 0
-#define RN_SIGN_NEG -1
-#define RN_SIGN_POS 1
+#include "librational.h"
 
-// exponent of internal representation
-typedef int16_t rn_exp_t;
-#define RN_MAX_EXP INT16_MAX
-#define RN_MIN_EXP (-INT16_MAX)
-#define RN_UNDEF_EXP INT16_MIN
-
-// number of decimal fractional digits
-typedef int16_t rn_prec_t;
-#define RN_UNLIM_PREC INT16_MAX
-#define RN_MAX_PREC 9999
-#define RN_MIN_PREC (-RN_MAX_PREC)
+// magnitude, i.e. floor(log10(abs(value)))
+#define RN_UNDEF_MAGN PY_SSIZE_T_MIN
 
 // Python int numerator / denominator
 typedef struct pyint_quot {
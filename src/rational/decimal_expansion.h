@@ -0,0 +1,407 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Exact decimal expansion of fractions r / den with 0 <= r < den < 2 ^ 64:
+ * <prefix>(<period>), where the digits of <period> repeat infinitely.
+ *
+ * With den = 2 ^ a * 5 ^ b * d and d coprime to 10 (and r / den reduced),
+ * <prefix> has max(a, b) digits and the length of <period> is the
+ * multiplicative order of 10 modulo d, i.e. the least n > 0 with
+ * 10 ^ n = 1 (mod d). The order is derived from the prime factorization of
+ * d, so that it is known before any digit is generated.
+ *
+ * For d of up to 128 bits, factoring may be too expensive, but the order
+ * only has to be known if it does not exceed the number of digits which can
+ * be generated anyway. So, it is searched by baby-step giant-step up to a
+ * given limit, using Montgomery multiplication modulo d. */
+
+#ifndef RATIONAL_DECIMAL_EXPANSION_H
+#define RATIONAL_DECIMAL_EXPANSION_H
+
+#include <assert.h>
+
+#include "rn_u64_quot.h"
+
+// a 64-bit number has at most 15 distinct prime factors
+#define U64_MAX_N_PRIME_FACTORS 16
+
+struct u64_factors {
+    unsigned n;
+    uint64_t primes[U64_MAX_N_PRIME_FACTORS];
+    unsigned exps[U64_MAX_N_PRIME_FACTORS];
+};
+
+static inline uint64_t
+u64_mulmod(uint64_t x, uint64_t y, uint64_t m) {
+    uint128_t t;
+
+    u64_mul_u64(&t, x, y);
+    return u128_idiv_u64(&t, m);
+}
+
+static inline uint64_t
+u64_powmod(uint64_t base, uint64_t exp, uint64_t m) {
+    uint64_t res = 1 % m;
+
+    base %= m;
+    while (exp > 0) {
+        if (exp & 1U)
+            res = u64_mulmod(res, base, m);
+        base = u64_mulmod(base, base, m);
+        exp >>= 1U;
+    }
+    return res;
+}
+
+// Deterministic Miller-Rabin test; the first 12 primes as bases suffice
+// for all n < 2 ^ 64.
+static inline bool
+u64_is_prime(uint64_t n) {
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                     37};
+    const size_t n_bases = sizeof(bases) / sizeof(bases[0]);
+    uint64_t d, x;
+    unsigned s;
+
+    if (n < 2)
+        return false;
+    for (size_t i = 0; i < n_bases; ++i) {
+        if (n % bases[i] == 0)
+            return n == bases[i];
+    }
+    s = u64_n_trailing_0_bits(n - 1);
+    d = (n - 1) >> s;
+    for (size_t i = 0; i < n_bases; ++i) {
+        unsigned r;
+        x = u64_powmod(bases[i], d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        for (r = 1; r < s; ++r) {
+            x = u64_mulmod(x, x, n);
+            if (x == n - 1)
+                break;
+        }
+        if (r == s)
+            return false;
+    }
+    return true;
+}
+
+// (x * x + c) mod n, c < n
+static inline uint64_t
+u64_rho_step(uint64_t x, uint64_t c, uint64_t n) {
+    x = u64_mulmod(x, x, n);
+    return x >= n - c ? x - (n - c) : x + c;
+}
+
+// Non-trivial factor of the odd composite n (Pollard's rho with Floyd's
+// cycle detection)
+static inline uint64_t
+u64_pollard_rho(uint64_t n) {
+    for (uint64_t c = 1;; ++c) {
+        uint64_t x = 2, y = 2, d = 1;
+        while (d == 1) {
+            x = u64_rho_step(x, c, n);
+            y = u64_rho_step(u64_rho_step(y, c, n), c, n);
+            d = gcd(x > y ? x - y : y - x, n);
+        }
+        if (d != n)
+            return d;
+    }
+}
+
+static inline void
+u64_factors_add(struct u64_factors *f, uint64_t p, unsigned exp) {
+    for (unsigned i = 0; i < f->n; ++i) {
+        if (f->primes[i] == p) {
+            f->exps[i] += exp;
+            return;
+        }
+    }
+    assert(f->n < U64_MAX_N_PRIME_FACTORS);
+    f->primes[f->n] = p;
+    f->exps[f->n] = exp;
+    ++f->n;
+}
+
+static void
+u64_factorize_large(struct u64_factors *f, uint64_t n) {
+    uint64_t d;
+
+    if (n == 1)
+        return;
+    if (u64_is_prime(n)) {
+        u64_factors_add(f, n, 1);
+        return;
+    }
+    d = u64_pollard_rho(n);
+    u64_factorize_large(f, d);
+    u64_factorize_large(f, n / d);
+}
+
+// Prime factorization of n > 0
+static inline void
+u64_factorize(struct u64_factors *f, uint64_t n) {
+    f->n = 0;
+    // small factors by trial division, the rest by Pollard's rho
+    for (uint64_t p = 2; p < 1000 && p * p <= n; p += p == 2 ? 1 : 2) {
+        unsigned exp = 0;
+        for (; n % p == 0; n /= p)
+            ++exp;
+        if (exp > 0)
+            u64_factors_add(f, p, exp);
+    }
+    u64_factorize_large(f, n);
+}
+
+// Multiplicative order of 10 modulo n, n > 1 and coprime to 10
+static inline uint64_t
+u64_mult_order_10(uint64_t n) {
+    struct u64_factors f;
+    uint64_t lambda = 1;
+    uint64_t order;
+
+    assert(n > 1 && n % 2 != 0 && n % 5 != 0);
+    // the order divides the Carmichael function of n, which is the lcm of
+    // (p - 1) * p ^ (e - 1) over all prime powers p ^ e dividing n
+    u64_factorize(&f, n);
+    for (unsigned i = 0; i < f.n; ++i) {
+        uint64_t t = f.primes[i] - 1;
+        for (unsigned e = 1; e < f.exps[i]; ++e)
+            t *= f.primes[i];
+        lambda = lambda / gcd(lambda, t) * t;
+    }
+    // remove all prime factors not needed for 10 ^ order = 1 (mod n)
+    order = lambda;
+    u64_factorize(&f, lambda);
+    for (unsigned i = 0; i < f.n; ++i) {
+        for (unsigned e = 0; e < f.exps[i]; ++e) {
+            if (u64_powmod(10, order / f.primes[i], n) != 1)
+                break;
+            order /= f.primes[i];
+        }
+    }
+    return order;
+}
+
+// Montgomery arithmetic modulo an odd n < 2 ^ 128, with R = 2 ^ 128
+
+struct u128_mont {
+    uint128_t n;
+    uint64_t n_inv;         // -n ^ -1 mod 2 ^ 64
+    uint128_t one;          // R mod n
+    uint128_t r2;           // R ^ 2 mod n
+};
+
+// x * y + a + b, which always fits into 128 bits. Returns the high word and
+// stores the low word in *lo.
+static inline uint64_t
+u64_mul_add_add(uint64_t *lo, uint64_t x, uint64_t y, uint64_t a,
+                uint64_t b) {
+    uint128_t t;
+
+    u64_mul_u64(&t, x, y);
+    u128_iadd_u64(&t, a);
+    u128_iadd_u64(&t, b);
+    *lo = U128_LO(t);
+    return U128_HI(t);
+}
+
+// x - y mod 2 ^ 128
+static inline void
+u128_isub_u128_wrap(uint128_t *x, const uint128_t *y) {
+    const uint64_t lo = U128P_LO(x) - U128P_LO(y);
+    const uint64_t hi = U128P_HI(x) - U128P_HI(y) - (lo > U128P_LO(x));
+
+    U128_FROM_LO_HI(x, lo, hi);
+}
+
+// (x + y) mod n, x, y < n
+static inline uint128_t
+u128_addmod(uint128_t x, const uint128_t *y, const uint128_t *n) {
+    uint128_t t = x;
+
+    u128_iadd_u128(&t, y);
+    // t < x indicates an overflow, so that t + 2 ^ 128 >= n
+    if (u128_lt(t, x) || u128_cmp(t, *n) >= 0)
+        u128_isub_u128_wrap(&t, n);
+    return t;
+}
+
+// x * y / R mod n, x, y < n
+static inline uint128_t
+u128_mont_mul(const struct u128_mont *m, uint128_t x, uint128_t y) {
+    const uint64_t x_lo = U128_LO(x), x_hi = U128_HI(x);
+    const uint64_t n_lo = U128_LO(m->n), n_hi = U128_HI(m->n);
+    uint64_t t0 = 0, t1 = 0, t2 = 0, t3, c, q, unused;
+    uint128_t res;
+
+    for (unsigned i = 0; i < 2; ++i) {
+        const uint64_t y_i = i == 0 ? U128_LO(y) : U128_HI(y);
+        // t += x * y_i
+        c = u64_mul_add_add(&t0, x_lo, y_i, t0, 0);
+        c = u64_mul_add_add(&t1, x_hi, y_i, t1, c);
+        t2 += c;
+        t3 = t2 < c;
+        // t = (t + q * n) / 2 ^ 64, with q chosen so that the division is
+        // exact
+        q = t0 * m->n_inv;
+        c = u64_mul_add_add(&unused, q, n_lo, t0, 0);
+        c = u64_mul_add_add(&t0, q, n_hi, t1, c);
+        t1 = t2 + c;
+        t2 = t3 + (t1 < c);
+    }
+    // t < 2 * n
+    U128_FROM_LO_HI(&res, t0, t1);
+    if (t2 != 0 || u128_cmp(res, m->n) >= 0)
+        u128_isub_u128_wrap(&res, &m->n);
+    return res;
+}
+
+static inline void
+u128_mont_init(struct u128_mont *m, const uint128_t *n) {
+    const uint64_t n_lo = U128P_LO(n);
+    uint64_t inv = n_lo;
+    uint128_t t = UINT128_ZERO;
+
+    assert(n_lo & 1U);
+    m->n = *n;
+    // Newton iteration, each step doubles the number of correct bits
+    for (unsigned i = 0; i < 5; ++i)
+        inv *= 2 - n_lo * inv;
+    m->n_inv = -inv;
+    // R mod n = (R - n) mod n
+    u128_isub_u128_wrap(&t, n);
+    u128_idiv_u128(&m->one, &t, n);
+    // R ^ 2 mod n = R mod n doubled 128 times
+    m->r2 = m->one;
+    for (unsigned i = 0; i < 128; ++i)
+        m->r2 = u128_addmod(m->r2, &m->r2, n);
+}
+
+// x * R mod n, x < n
+static inline uint128_t
+u128_to_mont(const struct u128_mont *m, uint128_t x) {
+    return u128_mont_mul(m, x, m->r2);
+}
+
+// Entry of the table of baby steps used by u128_mult_order_10
+struct u128_baby_step {
+    uint128_t x;
+    uint64_t j_1;           // exponent + 1, 0 for an empty entry
+};
+
+// Size of the table of baby steps to be provided to u128_mult_order_10 for
+// the given limit: twice the least power of 2 whose square is not less than
+// the limit.
+static inline size_t
+u128_mult_order_10_table_size(uint64_t limit) {
+    uint64_t m = 1;
+
+    while (m * m < limit)
+        m *= 2;
+    return (size_t)(2 * m);
+}
+
+static inline size_t
+u128_baby_step_slot(uint128_t x, size_t table_size) {
+    const uint64_t h = (U128_LO(x) ^ U128_HI(x)) * 0x9e3779b97f4a7c15ULL;
+
+    return (size_t)(h >> 32U) & (table_size - 1);
+}
+
+// Multiplicative order of 10 modulo n, n > 1 odd and coprime to 5, if it
+// does not exceed limit, otherwise 0. The table of baby steps must provide
+// u128_mult_order_10_table_size(limit) zeroed entries.
+static inline uint64_t
+u128_mult_order_10(const uint128_t *n, uint64_t limit,
+                   struct u128_baby_step *table, size_t table_size) {
+    const uint64_t n_baby_steps = table_size / 2;
+    struct u128_mont m;
+    uint128_t ten, x, g;
+    size_t slot;
+
+    assert(table_size == u128_mult_order_10_table_size(limit));
+    u128_mont_init(&m, n);
+    U128_FROM_LO_HI(&x, 10ULL, 0ULL);
+    u128_idiv_u128(&ten, &x, n);
+    ten = u128_to_mont(&m, ten);
+    // baby steps: 10 ^ j for 0 <= j < n_baby_steps
+    x = m.one;
+    for (uint64_t j = 0; j < n_baby_steps; ++j) {
+        if (j > 0 && u128_cmp(x, m.one) == 0)
+            return j <= limit ? j : 0;
+        slot = u128_baby_step_slot(x, table_size);
+        while (table[slot].j_1 != 0)
+            slot = (slot + 1) & (table_size - 1);
+        table[slot].x = x;
+        table[slot].j_1 = j + 1;
+        x = u128_mont_mul(&m, x, ten);
+    }
+    // giant steps: 10 ^ (i * n_baby_steps) = 10 ^ j gives the order
+    // i * n_baby_steps - j, as the baby steps are distinct
+    g = x;
+    for (uint64_t i = 1; (i - 1) * n_baby_steps < limit; ++i) {
+        slot = u128_baby_step_slot(x, table_size);
+        for (; table[slot].j_1 != 0; slot = (slot + 1) & (table_size - 1)) {
+            if (u128_cmp(table[slot].x, x) == 0) {
+                uint64_t order = i * n_baby_steps - (table[slot].j_1 - 1);
+                return order <= limit ? order : 0;
+            }
+        }
+        x = u128_mont_mul(&m, x, g);
+    }
+    return 0;
+}
+
+// Get the number of non-repeating digits and the number of repeating
+// digits of the decimal expansion of r / den, 0 < r < den, r / den
+// reduced.
+static inline void
+u64_dec_expansion_lengths(uint64_t *n_prefix_digits,
+                          uint64_t *n_period_digits, uint64_t den) {
+    unsigned n_2 = u64_n_trailing_0_bits(den);
+    unsigned n_5 = 0;
+
+    den >>= n_2;
+    for (; den % 5 == 0; den /= 5)
+        ++n_5;
+    *n_prefix_digits = MAX(n_2, n_5);
+    *n_period_digits = den == 1 ? 0 : u64_mult_order_10(den);
+}
+
+// Write the first n_digits fractional digits of r / den, r < den, to buf.
+// Returns a pointer to the char following the digits.
+static inline char *
+u64_write_frac_digits(char *buf, uint64_t r, uint64_t den,
+                      uint64_t n_digits) {
+    char *cp = buf;
+
+    while (n_digits > 0) {
+        unsigned n = n_digits < UINT64_10_POW_N_CUTOFF ?
+                     (unsigned)n_digits : UINT64_10_POW_N_CUTOFF;
+        uint128_t t;
+        uint64_t q;
+
+        // r * 10 ^ n / den < 10 ^ n, so the quotient fits into 64 bits
+        u64_mul_u64(&t, r, u64_10_pow_n(n));
+        r = u128_idiv_u64(&t, den);
+        q = U128_LO(t);
+        for (unsigned i = n; i > 0; --i) {
+            cp[i - 1] = (char)('0' + q % 10);
+            q /= 10;
+        }
+        cp += n;
+        n_digits -= n;
+    }
+    return cp;
+}
+
+#endif //RATIONAL_DECIMAL_EXPANSION_H
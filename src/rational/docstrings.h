@@ -23,32 +23,43 @@ PyDoc_STRVAR(
     RationalType_doc,
     "Rational number with a given number of fractional digits.\n\n"
     "Args:\n"
-    "   value (see below): numerical value (default: None)\n"
+    "   numerator (see below): numerical value (default: None)\n"
+    "   denominator (see below): numerical value (default: None)\n"
     "   precision (numbers.Integral): number of fractional digits (default:\n"
-    "       None)\n\n"
-    "If `value` is given, it must either be a string, an instance of\n"
+    "       None)\n"
+    "   rounding (ROUNDING): rounding mode (default: None)\n\n"
+    "If `numerator` is given, it must either be a string, an instance of\n"
     "`numbers.Integral`, `number.Rational` (for example `fractions.Fraction`),\n"
     "`rational.Rational`, a finite instance of `numbers.Real` (for example "
     "`float`)\n"
-    "or be convertable to a `float` or an `int`.\n\n"
-    "If a string is given as value, it must be a string in one of two formats:\n\n"
-    "    * [+|-]<int>[.<frac>][<e|E>[+|-]<exp>] or\n"
-    "    * [+|-].<frac>[<e|E>[+|-]<exp>].\n\n"
-    "If given value is `None`, Rational(0) is returned.\n\n"
+    "or be convertable to a `float` or an `int`. If `denominator` is given,\n"
+    "the same applies to it, except that it must not be a string, and the\n"
+    "value is `numerator` / `denominator`.\n\n"
+    "If a string is given as numerator, it must be a string in one of two "
+    "formats:\n\n"
+    "    * [+|-]<dec>/<dec> or\n"
+    "    * [+|-]<dec>\n\n"
+    "where <dec> is\n\n"
+    "    * <int>[.<frac>][<e|E>[+|-]<exp>] or\n"
+    "    * .<frac>[<e|E>[+|-]<exp>].\n\n"
+    "If given numerator is `None`, Rational(0) is returned.\n\n"
     "Returns:\n"
-    "    :class:`Rational` instance derived from `value` according\n"
-    "    to `precision`\n\n"
-    "The value is always adjusted to the given precision or the precision is\n"
-    "calculated from the given value, if no precision is given.\n\n"
+    "    :class:`Rational` instance derived from `numerator` and "
+    "`denominator`\n"
+    "    according to `precision` and `rounding`\n\n"
+    "If `precision` is given, the value is rounded to at most `precision`\n"
+    "fractional digits, using the given `rounding` mode or, if no `rounding`\n"
+    "mode is given, the current default rounding mode. The result equals\n"
+    "Rational(numerator, denominator).adjusted(precision, rounding).\n\n"
     "Raises:\n"
     "    TypeError: `precision` is given, but not of type `Integral`.\n"
-    "    TypeError: `value` is not an instance of the types listed above and\n"
-    "        not convertable to `float` or `int`.\n"
-    "    ValueError: `precision` is given, but not >= 0.\n"
-    "    ValueError: `precision` is given, but not <= `MAX_DEC_PRECISION`.\n"
-    "    ValueError: `value` can not be converted to a `Rational` (with a "
-    "number\n"
-    "        of fractional digits <= `MAX_DEC_PRECISION`).\n\n"
+    "    TypeError: `rounding` is given, but not of type `ROUNDING`.\n"
+    "    TypeError: `numerator` or `denominator` is not an instance of the\n"
+    "        types listed above and not convertable to `float` or `int`.\n"
+    "    ValueError: `precision` is given, but its absolute value exceeds\n"
+    "        `MAX_DEC_PRECISION`.\n"
+    "    ValueError: `numerator` can not be converted to a `Rational`.\n"
+    "    ZeroDivisionError: `denominator` is zero.\n\n"
     ":class:`Rational` instances are immutable.\n\n"
 );
 
@@ -81,6 +92,86 @@ PyDoc_STRVAR(
     "    ValueError: `d` can not be converted to a :class:`Rational`.\n\n"
 );
 
+PyDoc_STRVAR(
+    RationalType_from_ascii_doc,
+    "Convert an ascii literal contained in a bytes-like object to a "
+    ":class:`Rational`.\n\n"
+    "Args:\n"
+    "    buffer (bytes-like): object containing the literal\n"
+    "    start (Optional[int]): index of the first byte of the literal "
+    "(default: 0)\n"
+    "    end (Optional[int]): index following the last byte of the literal "
+    "(default: end of `buffer`)\n\n"
+    "Returns:\n"
+    ":class:`Rational` instance derived from `buffer[start:end]`\n\n"
+    "Raises:\n"
+    "    TypeError: `buffer` does not support the buffer protocol.\n"
+    "    ValueError: `buffer[start:end]` is not a valid literal.\n\n"
+    "`start` and `end` are interpreted as in slicing, but the slice is "
+    "parsed\nin place.\n"
+);
+
+PyDoc_STRVAR(
+    RationalType_parse_doc,
+    "Convert a formatted literal, like those found in reports, to a "
+    ":class:`Rational`.\n\n"
+    "Args:\n"
+    "    s (str): literal to be converted\n"
+    "    decimal_point (Optional[str]): char separating the integral and the "
+    "\n        fractional part of a number (default: '.')\n"
+    "    group_sep (Optional[str]): char allowed to split the integral part "
+    "of\n        a number into groups of three digits, or None (default: "
+    "',')\n"
+    "    paren_negative (Optional[bool]): whether a value enclosed in "
+    "\n        parentheses is negative (default: True)\n"
+    "    trailing_sign (Optional[bool]): whether the sign may follow the "
+    "value\n        (default: True)\n\n"
+    "Returns:\n"
+    ":class:`Rational` instance derived from `s`\n\n"
+    "Raises:\n"
+    "    ValueError: `s` is not a valid literal in the given format.\n\n"
+    "Example:\n"
+    "    >>> Rational.parse('(1,234.50)')\n"
+    "    Rational('-1234.5')\n"
+    "    >>> Rational.parse('1 234,56-', decimal_point=',', group_sep=' ')\n"
+    "    Rational('-1234.56')\n\n"
+    "Apart from that, `s` must follow the syntax of the literals accepted "
+    "by the\nconstructor.\n"
+);
+
+PyDoc_STRVAR(
+    RationalType_fromhex_doc,
+    "Convert a hexadecimal literal, as produced by :meth:`float.hex`, to a "
+    ":class:`Rational`.\n\n"
+    "Args:\n"
+    "    s (str): literal of the form [+|-][0x]<hex>[.<hex>][p[+|-]<dec>]"
+    "\n\n"
+    "Returns:\n"
+    ":class:`Rational` instance equal to <hex>.<hex> * 2 ^ <dec>\n\n"
+    "Raises:\n"
+    "    ValueError: `s` is not a valid hexadecimal literal.\n\n"
+    "Contrary to :meth:`float.fromhex`, the conversion is exact, whatever the "
+    "\nnumber of digits.\n\n"
+    "Example:\n"
+    "    >>> Rational.fromhex('0x1.8p-3')\n"
+    "    Rational('0.1875')\n\n"
+);
+
+PyDoc_STRVAR(
+    RationalType_from_sort_key_doc,
+    "Convert a sort key, as produced by :meth:`sort_key`, to a "
+    ":class:`Rational`.\n\n"
+    "Args:\n"
+    "    key: bytes-like object holding the sort key\n\n"
+    "Returns:\n"
+    ":class:`Rational` instance equal to the value encoded by `key`\n\n"
+    "Raises:\n"
+    "    ValueError: `key` is not a valid sort key.\n\n"
+    "Example:\n"
+    "    >>> Rational.from_sort_key(Rational(1, 3).sort_key())\n"
+    "    Rational(1, 3)\n\n"
+);
+
 PyDoc_STRVAR(
     Rational_rounded_doc,
     "Return `num` / `den`, rounded to `n_digits` number of fractional digits"
@@ -189,6 +280,109 @@ PyDoc_STRVAR(
     "Returns the `Fraction` with the smallest positive denominator, whose\n"
     "ratio is equal to `self`.\n\n");
 
+PyDoc_STRVAR(
+    Rational_hex_doc,
+    "Return the hexadecimal representation of `self`.\n\n"
+    "Returns:\n"
+    "    str: literal of the form [-]0x1[.<hex>]p<+|-><dec>, normalized like "
+    "the\n    output of :meth:`float.hex`, but without trailing zeros "
+    "(or \"0x0p+0\")\n\n"
+    "Raises:\n"
+    "    ValueError: the denominator of `self` is not a power of 2.\n\n"
+    "Example:\n"
+    "    >>> Rational(3, 16).hex()\n"
+    "    '0x1.8p-3'\n\n"
+);
+
+PyDoc_STRVAR(
+    Rational_sort_key_doc,
+    "Return a binary key preserving the numeric order.\n\n"
+    "Comparing the keys of two :class:`Rational` instances bytewise (like "
+    "`memcmp`,\nor the comparison of `bytes` objects) gives the same result "
+    "as comparing\nthe instances, so the keys can be used in indexes of "
+    "databases or\nkey-value stores.\n\n"
+    "The key starts with a sign byte (0x01, 0x02 or 0x03 for negative values, "
+    "0\nand positive values), followed by the magnitude of `self` in base 100 "
+    "and up\nto 20 base-100 digits. The rest of non-terminating values is "
+    "appended as\ncontinued fraction, so that the key always represents "
+    "`self` exactly.\n\n"
+    "Returns:\n"
+    "    bytes: sort key of `self`\n\n"
+    "Raises:\n"
+    "    ValueError: `self` is not a decimal value and its absolute value is\n"
+    "        not within [100 ^ -65536, 100 ^ 65537)\n\n"
+    "Example:\n"
+    "    >>> Rational('-1.5').sort_key() < Rational(1, 3).sort_key()\n"
+    "    True\n"
+    "    >>> Rational('12.5').sort_key()\n"
+    "    b'\\x03\\x80\\x0e4\\x00'\n\n"
+);
+
+PyDoc_STRVAR(
+    Rational_to_decimal_str_doc,
+    "to_decimal_str(max_digits=None)\n\n"
+    "Return the exact decimal expansion of `self`.\n\n"
+    "Args:\n"
+    "    max_digits (Optional[numbers.Integral]): max number of fractional\n"
+    "        digits (non-repeating plus repeating ones) (default: None)\n\n"
+    "Returns:\n"
+    "    str: literal of the form [-]<int>[.<digits>[(<digits>)]], where the\n"
+    "        digits in parentheses repeat infinitely\n\n"
+    "Raises:\n"
+    "    ValueError: the expansion of `self` has more than `max_digits`\n"
+    "        fractional digits\n"
+    "    MemoryError: the expansion of `self` is too long to be generated\n\n"
+    "Example:\n"
+    "    >>> Rational(1, 6).to_decimal_str()\n"
+    "    '0.1(6)'\n\n"
+);
+
+PyDoc_STRVAR(
+    Rational_to_sci_str_doc,
+    "to_sci_str(engineering=False)\n\n"
+    "Return the exact representation of `self` in exponent notation.\n\n"
+    "Args:\n"
+    "    engineering (bool): use engineering notation, i.e. an exponent "
+    "being a\n        multiple of 3, instead of scientific notation "
+    "(default: False)\n\n"
+    "Returns:\n"
+    "    str: literal of the form [-]<int>[.<frac>]e<+|-><exp>, holding all\n"
+    "        significant digits of `self`\n\n"
+    "Raises:\n"
+    "    ValueError: `self` has no finite decimal representation\n\n"
+    "Example:\n"
+    "    >>> Rational('-12345e30').to_sci_str()\n"
+    "    '-1.2345e+34'\n"
+    "    >>> Rational('-12345e30').to_sci_str(engineering=True)\n"
+    "    '-12.345e+33'\n\n"
+);
+
+PyDoc_STRVAR(
+    Rational_write_into_doc,
+    "write_into(buffer, offset=0)\n\n"
+    "Write the representation of `self` as ASCII chars into `buffer`.\n\n"
+    "The chars are the same as given by `bytes(self)`; they are written to\n"
+    "`buffer[offset:]` without creating intermediate objects (except for\n"
+    "quotients of very large ints).\n\n"
+    "Args:\n"
+    "    buffer: writable bytes-like object, e.g. `bytearray` or a writable\n"
+    "        `memoryview`\n"
+    "    offset (int): position in `buffer` where to start writing\n"
+    "        (default: 0)\n\n"
+    "Returns:\n"
+    "    int: position in `buffer` following the chars written\n\n"
+    "Raises:\n"
+    "    TypeError: `buffer` is not a writable bytes-like object\n"
+    "    BufferError: `buffer` is not C-contiguous\n"
+    "    ValueError: `offset` is negative or `buffer` is too small\n\n"
+    "Example:\n"
+    "    >>> buf = bytearray(8)\n"
+    "    >>> Rational('-1.25').write_into(buf, 1)\n"
+    "    6\n"
+    "    >>> buf\n"
+    "    bytearray(b'\\x00-1.25\\x00\\x00')\n\n"
+);
+
 PyDoc_STRVAR(
     Rational_as_integer_ratio_doc,
     "Return a pair of integers whose ratio is equal to `self`.\n\n"
@@ -219,7 +413,24 @@ PyDoc_STRVAR(
     "Args:\n"
     "    fmt_spec (str): a standard format specifier for a number\n\n"
     "Returns:\n"
-    "    str: `self` converted to a string according to `fmt_spec`\n\n");
+    "    str: `self` converted to a string according to `fmt_spec`\n\n"
+    "Supported are fill, align, sign, 'z', '#', '0', width, grouping "
+    "(',' or '_')\n"
+    "and precision, together with the types 'e', 'E', 'f', 'F', 'g', 'G' "
+    "and '%'.\n"
+    "The value is rounded using the current default rounding mode.\n\n"
+    "If no precision is given, values representable as fixed-point "
+    "decimal are\n"
+    "formatted with all of their digits, all other values with 6 digits.\n"
+    "Without type, but with precision, the result is the same as for type "
+    "'f'.\n"
+    "Without type and precision, the chars of str(self) - subject to the "
+    "policy\n"
+    "set by :func:`set_str_policy` - are laid out according to fill, "
+    "align,\n"
+    "sign, '#', '0', width and grouping.\n\n"
+    "Raises:\n"
+    "    ValueError: `fmt_spec` is invalid or names an unsupported type.\n\n");
 
 PyDoc_STRVAR(
     Rational_trunc_doc,
@@ -241,4 +452,92 @@ PyDoc_STRVAR(
     "This method is called by the built-in `round` function. It returns an\n"
     "`int` when called with one argument, otherwise a :class:`Rational`.\n\n");
 
+PyDoc_STRVAR(
+    ParserType_doc,
+    "Incremental parser of ascii literals received in chunks.\n\n"
+    "The literals, separated by ascii whitespace, are passed to the parser "
+    "as a\nsequence of bytes-like objects. A literal may be split across "
+    "chunks at any\nposition.\n\n"
+    "Example:\n"
+    "    >>> p = Parser()\n"
+    "    >>> p.feed(b'1.5 3/')\n"
+    "    [Rational('1.5')]\n"
+    "    >>> p.feed(b'4\\n-7')\n"
+    "    [Rational(3, 4)]\n"
+    "    >>> p.close()\n"
+    "    [Rational(-7)]\n\n");
+
+PyDoc_STRVAR(
+    Parser_feed_doc,
+    "Parse the literals completed by `data`.\n\n"
+    "Args:\n"
+    "    data (bytes-like): next chunk of input\n\n"
+    "Returns:\n"
+    "    list: :class:`Rational` instances derived from the literals "
+    "terminated\n    within `data`\n\n"
+    "Raises:\n"
+    "    TypeError: `data` does not support the buffer protocol.\n"
+    "    ValueError: `data` completes an invalid literal.\n\n"
+    "A literal reaching up to the end of `data` is held back until it is "
+    "terminated\nby a following chunk or the parser is closed.\n\n"
+    "After an invalid literal has been detected, the values derived from "
+    "the\npreceding literals and the input following the invalid literal "
+    "are kept:\nthe next call of :meth:`feed` or :meth:`close` returns these "
+    "values and\nresumes parsing after the invalid literal.\n");
+
+PyDoc_STRVAR(
+    Parser_close_doc,
+    "Parse the literal held back, if any, and reset the parser.\n\n"
+    "Returns:\n"
+    "    list: the :class:`Rational` derived from the pending literal, or "
+    "an\n    empty list\n\n"
+    "Raises:\n"
+    "    ValueError: the input held back holds an invalid literal.\n\n"
+    "The values kept after an invalid literal has been detected by the "
+    "last call\nof :meth:`feed` are returned in front of the pending one, "
+    "and the input\nfollowing the invalid literal is parsed.\n");
+
+PyDoc_STRVAR(
+    Parser_pending_doc,
+    "The literal held back, waiting to be completed (or the input "
+    "following an\ninvalid literal, waiting to be parsed).");
+
+// Module functions
+
+PyDoc_STRVAR(
+    rational_get_str_policy_doc,
+    "Return the policy applied when converting a :class:`Rational` to a "
+    "string.\n\n"
+    "Returns:\n"
+    "    tuple: (sci_threshold, engineering), see :func:`set_str_policy`\n");
+
+PyDoc_STRVAR(
+    rational_set_str_policy_doc,
+    "set_str_policy(sci_threshold=None, engineering=False)\n\n"
+    "Set the policy applied when converting a :class:`Rational` to a "
+    "string.\n\n"
+    "Args:\n"
+    "    sci_threshold (Optional[int]): max number of digits of the "
+    "positional\n        representation of decimal values; values needing "
+    "more digits\n        are given in exponent notation by str, repr, "
+    "bytes and format\n        without type and precision (default: None, "
+    "i.e. always use\n        positional notation)\n"
+    "    engineering (bool): use engineering notation instead of "
+    "scientific\n        notation (default: False)\n\n"
+    "Returns:\n"
+    "    tuple: the previous policy (sci_threshold, engineering)\n\n"
+    "Raises:\n"
+    "    TypeError: `sci_threshold` is neither an int (other than a bool) "
+    "nor None\n"
+    "    ValueError: `sci_threshold` is < 1\n\n"
+    "The policy applies to the whole process (not only to the current "
+    "thread or\ncontext). Quotients without finite decimal representation "
+    "are not affected.\n\n"
+    "Example:\n"
+    "    >>> prev = set_str_policy(12)\n"
+    "    >>> str(Rational('1.5e30')), str(Rational('123.45'))\n"
+    "    ('1.5e+30', '123.45')\n"
+    "    >>> prev = set_str_policy(*prev)\n\n"
+);
+
 #endif //RATIONAL_DOCSTRINGS_H
@@ -0,0 +1,492 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Formatting of rational numbers according to the standard format
+ * specification mini-language:
+ * [[<fill>]<align>][<sign>][z][#][0][<width>][<grouping>][.<precision>][<type>]
+ * with <type> being one of 'e', 'E', 'f', 'F', 'g', 'G', '%' or omitted.
+ *
+ * The caller rounds the value as needed and hands its absolute value over
+ * as a string of decimal digits and an exponent; the functions here only
+ * lay out the chars. */
+
+#ifndef RATIONAL_FORMAT_SPEC_H
+#define RATIONAL_FORMAT_SPEC_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "librational.h"
+#include "rn_fpdec.h"
+
+// max value of width and precision
+#define RN_FMT_MAX_N ((size_t)INT32_MAX)
+
+// precision not given
+#define RN_FMT_UNDEF_PREC SIZE_MAX
+
+// default precision for values without a finite decimal representation
+#define RN_FMT_DFLT_PREC 6
+
+struct rn_format_spec {
+    char fill[4];           // utf-8 encoded fill char
+    unsigned n_fill_bytes;
+    char align;             // one of '<', '>', '^', '='
+    char sign;              // one of '-', '+', ' '
+    bool no_neg_zero;       // format negative zero without sign
+    bool alternate;         // always write a decimal point
+    bool zero_pad;          // pad with zeros taking part in grouping
+    char thousands_sep;     // ',', '_' or 0
+    size_t min_width;
+    size_t prec;            // RN_FMT_UNDEF_PREC if not given
+    char type;              // one of 'e', 'E', 'f', 'F', 'g', 'G', '%' or 0
+};
+
+static inline bool
+rn_fmt_is_align(uint32_t ch) {
+    return ch == '<' || ch == '>' || ch == '^' || ch == '=';
+}
+
+static inline rn_error_t
+rn_fmt_parse_size(size_t *res, const uint32_t **cp, const uint32_t *end) {
+    size_t n = 0;
+
+    for (; *cp < end && **cp - '0' < 10U; ++*cp) {
+        n = n * 10 + (**cp - '0');
+        if (n > RN_FMT_MAX_N)
+            return RN_LIMIT_EXCEEDED;
+    }
+    *res = n;
+    return RN_OK;
+}
+
+// Parse the format specification given as ucs4 chars. Returns
+// RN_INVALID_LITERAL if it is malformed or names an unsupported type, and
+// RN_LIMIT_EXCEEDED if width or precision exceed RN_FMT_MAX_N.
+static inline rn_error_t
+rn_parse_format_spec(struct rn_format_spec *spec, const uint32_t *fmt,
+                     size_t len) {
+    const uint32_t *cp = fmt;
+    const uint32_t *end = fmt + len;
+    uint32_t fill = ' ';
+    bool fill_given = false;
+    bool zero_flag = false;
+    rn_error_t rc;
+
+// current char, 0 at the end of the specification
+#define CH ((uint32_t)(cp < end ? *cp : 0U))
+
+    spec->align = 0;
+    spec->sign = '-';
+    spec->no_neg_zero = false;
+    spec->alternate = false;
+    spec->zero_pad = false;
+    spec->thousands_sep = 0;
+    spec->min_width = 0;
+    spec->prec = RN_FMT_UNDEF_PREC;
+    spec->type = 0;
+
+    if (len >= 2 && rn_fmt_is_align(fmt[1])) {
+        fill = fmt[0];
+        fill_given = true;
+        spec->align = (char)fmt[1];
+        cp += 2;
+    }
+    else if (rn_fmt_is_align(CH)) {
+        spec->align = (char)CH;
+        ++cp;
+    }
+    switch (CH) {
+        case '+':
+        case '-':
+        case ' ':
+            spec->sign = (char)*cp++;
+    }
+    if (CH == 'z') {
+        spec->no_neg_zero = true;
+        ++cp;
+    }
+    if (CH == '#') {
+        spec->alternate = true;
+        ++cp;
+    }
+    if (CH == '0') {
+        zero_flag = true;
+        ++cp;
+    }
+    if ((rc = rn_fmt_parse_size(&spec->min_width, &cp, end)) != RN_OK)
+        return rc;
+    if (CH == ',' || CH == '_')
+        spec->thousands_sep = (char)*cp++;
+    if (CH == '.') {
+        ++cp;
+        if (CH - '0' >= 10U)
+            return RN_INVALID_LITERAL;
+        if ((rc = rn_fmt_parse_size(&spec->prec, &cp, end)) != RN_OK)
+            return rc;
+    }
+    switch (CH) {
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case '%':
+            spec->type = (char)*cp++;
+    }
+    if (cp != end)
+        return RN_INVALID_LITERAL;
+
+    if (zero_flag && !fill_given) {
+        fill = '0';
+        if (spec->align == 0) {
+            spec->align = '=';
+            spec->zero_pad = true;
+        }
+    }
+    if (spec->align == 0)
+        spec->align = '>';
+
+    // encode fill as utf-8
+    if (fill < 0x80) {
+        spec->fill[0] = (char)fill;
+        spec->n_fill_bytes = 1;
+    }
+    else if (fill < 0x800) {
+        spec->fill[0] = (char)(0xc0 | (fill >> 6));
+        spec->fill[1] = (char)(0x80 | (fill & 0x3f));
+        spec->n_fill_bytes = 2;
+    }
+    else if (fill < 0x10000) {
+        spec->fill[0] = (char)(0xe0 | (fill >> 12));
+        spec->fill[1] = (char)(0x80 | ((fill >> 6) & 0x3f));
+        spec->fill[2] = (char)(0x80 | (fill & 0x3f));
+        spec->n_fill_bytes = 3;
+    }
+    else {
+        spec->fill[0] = (char)(0xf0 | (fill >> 18));
+        spec->fill[1] = (char)(0x80 | ((fill >> 12) & 0x3f));
+        spec->fill[2] = (char)(0x80 | ((fill >> 6) & 0x3f));
+        spec->fill[3] = (char)(0x80 | (fill & 0x3f));
+        spec->n_fill_bytes = 4;
+    }
+    return RN_OK;
+
+#undef CH
+}
+
+// Write the decimal digits of x to buf, which must have room for
+// UINT128_10_POW_N_CUTOFF + 1 chars. Returns the number of digits written.
+static inline size_t
+u128_to_dec_digits(char *buf, uint128_t x) {
+    size_t n_digits = U128_EQ_ZERO(x) ? 1 : u128_magnitude(x) + 1;
+    char *cp = buf + n_digits;
+
+    // the digits are generated from right to left
+    do {
+        *(--cp) = (char)('0' + u128_idiv_10(&x));
+    } while (U128_NE_ZERO(x));
+    assert(cp == buf);
+    return n_digits;
+}
+
+// Upper limit of the number of chars written by rn_format_dec
+static inline size_t
+rn_format_dec_max_n_chars(size_t n_digits, int64_t exp, size_t prec) {
+    return n_digits + (size_t)(exp < 0 ? -exp : exp) + prec + 32;
+}
+
+// Digit at position k, i.e. the factor of 10 ^ k, of digits * 10 ^ exp
+static inline char
+rn_fmt_digit_at(const char *digits, size_t n_digits, int64_t exp,
+                int64_t k) {
+    int64_t i = (int64_t)n_digits - 1 - (k - exp);
+    return i >= 0 && i < (int64_t)n_digits ? digits[i] : '0';
+}
+
+static inline char *
+rn_fmt_write_fixed(char *cp, const char *digits, size_t n_digits,
+                   int64_t exp, size_t n_frac_digits, bool alternate) {
+    int64_t k = (int64_t)n_digits - 1 + exp;
+
+    for (k = k < 0 ? 0 : k; k >= 0; --k)
+        *cp++ = rn_fmt_digit_at(digits, n_digits, exp, k);
+    if (n_frac_digits > 0 || alternate)
+        *cp++ = '.';
+    for (k = -1; k >= -(int64_t)n_frac_digits; --k)
+        *cp++ = rn_fmt_digit_at(digits, n_digits, exp, k);
+    return cp;
+}
+
+// Write the leading digit, followed by n_frac_digits digits after the
+// decimal point. Surplus digits are zeros left over from rounding up.
+static inline char *
+rn_fmt_write_mantissa(char *cp, const char *digits, size_t n_digits,
+                      size_t n_frac_digits, bool alternate) {
+    *cp++ = digits[0];
+    if (n_frac_digits > 0 || alternate)
+        *cp++ = '.';
+    for (size_t i = 1; i <= n_frac_digits; ++i)
+        *cp++ = i < n_digits ? digits[i] : '0';
+    return cp;
+}
+
+static inline char *
+rn_fmt_write_exp(char *cp, char exp_char, int64_t exp) {
+    char exp_digits[20];
+    char *dp = exp_digits + sizeof(exp_digits);
+    uint64_t u_exp = (uint64_t)(exp < 0 ? -exp : exp);
+
+    *cp++ = exp_char;
+    *cp++ = exp < 0 ? '-' : '+';
+    // at least two digits, generated from right to left
+    do {
+        *(--dp) = (char)('0' + u_exp % 10);
+        u_exp /= 10;
+    } while (u_exp > 0 || dp > exp_digits + sizeof(exp_digits) - 2);
+    while (dp < exp_digits + sizeof(exp_digits))
+        *cp++ = *dp++;
+    return cp;
+}
+
+// Remove trailing zeros after the decimal point and the decimal point
+// itself, if no digits are left after it.
+static inline char *
+rn_fmt_strip_frac_zeros(char *start, char *cp) {
+    if (memchr(start, '.', (size_t)(cp - start)) == NULL)
+        return cp;
+    while (cp[-1] == '0')
+        --cp;
+    if (cp[-1] == '.')
+        --cp;
+    return cp;
+}
+
+// Write abs(value) = digits * 10 ^ exp to buf, formatted according to type
+// ('e', 'E', 'f', 'F', 'g', 'G' or '%') and prec, which must not be
+// RN_FMT_UNDEF_PREC. For type '%', exp must already include the factor 100.
+// The value must already be rounded to the number of digits to be written,
+// and digits must not have leading zeros, except for zero being given as
+// "0". buf must have room for rn_format_dec_max_n_chars(n_digits, exp,
+// prec) chars. Returns the number of chars written; no terminating 0 is
+// added.
+static inline size_t
+rn_format_dec(char *buf, char type, size_t prec, bool alternate,
+              const char *digits, size_t n_digits, int64_t exp) {
+    bool is_zero = n_digits == 1 && digits[0] == '0';
+    // position of the leading digit
+    int64_t magn = is_zero ? 0 : (int64_t)n_digits - 1 + exp;
+    char *cp = buf;
+
+    assert(prec != RN_FMT_UNDEF_PREC);
+    if (is_zero)
+        exp = 0;
+    switch (type) {
+        case 'e':
+        case 'E':
+            cp = rn_fmt_write_mantissa(cp, digits, n_digits, prec, alternate);
+            cp = rn_fmt_write_exp(cp, type, magn);
+            break;
+        case 'g':
+        case 'G':
+            if (prec == 0)
+                prec = 1;
+            if (magn >= -4 && magn < (int64_t)prec) {
+                cp = rn_fmt_write_fixed(cp, digits, n_digits, exp,
+                                        (size_t)((int64_t)prec - 1 - magn),
+                                        alternate);
+                if (!alternate)
+                    cp = rn_fmt_strip_frac_zeros(buf, cp);
+            }
+            else {
+                cp = rn_fmt_write_mantissa(cp, digits, n_digits, prec - 1,
+                                           alternate);
+                if (!alternate)
+                    cp = rn_fmt_strip_frac_zeros(buf, cp);
+                cp = rn_fmt_write_exp(cp, type == 'g' ? 'e' : 'E', magn);
+            }
+            break;
+        default:
+            cp = rn_fmt_write_fixed(cp, digits, n_digits, exp, prec,
+                                    alternate);
+            if (type == '%')
+                *cp++ = '%';
+            break;
+    }
+    return (size_t)(cp - buf);
+}
+
+// Upper limit of the number of chars written by rn_format_sci
+static inline size_t
+rn_format_sci_max_n_chars(size_t n_digits) {
+    return n_digits + 32;
+}
+
+// Write (-1) ^ neg * digits * 10 ^ exp to buf in exponent notation, keeping
+// all digits: scientific notation has one integral digit, engineering
+// notation has one to three, so that the exponent is a multiple of 3.
+// digits must have neither leading nor trailing zeros, except for zero being
+// given as "0". buf must have room for rn_format_sci_max_n_chars(n_digits)
+// chars. Returns the number of chars written; no terminating 0 is added.
+static inline size_t
+rn_format_sci(char *buf, bool neg, bool engineering, const char *digits,
+              size_t n_digits, int64_t exp) {
+    bool is_zero = n_digits == 1 && digits[0] == '0';
+    // position of the leading digit
+    int64_t magn = is_zero ? 0 : (int64_t)n_digits - 1 + exp;
+    int64_t sci_exp = magn;
+    size_t n_int_digits = 1;
+    char *cp = buf;
+
+    if (engineering) {
+        // round magn down to a multiple of 3
+        sci_exp = magn >= 0 ? magn / 3 * 3 : -((2 - magn) / 3 * 3);
+        n_int_digits += (size_t)(magn - sci_exp);
+    }
+    if (neg)
+        *cp++ = '-';
+    for (size_t i = 0; i < n_int_digits; ++i)
+        *cp++ = i < n_digits ? digits[i] : '0';
+    if (n_digits > n_int_digits) {
+        *cp++ = '.';
+        for (size_t i = n_int_digits; i < n_digits; ++i)
+            *cp++ = digits[i];
+    }
+    cp = rn_fmt_write_exp(cp, 'e', sci_exp);
+    return (size_t)(cp - buf);
+}
+
+static inline size_t
+rn_fmt_n_grouped(size_t n_digits, char thousands_sep) {
+    return n_digits + (thousands_sep && n_digits > 0 ?
+                       (n_digits - 1) / 3 : 0);
+}
+
+// Layout of a formatted number: [fill][sign][fill][zeros]<body>[fill]
+struct rn_fmt_layout {
+    size_t n_zeros;         // zeros prepended to the integral digits
+    size_t n_left_fill;     // fill chars before the sign
+    size_t n_inner_fill;    // fill chars between sign and body
+    size_t n_right_fill;
+    size_t n_bytes;         // total number of bytes to be written
+};
+
+// Compute the layout of sign and body according to spec. Thousands
+// separators go into each run of digits at the start of body or following
+// a '/', i.e. into the integral digits.
+static inline void
+rn_fmt_get_layout(struct rn_fmt_layout *layout,
+                  const struct rn_format_spec *spec, char sign,
+                  const char *body, size_t n_body) {
+    size_t n_first_run = 0;
+    size_t n_chars = n_body + (sign != 0);
+    size_t n_pad;
+    const char *cp = body;
+    const char *end = body + n_body;
+
+    layout->n_zeros = 0;
+    layout->n_left_fill = 0;
+    layout->n_inner_fill = 0;
+    layout->n_right_fill = 0;
+    while (cp < end) {
+        const char *run = cp;
+        for (; cp < end && (unsigned)(*cp - '0') < 10U; ++cp);
+        if (run == body)
+            n_first_run = (size_t)(cp - run);
+        n_chars += rn_fmt_n_grouped((size_t)(cp - run),
+                                    spec->thousands_sep) -
+                   (size_t)(cp - run);
+        // skip to the next integral digits
+        for (; cp < end && *cp != '/'; ++cp);
+        if (cp < end)
+            ++cp;
+    }
+    if (spec->zero_pad && n_chars < spec->min_width) {
+        size_t n_other = n_chars -
+                         rn_fmt_n_grouped(n_first_run, spec->thousands_sep);
+        size_t n_digits = n_first_run;
+        while (n_other + rn_fmt_n_grouped(n_digits, spec->thousands_sep) <
+               spec->min_width)
+            ++n_digits;
+        layout->n_zeros = n_digits - n_first_run;
+        n_chars = n_other + rn_fmt_n_grouped(n_digits, spec->thousands_sep);
+    }
+    n_pad = n_chars < spec->min_width ? spec->min_width - n_chars : 0;
+    switch (spec->align) {
+        case '<':
+            layout->n_right_fill = n_pad;
+            break;
+        case '^':
+            layout->n_left_fill = n_pad / 2;
+            layout->n_right_fill = n_pad - n_pad / 2;
+            break;
+        case '=':
+            layout->n_inner_fill = n_pad;
+            break;
+        default:
+            layout->n_left_fill = n_pad;
+            break;
+    }
+    layout->n_bytes = n_chars + n_pad * spec->n_fill_bytes;
+}
+
+static inline char *
+rn_fmt_write_fill(char *cp, const struct rn_format_spec *spec, size_t n) {
+    for (; n > 0; --n) {
+        memcpy(cp, spec->fill, spec->n_fill_bytes);
+        cp += spec->n_fill_bytes;
+    }
+    return cp;
+}
+
+// Write sign and body to buf, arranged according to layout, which must have
+// been computed by rn_fmt_get_layout for the same arguments. buf must have
+// room for layout->n_bytes chars. Returns the number of chars written; no
+// terminating 0 is added.
+static inline size_t
+rn_fmt_write_layout(char *buf, const struct rn_fmt_layout *layout,
+                    const struct rn_format_spec *spec, char sign,
+                    const char *body, size_t n_body) {
+    const char *end = body + n_body;
+    const char *bp = body;
+    size_t n_zeros = layout->n_zeros;
+    char *cp = buf;
+
+    cp = rn_fmt_write_fill(cp, spec, layout->n_left_fill);
+    if (sign != 0)
+        *cp++ = sign;
+    cp = rn_fmt_write_fill(cp, spec, layout->n_inner_fill);
+    while (bp < end) {
+        const char *run = bp;
+        size_t n_digits;
+        for (; bp < end && (unsigned)(*bp - '0') < 10U; ++bp);
+        n_digits = (size_t)(bp - run) + n_zeros;
+        for (size_t i = 0; i < n_digits; ++i) {
+            if (i > 0 && spec->thousands_sep && (n_digits - i) % 3 == 0)
+                *cp++ = spec->thousands_sep;
+            *cp++ = i < n_zeros ? '0' : run[i - n_zeros];
+        }
+        n_zeros = 0;
+        // copy up to the next integral digits
+        for (; bp < end && *bp != '/'; ++bp)
+            *cp++ = *bp;
+        if (bp < end)
+            *cp++ = *bp++;
+    }
+    cp = rn_fmt_write_fill(cp, spec, layout->n_right_fill);
+    assert((size_t)(cp - buf) == layout->n_bytes);
+    return (size_t)(cp - buf);
+}
+
+#endif //RATIONAL_FORMAT_SPEC_H
@@ -0,0 +1,274 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Hexadecimal literals of binary fractions, as produced by float.hex:
+ * [+|-][0x|0X]<hex>[.<hex>][<p|P>[+|-]<dec>]
+ * denoting <hex>.<hex> * 2 ^ <dec>. */
+
+#ifndef RATIONAL_HEX_LITERAL_H
+#define RATIONAL_HEX_LITERAL_H
+
+#include <assert.h>
+
+#include "parse.h"
+
+// max number of hex digits held in a uint128_t
+#define RN_HEX_N_DIGITS_CUTOFF 32
+
+// max number of chars written by rn_hex_to_chars, including the
+// terminating 0
+#define RN_HEX_MAX_N_CHARS 64
+
+// (-1) ^ neg * <significant digits> * 2 ^ (exp - sig_shift), where
+// <significant digits> is the value of the hex digits without leading and
+// trailing zeros and sig_shift is the number of its trailing zero bits.
+struct rn_parsed_hex_repr {
+    bool neg;
+    int64_t exp;
+    unsigned sig_shift;
+    size_t n_digits;
+    uint128_t sig;          // significant digits >> sig_shift, only set if
+                            // n_digits <= RN_HEX_N_DIGITS_CUTOFF
+};
+
+static inline int
+map_ascii_to_hex_digit(uint32_t uch) {
+    uint32_t d = uch - '0';
+    if (d < 10)
+        return (int)d;
+    d = (uch | 0x20U) - 'a';
+    if (d < 6)
+        return (int)d + 10;
+    return -1;
+}
+
+// Parse a hexadecimal literal given as ucs4 chars, optionally surrounded by
+// whitespace. The significant hex digits are written, followed by a
+// terminating 0, to digits, which must provide room for len + 1 chars.
+static inline rn_error_t
+rn_from_hex_literal(struct rn_parsed_hex_repr *parsed, char *digits,
+                    const uint32_t *literal, size_t len) {
+    const uint32_t *cp = literal;
+    const uint32_t *end = literal + len;
+    char *out = digits;
+    int64_t i64_accu;
+    int64_t n_zeros = 0;
+    int64_t n_frac_digits = 0;
+    bool has_digits = false;
+    int last_digit = 0;
+    int d;
+
+// current char, 0 at the end of the literal
+#define CH ((uint32_t)(cp < end ? *cp : 0U))
+// Add digit to digits. Zeros are held back until a non-zero digit follows,
+// so that leading zeros are dropped and trailing zeros end up in the
+// exponent.
+#define PUSH_DIGIT(d) \
+    do { \
+        if ((d) == 0) { \
+            if (out != digits) \
+                ++n_zeros; \
+        } \
+        else { \
+            for (; n_zeros > 0; --n_zeros) \
+                *out++ = '0'; \
+            *out++ = (char)*cp; \
+            last_digit = (d); \
+        } \
+        has_digits = true; \
+    } while (0)
+
+    for (; cp < end && rn_is_space(*cp); ++cp);
+    parsed->neg = false;
+    switch (CH) {
+        case '-':
+            parsed->neg = true;
+            FALLTHROUGH;
+        case '+':
+            ++cp;
+    }
+    if (CH == '0' && cp + 1 < end && (cp[1] | 0x20U) == 'x')
+        cp += 2;
+    for (; cp < end && (d = map_ascii_to_hex_digit(*cp)) >= 0; ++cp)
+        PUSH_DIGIT(d);
+    if (CH == '.') {
+        for (++cp; cp < end && (d = map_ascii_to_hex_digit(*cp)) >= 0; ++cp) {
+            PUSH_DIGIT(d);
+            ++n_frac_digits;
+        }
+    }
+    if (!has_digits)
+        return invalid_literal();
+    i64_accu = 0;
+    if (CH == 'p' || CH == 'P') {
+        bool neg_exp = false;
+        ++cp;
+        switch (CH) {
+            case '-':
+                neg_exp = true;
+                FALLTHROUGH;
+            case '+':
+                ++cp;
+        }
+        if (cp == end || (d = map_ascii_to_dec_digit(*cp)) < 0)
+            return invalid_literal();
+        do {
+            i64_accu = i64_accu * 10 + d;
+            if (i64_accu > RN_BIG_MAX_EXP)
+                // exp overflowed, so give up
+                return RN_LIMIT_EXCEEDED;
+            ++cp;
+        } while (cp < end && (d = map_ascii_to_dec_digit(*cp)) >= 0);
+        if (neg_exp)
+            i64_accu = -i64_accu;
+    }
+    for (; cp < end && rn_is_space(*cp); ++cp);
+    if (cp != end)
+        return invalid_literal();
+
+    *out = 0;
+    parsed->n_digits = (size_t)(out - digits);
+    if (parsed->n_digits == 0) {
+        // zero
+        parsed->sig_shift = 0;
+        parsed->exp = 0;
+        parsed->sig = UINT128_ZERO;
+        return RN_OK;
+    }
+    parsed->sig_shift = u64_n_trailing_0_bits((uint64_t)last_digit);
+    parsed->exp = i64_accu + 4 * (n_zeros - n_frac_digits) +
+                  parsed->sig_shift;
+    if (parsed->n_digits <= RN_HEX_N_DIGITS_CUTOFF) {
+        uint128_t sig = UINT128_ZERO;
+        for (const char *dp = digits; *dp != 0; ++dp) {
+            sig = u128_shift_left(&sig, 4);
+            u128_iadd_u64(&sig, (uint64_t)map_ascii_to_hex_digit(*dp));
+        }
+        parsed->sig = u128_shift_right(&sig, parsed->sig_shift);
+    }
+    return RN_OK;
+
+#undef CH
+#undef PUSH_DIGIT
+}
+
+static inline unsigned
+u128_n_signif_bits(const uint128_t *x) {
+    if (U128P_HI(x) != 0)
+        return 128 - u64_n_leading_0_bits(U128P_HI(x));
+    return 64 - u64_n_leading_0_bits(U128P_LO(x));
+}
+
+// Convert a parsed hex literal to the representation of a parsed decimal
+// literal, i.e. to a decimal integer or a quotient of decimal integers.
+// Returns RN_LIMIT_EXCEEDED if the values do not fit into 128 bits.
+static inline rn_error_t
+rn_parsed_hex_to_repr(struct rn_parsed_repr *parsed,
+                      const struct rn_parsed_hex_repr *hex) {
+    uint128_t coeff;
+    unsigned n_bits;
+
+    if (hex->n_digits > RN_HEX_N_DIGITS_CUTOFF)
+        return RN_LIMIT_EXCEEDED;
+    parsed->neg = hex->neg;
+    parsed->is_quot = false;
+    parsed->exp = 0;
+    parsed->coeff = hex->sig;
+    if (hex->n_digits == 0)
+        return RN_OK;
+    n_bits = u128_n_signif_bits(&hex->sig);
+    if (hex->exp >= 0) {
+        if (hex->exp > 128 - n_bits)
+            return RN_LIMIT_EXCEEDED;
+        coeff = hex->sig;
+        for (int64_t n = hex->exp; n > 0; n -= 63)
+            coeff = u128_shift_left(&coeff, (unsigned)(n < 63 ? n : 63));
+        parsed->coeff = coeff;
+    }
+    else {
+        if (hex->exp <= -128)
+            return RN_LIMIT_EXCEEDED;
+        parsed->is_quot = true;
+        parsed->den_exp = 0;
+        if (hex->exp > -64)
+            U128_FROM_LO_HI(&parsed->den_coeff, 1ULL << -hex->exp, 0ULL);
+        else
+            U128_FROM_LO_HI(&parsed->den_coeff, 0ULL,
+                            1ULL << (-hex->exp - 64));
+    }
+    return RN_OK;
+}
+
+// Write the hexadecimal representation of (-1) ^ neg * sig * 2 ^ exp,
+// normalized to a leading digit 1 like the output of float.hex, but without
+// trailing zeros, followed by a terminating 0, to buf, which must have room
+// for RN_HEX_MAX_N_CHARS chars. sig must not be zero. Returns the number of
+// chars written, excluding the terminating 0.
+static inline size_t
+rn_hex_to_chars(char *buf, bool neg, uint128_t sig, int64_t exp) {
+    static const char hex_digits[] = "0123456789abcdef";
+    char frac_digits[RN_HEX_N_DIGITS_CUTOFF];
+    char exp_digits[20];
+    char *dp;
+    uint64_t u_exp;
+    unsigned n_trailing_0_bits;
+    unsigned n_frac_bits;
+    unsigned n_frac_digits;
+    char *cp = buf;
+
+    assert(U128_NE_ZERO(sig));
+    n_trailing_0_bits = U128_LO(sig) != 0 ?
+                        u64_n_trailing_0_bits(U128_LO(sig)) :
+                        64 + u64_n_trailing_0_bits(U128_HI(sig));
+    if (n_trailing_0_bits >= 64) {
+        U128_FROM_LO_HI(&sig, U128_HI(sig), 0ULL);
+        n_trailing_0_bits -= 64;
+        exp += 64;
+    }
+    sig = u128_shift_right(&sig, n_trailing_0_bits);
+    exp += n_trailing_0_bits;
+    // sig = 1.<frac bits> * 2 ^ n_frac_bits
+    n_frac_bits = u128_n_signif_bits(&sig) - 1;
+    exp += n_frac_bits;
+    n_frac_digits = (n_frac_bits + 3) / 4;
+    // align the fraction bits to whole hex digits, dropping the leading 1
+    if (n_frac_bits > 0)
+        sig = u128_shift_left(&sig, 4 * n_frac_digits - n_frac_bits);
+    for (unsigned i = n_frac_digits; i > 0; --i) {
+        frac_digits[i - 1] = hex_digits[U128_LO(sig) & 0xfU];
+        sig = u128_shift_right(&sig, 4);
+    }
+
+    if (neg)
+        *cp++ = '-';
+    *cp++ = '0';
+    *cp++ = 'x';
+    *cp++ = '1';
+    if (n_frac_digits > 0) {
+        *cp++ = '.';
+        for (unsigned i = 0; i < n_frac_digits; ++i)
+            *cp++ = frac_digits[i];
+    }
+    *cp++ = 'p';
+    *cp++ = exp < 0 ? '-' : '+';
+    u_exp = (uint64_t)(exp < 0 ? -exp : exp);
+    // the digits of the exponent are generated from right to left
+    dp = exp_digits + sizeof(exp_digits);
+    do {
+        *(--dp) = (char)('0' + u_exp % 10);
+        u_exp /= 10;
+    } while (u_exp > 0);
+    while (dp < exp_digits + sizeof(exp_digits))
+        *cp++ = *dp++;
+    *cp = 0;
+    return (size_t)(cp - buf);
+}
+
+#endif //RATIONAL_HEX_LITERAL_H
@@ -0,0 +1,239 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "librational.h"
+#include "parse.h"
+#include "rn_fpdec.h"
+#include "rn_u64_quot.h"
+#include "rounding.h"
+
+// Conversion between public and internal representation
+
+static inline uint128_t
+rn_fpdec_coeff(const rn_fpdec_t *x) {
+    uint128_t coeff;
+    U128_FROM_LO_HI(&coeff, x->coeff_lo, x->coeff_hi);
+    return coeff;
+}
+
+static inline void
+rn_fpdec_set_coeff(rn_fpdec_t *x, const uint128_t *coeff) {
+    x->coeff_lo = U128P_LO(coeff);
+    x->coeff_hi = U128P_HI(coeff);
+}
+
+// Parsing
+
+static inline rn_error_t
+rn_parsed_to_public(const struct rn_parsed_repr *parsed, rn_fpdec_t *dec,
+                    rn_quot_t *quot, bool *is_quot) {
+    *is_quot = parsed->is_quot;
+    if (parsed->is_quot) {
+        uint128_t num, den;
+        rn_error_t rc = rn_parsed_quot_to_int(parsed, &num, &den);
+        if (rc != RN_OK)
+            return rc;
+        if (U128_HI(num) != 0 || U128_HI(den) != 0)
+            return RN_LIMIT_EXCEEDED;
+        quot->neg = parsed->neg;
+        quot->num = U128_LO(num);
+        quot->den = U128_LO(den);
+    }
+    else {
+        dec->neg = parsed->neg;
+        dec->exp = parsed->exp;
+        rn_fpdec_set_coeff(dec, &parsed->coeff);
+    }
+    return RN_OK;
+}
+
+rn_error_t
+rn_parse(const char *literal, rn_fpdec_t *dec, rn_quot_t *quot,
+         bool *is_quot) {
+    struct rn_parsed_repr parsed;
+    rn_error_t rc;
+
+    rc = rn_from_ucs1_literal(&parsed, (const uint8_t *)literal,
+                              strlen(literal));
+    if (rc != RN_OK)
+        return rc;
+    return rn_parsed_to_public(&parsed, dec, quot, is_quot);
+}
+
+rn_error_t
+rn_parse_ucs4(const uint32_t *literal, rn_fpdec_t *dec, rn_quot_t *quot,
+              bool *is_quot) {
+    struct rn_parsed_repr parsed;
+    size_t len = 0;
+    rn_error_t rc;
+
+    while (literal[len] != 0)
+        ++len;
+    rc = rn_from_ucs4_literal(&parsed, literal, len);
+    if (rc != RN_OK)
+        return rc;
+    return rn_parsed_to_public(&parsed, dec, quot, is_quot);
+}
+
+// Formatting
+
+size_t
+rn_fpdec_to_chars(char *buf, size_t size, const rn_fpdec_t *x) {
+    uint128_t coeff = rn_fpdec_coeff(x);
+    size_t n_char;
+
+    if (U128_EQ_ZERO(coeff)) {
+        if (size > 1) {
+            buf[0] = '0';
+            buf[1] = 0;
+        }
+        else if (size == 1)
+            buf[0] = 0;
+        return 1;
+    }
+    n_char = rnd_n_chars(x->neg, coeff, x->exp);
+    if (n_char < size)
+        rnd_to_chars(buf, x->neg, coeff, x->exp);
+    else if (size > 0)
+        buf[0] = 0;
+    return n_char;
+}
+
+size_t
+rn_quot_to_chars(char *buf, size_t size, const rn_quot_t *x) {
+    // sign + 2 * 20 digits + '/' + terminating 0
+    char t[43];
+    const char *sign = x->neg && x->num != 0 ? "-" : "";
+    size_t n_char;
+
+    if (x->den == 1)
+        snprintf(t, sizeof(t), "%s%" PRIu64, sign, x->num);
+    else
+        snprintf(t, sizeof(t), "%s%" PRIu64 "/%" PRIu64, sign, x->num,
+                 x->den);
+    n_char = strlen(t);
+    if (n_char < size)
+        memcpy(buf, t, n_char + 1);
+    else if (size > 0)
+        buf[0] = 0;
+    return n_char;
+}
+
+// Conversion
+
+rn_error_t
+rn_fpdec_from_quot(rn_fpdec_t *res, const rn_quot_t *quot) {
+    uint128_t coeff;
+    rn_exp_t exp;
+    rn_quot_t t = *quot;
+    rn_error_t rc;
+
+    rc = rn_quot_reduce(&t);
+    if (rc != RN_OK)
+        return rc;
+    rc = rnd_from_quot(&coeff, &exp, t.num, t.den);
+    if (rc != RN_OK)
+        return rc;
+    res->neg = t.neg;
+    res->exp = exp;
+    rn_fpdec_set_coeff(res, &coeff);
+    return RN_OK;
+}
+
+rn_error_t
+rn_quot_reduce(rn_quot_t *x) {
+    if (x->den == 0)
+        return RN_DIVISION_BY_ZERO;
+    if (x->num == 0)
+        x->den = 1;
+    else
+        rnq_reduce_quot(&x->num, &x->den);
+    return RN_OK;
+}
+
+// Properties
+
+int
+rn_fpdec_magnitude(const rn_fpdec_t *x) {
+    return rnd_magnitude(rn_fpdec_coeff(x), x->exp);
+}
+
+int
+rn_quot_magnitude(const rn_quot_t *x) {
+    return rnq_magnitude(x->num, x->den);
+}
+
+// Comparison
+
+int
+rn_fpdec_cmp(const rn_fpdec_t *x, const rn_fpdec_t *y) {
+    uint128_t x_coeff = rn_fpdec_coeff(x);
+    uint128_t y_coeff = rn_fpdec_coeff(y);
+    rn_sign_t x_sign, y_sign;
+    int x_magn, y_magn;
+
+    x_sign = U128_EQ_ZERO(x_coeff) ? RN_SIGN_ZERO :
+             x->neg ? RN_SIGN_NEG : RN_SIGN_POS;
+    y_sign = U128_EQ_ZERO(y_coeff) ? RN_SIGN_ZERO :
+             y->neg ? RN_SIGN_NEG : RN_SIGN_POS;
+    if (x_sign != y_sign)
+        return x_sign < y_sign ? -1 : 1;
+    if (x_sign == RN_SIGN_ZERO)
+        return 0;
+    x_magn = rnd_magnitude(x_coeff, x->exp);
+    y_magn = rnd_magnitude(y_coeff, y->exp);
+    if (x_magn != y_magn)
+        return x_magn < y_magn ? -x_sign : x_sign;
+    return x_sign * rnd_cmp(x_coeff, x->exp, y_coeff, y->exp);
+}
+
+// Rounding
+
+rn_error_t
+rn_fpdec_adjust(rn_fpdec_t *x, rn_prec_t to_prec,
+                enum RN_ROUNDING_MODE rounding_mode) {
+    uint128_t coeff = rn_fpdec_coeff(x);
+    rn_exp_t exp = x->exp;
+    rn_error_t rc;
+
+    if (U128_EQ_ZERO(coeff))
+        return RN_OK;
+    rc = rnd_adjust_coeff_exp(&coeff, &exp, x->neg, to_prec, rounding_mode);
+    if (rc != RN_OK)
+        return rc;
+    x->exp = exp;
+    rn_fpdec_set_coeff(x, &coeff);
+    return RN_OK;
+}
+
+rn_error_t
+rn_quot_adjust(rn_quot_t *x, rn_prec_t to_prec,
+               enum RN_ROUNDING_MODE rounding_mode) {
+    uint64_t num = x->num;
+    uint64_t den = x->den;
+    rn_error_t rc;
+
+    if (den == 0)
+        return RN_DIVISION_BY_ZERO;
+    if (num == 0) {
+        x->den = 1;
+        return RN_OK;
+    }
+    rc = rnq_adjust_quot(&num, &den, x->neg, to_prec, rounding_mode);
+    if (rc != RN_OK)
+        return rc;
+    x->num = num;
+    x->den = den;
+    return RN_OK;
+}
@@ -0,0 +1,164 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Core of the rational package, usable without Python.
+ *
+ * Provides the two compact representations of the Rational type:
+ *
+ * - fixed-point decimals: (-1) ^ neg * coeff * 10 ^ exp with coeff < 2 ^ 128
+ * - 64-bit quotients: (-1) ^ neg * num / den with num, den < 2 ^ 64
+ *
+ * together with parsing, formatting, conversion, comparison and rounding.
+ * Arithmetic operations (addition, multiplication, ...) are not provided.
+ * All functions report failures by returning one of the error codes defined
+ * below; a result of RN_LIMIT_EXCEEDED means that the result can not be
+ * represented in the requested form, i.e. the caller has to fall back to an
+ * arbitrary precision representation. */
+
+#ifndef RATIONAL_LIBRATIONAL_H
+#define RATIONAL_LIBRATIONAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// sign indicator: 0 -> zero, -1 -> negative, 1 -> positive
+typedef int8_t rn_sign_t;
+#define RN_SIGN_ZERO 0
+#define RN_SIGN_NEG -1
+#define RN_SIGN_POS 1
+
+// exponent of internal representation
+typedef int16_t rn_exp_t;
+#define RN_MAX_EXP INT16_MAX
+#define RN_MIN_EXP (-INT16_MAX)
+#define RN_UNDEF_EXP INT16_MIN
+
+// number of decimal fractional digits
+typedef int16_t rn_prec_t;
+#define RN_UNLIM_PREC INT16_MAX
+#define RN_MAX_PREC 9999
+#define RN_MIN_PREC (-RN_MAX_PREC)
+
+// error codes
+typedef enum {
+    RN_OK = 0,
+    // result not representable as fixed-point decimal or 64-bit quotient
+    RN_LIMIT_EXCEEDED = -1,
+    // string does not represent a rational number
+    RN_INVALID_LITERAL = -2,
+    // denominator is zero
+    RN_DIVISION_BY_ZERO = -3,
+} rn_error_t;
+
+enum RN_ROUNDING_MODE {
+    // Round away from zero if last digit after rounding towards
+    // zero would have been 0 or 5; otherwise round towards zero.
+    RN_ROUND_05UP = 1,
+    // Round towards Infinity.
+    RN_ROUND_CEILING = 2,
+    // Round towards zero.
+    RN_ROUND_DOWN = 3,
+    // Round towards -Infinity.
+    RN_ROUND_FLOOR = 4,
+    // Round to nearest with ties going towards zero.
+    RN_ROUND_HALF_DOWN = 5,
+    // Round to nearest with ties going to nearest even integer.
+    RN_ROUND_HALF_EVEN = 6,
+    // Round to nearest with ties going away from zero.
+    RN_ROUND_HALF_UP = 7,
+    // Round away from zero.
+    RN_ROUND_UP = 8,
+};
+
+// value = (-1) ^ neg * (coeff_hi * 2 ^ 64 + coeff_lo) * 10 ^ exp
+typedef struct rn_fpdec {
+    bool neg;
+    rn_exp_t exp;
+    uint64_t coeff_lo;
+    uint64_t coeff_hi;
+} rn_fpdec_t;
+
+// value = (-1) ^ neg * num / den
+typedef struct rn_quot {
+    bool neg;
+    uint64_t num;
+    uint64_t den;
+} rn_quot_t;
+
+// Parsing
+
+// Parse a Rational literal given as zero-terminated latin-1 string
+// [+|-]<dec>[/<dec>]
+// where <dec> is
+// <int>[.<frac>][<e|E>[+|-]<exp>] or
+// .<frac>[<e|E>[+|-]<exp>],
+// optionally surrounded by whitespace.
+// Depending on the form of the literal, either *dec or *quot is set and
+// *is_quot tells which one. Quotients are scaled to integral numerator and
+// denominator, but not reduced, i.e. "1.5/2" gives 15/20.
+rn_error_t rn_parse(const char *literal, rn_fpdec_t *dec, rn_quot_t *quot,
+                    bool *is_quot);
+
+// Same as rn_parse for a zero-terminated string of unicode code points,
+// accepting non-ascii decimal digits as well.
+rn_error_t rn_parse_ucs4(const uint32_t *literal, rn_fpdec_t *dec,
+                         rn_quot_t *quot, bool *is_quot);
+
+// Formatting
+
+// Write the decimal representation of *x, followed by a terminating 0, to
+// buf. Returns the length of the representation (excluding the terminating
+// 0). If the result is not less than size, nothing is written, except for
+// an empty string in case size > 0.
+size_t rn_fpdec_to_chars(char *buf, size_t size, const rn_fpdec_t *x);
+
+// Write "<num>/<den>" (or "<num>" if den == 1) to buf, as above.
+size_t rn_quot_to_chars(char *buf, size_t size, const rn_quot_t *x);
+
+// Conversion
+
+// Convert *quot to a fixed-point decimal, if it can be represented
+// exactly.
+rn_error_t rn_fpdec_from_quot(rn_fpdec_t *res, const rn_quot_t *quot);
+
+// Reduce *x to lowest terms.
+rn_error_t rn_quot_reduce(rn_quot_t *x);
+
+// Properties
+
+// floor(log10(abs(x))), x must not be zero.
+int rn_fpdec_magnitude(const rn_fpdec_t *x);
+int rn_quot_magnitude(const rn_quot_t *x);
+
+// Comparison
+
+// Returns -1, 0 or 1 depending on x < y, x == y or x > y.
+int rn_fpdec_cmp(const rn_fpdec_t *x, const rn_fpdec_t *y);
+
+// Rounding
+
+// Round *x to to_prec fractional digits.
+rn_error_t rn_fpdec_adjust(rn_fpdec_t *x, rn_prec_t to_prec,
+                           enum RN_ROUNDING_MODE rounding_mode);
+
+// Round *x to to_prec fractional digits; the result is reduced.
+rn_error_t rn_quot_adjust(rn_quot_t *x, rn_prec_t to_prec,
+                          enum RN_ROUNDING_MODE rounding_mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //RATIONAL_LIBRATIONAL_H
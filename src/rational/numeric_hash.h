@@ -0,0 +1,165 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Numeric hashes compatible with those of Python's numeric types.
+ *
+ * The hash of a non-negative rational num / den is num * den ^ -1 mod P,
+ * where P is the prime sys.hash_info.modulus, or sys.hash_info.inf if den
+ * is divisible by P. (For the general rules see the library docs,
+ * 'Built-in Types' / 'Hashing of numeric types'.)
+ *
+ * P is always a Mersenne prime 2 ^ n - 1 (n = 61 on 64-bit platforms), so
+ * reducing modulo P boils down to adding n-bit chunks. */
+
+#ifndef RATIONAL_NUMERIC_HASH_H
+#define RATIONAL_NUMERIC_HASH_H
+
+#include <assert.h>
+
+#include "librational.h"
+#ifdef __SIZEOF_INT128__
+#include "uint128_math_native.h"
+#else
+#include "uint128_math.h"
+#endif // __int128
+
+// powers of 10 (and their inverses) modulo P up to this limit are
+// precomputed
+#define RN_HASH_N_POW10 64
+
+struct rn_hash_params {
+    unsigned n_bits;
+    uint64_t modulus;
+    uint64_t inf;
+    uint64_t pow10[RN_HASH_N_POW10];
+    uint64_t inv_pow10[RN_HASH_N_POW10];
+};
+
+// x mod m, m = 2 ^ n_bits - 1
+static inline uint64_t
+u64_mod_mersenne(uint64_t x, uint64_t m, unsigned n_bits) {
+    x = (x & m) + (x >> n_bits);
+    x = (x & m) + (x >> n_bits);
+    return x >= m ? x - m : x;
+}
+
+// x mod m, m = 2 ^ n_bits - 1
+static inline uint64_t
+u128_mod_mersenne(const uint128_t *x, uint64_t m, unsigned n_bits) {
+    uint128_t t = *x;
+
+    while (U128_HI(t) != 0) {
+        uint64_t lo = U128_LO(t) & m;
+        t = u128_shift_right(&t, n_bits);
+        u128_iadd_u64(&t, lo);
+    }
+    return u64_mod_mersenne(U128_LO(t), m, n_bits);
+}
+
+static inline uint64_t
+rn_hash_mulmod(const struct rn_hash_params *hp, uint64_t x, uint64_t y) {
+    uint128_t t;
+
+    u64_mul_u64(&t, x, y);
+    return u128_mod_mersenne(&t, hp->modulus, hp->n_bits);
+}
+
+static inline uint64_t
+rn_hash_powmod(const struct rn_hash_params *hp, uint64_t base, uint64_t exp) {
+    uint64_t res = 1;
+
+    while (exp > 0) {
+        if (exp & 1U)
+            res = rn_hash_mulmod(hp, res, base);
+        base = rn_hash_mulmod(hp, base, base);
+        exp >>= 1U;
+    }
+    return res;
+}
+
+// Inverse of x modulo P, 0 < x < P (extended Euclidean algorithm)
+static inline uint64_t
+rn_hash_invmod(const struct rn_hash_params *hp, uint64_t x) {
+    uint64_t r = hp->modulus, new_r = x;
+    // |t| and |new_t| stay below P < 2 ^ 63
+    int64_t t = 0, new_t = 1;
+
+    assert(0 < x && x < hp->modulus);
+    while (new_r != 0) {
+        uint64_t q = r / new_r;
+        uint64_t tmp_r = r - q * new_r;
+        int64_t tmp_t = t - (int64_t)q * new_t;
+        r = new_r;
+        new_r = tmp_r;
+        t = new_t;
+        new_t = tmp_t;
+    }
+    assert(r == 1);
+    return t < 0 ? (uint64_t)(t + (int64_t)hp->modulus) : (uint64_t)t;
+}
+
+// Set up the parameters for modulus 2 ^ n_bits - 1, 1 < n_bits < 64
+static inline void
+rn_hash_params_init(struct rn_hash_params *hp, unsigned n_bits,
+                    uint64_t inf) {
+    uint64_t inv10;
+
+    hp->n_bits = n_bits;
+    hp->modulus = (1ULL << n_bits) - 1ULL;
+    hp->inf = inf;
+    inv10 = rn_hash_invmod(hp, 10);
+    hp->pow10[0] = hp->inv_pow10[0] = 1;
+    for (unsigned i = 1; i < RN_HASH_N_POW10; ++i) {
+        hp->pow10[i] = rn_hash_mulmod(hp, hp->pow10[i - 1], 10);
+        hp->inv_pow10[i] = rn_hash_mulmod(hp, hp->inv_pow10[i - 1], inv10);
+    }
+}
+
+// 10 ^ exp mod P
+static inline uint64_t
+rn_hash_pow10(const struct rn_hash_params *hp, int64_t exp) {
+    const uint64_t *tab = exp < 0 ? hp->inv_pow10 : hp->pow10;
+    uint64_t n = exp < 0 ? -(uint64_t)exp : (uint64_t)exp;
+
+    if (n < RN_HASH_N_POW10)
+        return tab[n];
+    return rn_hash_powmod(hp, tab[1], n);
+}
+
+// Hash of coeff * 10 ^ exp
+static inline uint64_t
+rn_hash_fpdec(const struct rn_hash_params *hp, const uint128_t *coeff,
+              int64_t exp) {
+    uint64_t h = u128_mod_mersenne(coeff, hp->modulus, hp->n_bits);
+
+    return exp == 0 ? h : rn_hash_mulmod(hp, h, rn_hash_pow10(hp, exp));
+}
+
+// Hash of h_num / h_den with h_num and h_den being residues modulo P
+static inline uint64_t
+rn_hash_quot_residues(const struct rn_hash_params *hp, uint64_t h_num,
+                      uint64_t h_den) {
+    if (h_den == 0)
+        return hp->inf;
+    if (h_den == 1)
+        return h_num;
+    return rn_hash_mulmod(hp, h_num, rn_hash_invmod(hp, h_den));
+}
+
+// Hash of num / den, den > 0
+static inline uint64_t
+rn_hash_u64_quot(const struct rn_hash_params *hp, uint64_t num,
+                 uint64_t den) {
+    return rn_hash_quot_residues(
+        hp, u64_mod_mersenne(num, hp->modulus, hp->n_bits),
+        u64_mod_mersenne(den, hp->modulus, hp->n_bits));
+}
+
+#endif //RATIONAL_NUMERIC_HASH_H
@@ -11,149 +11,257 @@ $Revision$
 #ifndef RATIONAL_PARSE_H
 #define RATIONAL_PARSE_H
 
-#include <Python.h>
+#include <assert.h>
+#include <string.h>
 #include <wctype.h>
 
-#include "common.h"
+#include "compiler_macros.h"
+#include "librational.h"
 #include "rn_fpdec.h"
 #include "non_ascii_digits.h"
 
+// value = (-1) ^ neg * coeff * 10 ^ exp or, if is_quot,
+// value = (-1) ^ neg * coeff * 10 ^ exp / (den_coeff * 10 ^ den_exp)
 struct rn_parsed_repr {
     bool is_quot;
     bool neg;
     rn_exp_t exp;
     uint128_t coeff;
-    uint64_t num;
-    uint64_t den;
+    rn_exp_t den_exp;
+    uint128_t den_coeff;
 };
 
-static inline error_t
+// Multiply *x > 0 by 10 ^ n, if the result is < 10 ^ UINT128_10_POW_N_CUTOFF
+static inline bool
+u128_checked_imul_10_pow_n(uint128_t *x, int n) {
+    if (u128_magnitude(*x) + n >= UINT128_10_POW_N_CUTOFF)
+        return false;
+    if (n > UINT64_10_POW_N_CUTOFF) {
+        u128_imul_10_pow_n(x, UINT64_10_POW_N_CUTOFF);
+        n -= UINT64_10_POW_N_CUTOFF;
+    }
+    u128_imul_10_pow_n(x, n);
+    return true;
+}
+
+// Scale the parsed quotient to integral numerator and denominator, i.e.
+// num / den = coeff * 10 ^ exp / (den_coeff * 10 ^ den_exp). The quotient
+// is not reduced.
+static inline rn_error_t
+rn_parsed_quot_to_int(const struct rn_parsed_repr *parsed, uint128_t *num,
+                      uint128_t *den) {
+    int exp = parsed->exp - parsed->den_exp;
+
+    assert(parsed->is_quot);
+
+    *num = parsed->coeff;
+    *den = parsed->den_coeff;
+    if (U128P_EQ_ZERO(den))
+        return RN_DIVISION_BY_ZERO;
+    if (U128P_EQ_ZERO(num)) {
+        U128_FROM_LO_HI(den, 1ULL, 0ULL);
+        return RN_OK;
+    }
+    if (exp > 0 && !u128_checked_imul_10_pow_n(num, exp))
+        return RN_LIMIT_EXCEEDED;
+    if (exp < 0 && !u128_checked_imul_10_pow_n(den, -exp))
+        return RN_LIMIT_EXCEEDED;
+    return RN_OK;
+}
+
+// Literals exceeding the compact representations are parsed into chunks of
+// RN_DIGIT_CHUNK_LEN decimal digits, to be combined into arbitrary
+// precision integers by the caller.
+
+#define RN_DIGIT_CHUNK_LEN UINT64_10_POW_N_CUTOFF
+
+// value = (chunks[0] ... chunks[n_chunks - 1] tail) * 10 ^ exp
+// where each of the chunks holds RN_DIGIT_CHUNK_LEN digits and tail holds
+// the remaining n_tail_digits (< RN_DIGIT_CHUNK_LEN) digits
+struct rn_digit_chunks {
+    uint64_t *chunks;
+    size_t n_chunks;
+    uint64_t tail;
+    int n_tail_digits;
+    int64_t exp;
+};
+
+struct rn_parsed_big_repr {
+    bool is_quot;
+    bool neg;
+    struct rn_digit_chunks num;
+    struct rn_digit_chunks den;     // only set if is_quot
+};
+
+// Format of literals accepted by rn_normalize_*_literal
+struct rn_literal_fmt {
+    uint32_t decimal_point;
+    uint32_t group_sep;             // RN_NO_GROUP_SEP if not accepted
+    bool paren_negative;
+    bool trailing_sign;
+};
+
+#define RN_NO_GROUP_SEP UINT32_MAX
+
+// Number of chunks to be provided for parsing a literal of length len
+#define RN_BIG_N_CHUNKS(len) ((size_t)(len) / RN_DIGIT_CHUNK_LEN + 2)
+
+// Max absolute value of the exponent of a long literal
+#define RN_BIG_MAX_EXP INT32_MAX
+
+static inline void
+rn_digit_chunks_init(struct rn_digit_chunks *dc, uint64_t *chunks) {
+    dc->chunks = chunks;
+    dc->n_chunks = 0;
+    dc->tail = 0;
+    dc->n_tail_digits = 0;
+    dc->exp = 0;
+}
+
+static inline void
+rn_digit_chunks_push(struct rn_digit_chunks *dc, int d) {
+    dc->tail = dc->tail * 10 + d;
+    if (++dc->n_tail_digits == RN_DIGIT_CHUNK_LEN) {
+        dc->chunks[dc->n_chunks++] = dc->tail;
+        dc->tail = 0;
+        dc->n_tail_digits = 0;
+    }
+}
+
+static inline bool
+rn_digit_chunks_eq_zero(const struct rn_digit_chunks *dc) {
+    // leading zeros are never pushed
+    return dc->n_chunks == 0 && dc->n_tail_digits == 0;
+}
+
+static inline rn_error_t
 invalid_literal() {
-    PyErr_SetString(PyExc_ValueError, "Invalid literal for Rational.");
-    return -1;
+    return RN_INVALID_LITERAL;
 }
 
+// Character classification
+
+static inline bool
+rn_is_ascii_space(uint32_t uch) {
+    return uch == ' ' || (uch >= '\t' && uch <= '\r');
+}
+
+static inline bool
+rn_is_space(uint32_t uch) {
+    if (uch < 0x80)
+        return rn_is_ascii_space(uch);
+    return iswspace((wint_t)uch);
+}
+
+// Latin-1 does not contain any decimal digits beyond the ascii ones, so
+// literals stored with one byte per char can skip the lookup of non-ascii
+// digits.
+static inline int
+map_ascii_to_dec_digit(uint32_t uch) {
+    uint32_t d = uch - '0';
+    return d < 10 ? (int)d : -1;
+}
+
+// All other chars below NON_ASCII_DIGIT_MIN, i.e. ascii and latin-1, are
+// rejected by a single comparison, the others by one lookup in a two-level
+// table.
 static inline int
-map_to_dec_digit(Py_UCS4 uch) {
-    if (uch >= '0' && uch <= '9')
-        return (int)uch - '0';
+map_to_dec_digit(uint32_t uch) {
+    uint32_t d = uch - '0';
+    if (d < 10)
+        return (int)d;
     return lookup_non_ascii_digit(uch);
 }
 
-// parse a Rational literal
-// [+/-]<num>/<den> or
-// [+|-]<int>[.<frac>][<e|E>[+|-]<exp>] or
-// [+|-].<frac>[<e|E>[+|-]<exp>].
-static inline error_t
-rn_from_ucs4_literal(struct rn_parsed_repr *parsed, Py_UCS4 *literal) {
-    Py_UCS4 *cp = literal;
-    uint128_t u128_accu = UINT128_ZERO;
-    int64_t i64_accu = 0;
-    Py_ssize_t n_dec_digits = 0;
-    Py_ssize_t n_dec_int_digits;
-    Py_ssize_t n_dec_frac_digits = 0;
-    int d;
-    bool leading_zero = false;
-
-    for (; iswspace(*cp); ++cp);
-    if (*cp == 0)
-        return invalid_literal();
-    parsed->neg = false;
-    switch (*cp) {
-        case '-':
-            parsed->neg = true;
-            FALLTHROUGH;
-        case '+':
-            ++cp;
-    }
-    while (*cp == '0' || lookup_non_ascii_digit(*cp) == '0') {
-        leading_zero = true;
-        ++cp;
-    }
-    while (*cp != 0 && (d = map_to_dec_digit(*cp)) >= 0) {
-        if (n_dec_digits == UINT128_10_POW_N_CUTOFF)
-            // there are more digits than coeff can hold, so give up
-            return -1;
-        u128_imul10_add_digit(&u128_accu, d);
-        ++cp;
-        ++n_dec_digits;
-    }
-    parsed->coeff = u128_accu;
-    parsed->is_quot = false;
-    switch (*cp) {
-        case '.':
-            ++cp;
-            n_dec_int_digits = n_dec_digits;
-            while (*cp != 0 && (d = map_to_dec_digit(*cp)) >= 0) {
-                if (n_dec_digits == UINT128_10_POW_N_CUTOFF)
-                    // there are more digits than coeff can hold, so give up
-                    return -1;
-                u128_imul10_add_digit(&u128_accu, d);
-                ++n_dec_digits;
-                ++cp;
-            }
-            parsed->coeff = u128_accu;
-            n_dec_frac_digits = n_dec_digits - n_dec_int_digits;
-            break;
-        case '/':
-            if (n_dec_digits > UINT64_10_POW_N_CUTOFF)
-                // numerator overflowed, so give up
-                return -1;
-            ++cp;
-            parsed->is_quot = true;
-            parsed->num = U128_LO(u128_accu);
-            n_dec_digits = 0;
-            while (*cp != 0 && (d = map_to_dec_digit(*cp)) >= 0) {
-                if (n_dec_digits > UINT64_10_POW_N_CUTOFF)
-                    // denominator overflowed, so give up
-                    return -1;
-                i64_accu = i64_accu * 10 + d;
-                ++n_dec_digits;
-                ++cp;
-            }
-            parsed->den = i64_accu;
+// SWAR ("SIMD within a register") conversion of 8 ascii digits at once,
+// see Daniel Lemire, Fast Number Parsing Without Fallback, and Wojciech Muła,
+// SWAR parsing of 8-digit numbers
+
+// 8 chars with the first char in the least significant byte
+static inline uint64_t
+u64_load_8_chars(const uint8_t *cp) {
+    uint64_t v;
+    memcpy(&v, cp, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline bool
+u64_is_8_ascii_digits(uint64_t v) {
+    // all high nibbles are 3 and all low nibbles are <= 9
+    return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4U))
+           == 0x3333333333333333ULL;
+}
+
+static inline uint64_t
+u64_from_8_ascii_digits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100ULL + (1000000ULL << 32U);
+    const uint64_t mul2 = 1ULL + (10000ULL << 32U);
+
+    v -= 0x3030303030303030ULL;
+    // pairs of digits
+    v = (v * 10U) + (v >> 8U);
+    // combine pairs to 8 digits
+    v = (((v & mask) * mul1) + (((v >> 16U) & mask) * mul2)) >> 32U;
+    return v;
+}
+
+// Accumulate chunks of 8 ascii digits, as long as accu can hold them.
+static inline void
+rn_accu_8_digit_chunks(const uint8_t **cp, const uint8_t *end,
+                       uint128_t *accu, int *n_dec_digits) {
+    uint64_t v;
+
+    while (end - *cp >= 8 &&
+           *n_dec_digits <= UINT128_10_POW_N_CUTOFF - 8) {
+        v = u64_load_8_chars(*cp);
+        if (!u64_is_8_ascii_digits(v))
             break;
+        u128_imul_u64(accu, 100000000ULL);
+        u128_iadd_u64(accu, u64_from_8_ascii_digits(v));
+        *cp += 8;
+        *n_dec_digits += 8;
     }
-    if (n_dec_digits == 0 && !leading_zero)
-        return invalid_literal();
-    if (!parsed->is_quot) {
-        bool neg_exp = false;
-        parsed->exp = 0;
-        i64_accu = 0;
-        if (*cp == 'e' || *cp == 'E') {
-            ++cp;
-            switch (*cp) {
-                case '-':
-                    neg_exp = true;
-                    FALLTHROUGH;
-                case '+':
-                    ++cp;
-            }
-            d = map_to_dec_digit(*cp);
-            if (d == -1)
-                return invalid_literal();
-            do {
-                i64_accu = i64_accu * 10 + d;
-                if (i64_accu > RN_MAX_EXP)
-                    // exp overflowed, so give up
-                    return -1;
-                ++cp;
-            } while (*cp != 0 && (d = map_to_dec_digit(*cp)) >= 0);
-        }
-        if (neg_exp) {
-            i64_accu = -i64_accu - n_dec_frac_digits;
-            if (i64_accu < RN_MIN_EXP)
-                // exp overflowed, so give up
-                return -1;
-            parsed->exp = i64_accu;
-        }
-        else
-            parsed->exp = (i64_accu - n_dec_frac_digits);
-    }
-    for (; iswspace(*cp); ++cp);
-    if (*cp != 0)
-        return invalid_literal();
-    return 0;
 }
 
+// Parsers for literals given as ascii bytes, 1-byte (latin-1), 2-byte
+// (ucs2) or 4-byte (ucs4) chars.
+
+#define RN_PARSE_FUNC rn_from_ascii_literal
+#define RN_PARSE_BIG_FUNC rn_big_from_ascii_literal
+#define RN_PARSE_CHAR_T uint8_t
+#define RN_PARSE_IS_SPACE rn_is_ascii_space
+#define RN_PARSE_MAP_DIGIT map_ascii_to_dec_digit
+#define RN_PARSE_DIGIT_CHUNKS rn_accu_8_digit_chunks
+#include "parse_literal.h"
+
+#define RN_PARSE_FUNC rn_from_ucs1_literal
+#define RN_PARSE_BIG_FUNC rn_big_from_ucs1_literal
+#define RN_PARSE_NORMALIZE_FUNC rn_normalize_ucs1_literal
+#define RN_PARSE_CHAR_T uint8_t
+#define RN_PARSE_IS_SPACE rn_is_space
+#define RN_PARSE_MAP_DIGIT map_ascii_to_dec_digit
+#define RN_PARSE_DIGIT_CHUNKS rn_accu_8_digit_chunks
+#include "parse_literal.h"
+
+#define RN_PARSE_FUNC rn_from_ucs2_literal
+#define RN_PARSE_BIG_FUNC rn_big_from_ucs2_literal
+#define RN_PARSE_NORMALIZE_FUNC rn_normalize_ucs2_literal
+#define RN_PARSE_CHAR_T uint16_t
+#define RN_PARSE_IS_SPACE rn_is_space
+#define RN_PARSE_MAP_DIGIT map_to_dec_digit
+#include "parse_literal.h"
+
+#define RN_PARSE_FUNC rn_from_ucs4_literal
+#define RN_PARSE_BIG_FUNC rn_big_from_ucs4_literal
+#define RN_PARSE_NORMALIZE_FUNC rn_normalize_ucs4_literal
+#define RN_PARSE_CHAR_T uint32_t
+#define RN_PARSE_IS_SPACE rn_is_space
+#define RN_PARSE_MAP_DIGIT map_to_dec_digit
+#include "parse_literal.h"
+
 #endif //RATIONAL_PARSE_H
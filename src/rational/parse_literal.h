@@ -0,0 +1,381 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Template of the literal parser, to be included by parse.h once per
+ * character width, with the following macros defined:
+ *
+ * RN_PARSE_FUNC:       name of the parser for compact values
+ * RN_PARSE_BIG_FUNC:   name of the parser for literals of any length
+ * RN_PARSE_CHAR_T:     type of the characters to be parsed
+ * RN_PARSE_IS_SPACE:   function telling whether a character is whitespace
+ * RN_PARSE_MAP_DIGIT:  function mapping a character to the value of the
+ *                      decimal digit it represents, or to -1
+ *
+ * and optionally
+ *
+ * RN_PARSE_DIGIT_CHUNKS:   function accumulating several leading digits at
+ *                          once, see rn_accu_8_digit_chunks
+ * RN_PARSE_NORMALIZE_FUNC: name of the function converting a formatted
+ *                          literal to a canonical ascii literal
+ *
+ * No include guard by intention. */
+
+// parse a Rational literal
+// [+|-]<dec>[/<dec>]
+// where <dec> is
+// <int>[.<frac>][<e|E>[+|-]<exp>] or
+// .<frac>[<e|E>[+|-]<exp>].
+static inline rn_error_t
+RN_PARSE_FUNC(struct rn_parsed_repr *parsed, const RN_PARSE_CHAR_T *literal,
+              size_t len) {
+    const RN_PARSE_CHAR_T *cp = literal;
+    const RN_PARSE_CHAR_T *end = literal + len;
+    uint128_t *coeff = &parsed->coeff;
+    rn_exp_t *exp = &parsed->exp;
+    uint128_t u128_accu;
+    int64_t i64_accu;
+    int n_dec_digits;
+    int n_dec_int_digits;
+    int n_dec_frac_digits;
+    int d;
+    bool leading_zero;
+
+// current char, 0 at the end of the literal
+#define CH ((uint32_t)(cp < end ? *cp : 0U))
+#ifdef RN_PARSE_DIGIT_CHUNKS
+#define DIGIT_CHUNKS() \
+    RN_PARSE_DIGIT_CHUNKS(&cp, end, &u128_accu, &n_dec_digits)
+#else
+#define DIGIT_CHUNKS()
+#endif
+
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (cp == end)
+        return invalid_literal();
+    parsed->neg = false;
+    switch (*cp) {
+        case '-':
+            parsed->neg = true;
+            FALLTHROUGH;
+        case '+':
+            ++cp;
+    }
+    parsed->is_quot = false;
+    // numerator, followed by the denominator in case of a quotient
+    for (;;) {
+        u128_accu = UINT128_ZERO;
+        n_dec_digits = 0;
+        n_dec_frac_digits = 0;
+        leading_zero = false;
+        while (cp < end && RN_PARSE_MAP_DIGIT(*cp) == 0) {
+            leading_zero = true;
+            ++cp;
+        }
+        DIGIT_CHUNKS();
+        while (cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0) {
+            if (n_dec_digits == UINT128_10_POW_N_CUTOFF)
+                // there are more digits than coeff can hold, so give up
+                return RN_LIMIT_EXCEEDED;
+            u128_imul10_add_digit(&u128_accu, d);
+            ++cp;
+            ++n_dec_digits;
+        }
+        if (CH == '.') {
+            ++cp;
+            n_dec_int_digits = n_dec_digits;
+            DIGIT_CHUNKS();
+            while (cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0) {
+                if (n_dec_digits == UINT128_10_POW_N_CUTOFF)
+                    // there are more digits than coeff can hold, so give up
+                    return RN_LIMIT_EXCEEDED;
+                u128_imul10_add_digit(&u128_accu, d);
+                ++n_dec_digits;
+                ++cp;
+            }
+            n_dec_frac_digits = n_dec_digits - n_dec_int_digits;
+        }
+        if (n_dec_digits == 0 && !leading_zero)
+            return invalid_literal();
+        *coeff = u128_accu;
+        i64_accu = 0;
+        if (CH == 'e' || CH == 'E') {
+            bool neg_exp = false;
+            ++cp;
+            switch (CH) {
+                case '-':
+                    neg_exp = true;
+                    FALLTHROUGH;
+                case '+':
+                    ++cp;
+            }
+            if (cp == end || (d = RN_PARSE_MAP_DIGIT(*cp)) < 0)
+                return invalid_literal();
+            do {
+                i64_accu = i64_accu * 10 + d;
+                if (i64_accu > RN_MAX_EXP)
+                    // exp overflowed, so give up
+                    return RN_LIMIT_EXCEEDED;
+                ++cp;
+            } while (cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0);
+            if (neg_exp)
+                i64_accu = -i64_accu;
+        }
+        i64_accu -= n_dec_frac_digits;
+        if (i64_accu < RN_MIN_EXP)
+            // exp overflowed, so give up
+            return RN_LIMIT_EXCEEDED;
+        *exp = (rn_exp_t)i64_accu;
+        if (parsed->is_quot || CH != '/')
+            break;
+        ++cp;
+        parsed->is_quot = true;
+        coeff = &parsed->den_coeff;
+        exp = &parsed->den_exp;
+    }
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (cp != end)
+        return invalid_literal();
+    return RN_OK;
+
+#undef CH
+#undef DIGIT_CHUNKS
+}
+
+// parse a Rational literal of any length (see above) into chunks of digits;
+// chunks must provide room for RN_BIG_N_CHUNKS(len) elements.
+static inline rn_error_t
+RN_PARSE_BIG_FUNC(struct rn_parsed_big_repr *parsed, uint64_t *chunks,
+                  const RN_PARSE_CHAR_T *literal, size_t len) {
+    const RN_PARSE_CHAR_T *cp = literal;
+    const RN_PARSE_CHAR_T *end = literal + len;
+    struct rn_digit_chunks *dc = &parsed->num;
+    int64_t i64_accu;
+    int64_t n_frac_digits;
+    int64_t n_zeros;
+    bool has_digits;
+    int d;
+
+// current char, 0 at the end of the literal
+#define CH ((uint32_t)(cp < end ? *cp : 0U))
+// Add digit to dc. Zeros are held back until a non-zero digit follows, so
+// that leading zeros are dropped and trailing zeros end up in the exponent.
+#define PUSH_DIGIT(d) \
+    do { \
+        if ((d) == 0) { \
+            if (!rn_digit_chunks_eq_zero(dc)) \
+                ++n_zeros; \
+        } \
+        else { \
+            for (; n_zeros > 0; --n_zeros) \
+                rn_digit_chunks_push(dc, 0); \
+            rn_digit_chunks_push(dc, d); \
+        } \
+        has_digits = true; \
+    } while (0)
+
+    rn_digit_chunks_init(dc, chunks);
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (cp == end)
+        return invalid_literal();
+    parsed->neg = false;
+    switch (*cp) {
+        case '-':
+            parsed->neg = true;
+            FALLTHROUGH;
+        case '+':
+            ++cp;
+    }
+    parsed->is_quot = false;
+    // numerator, followed by the denominator in case of a quotient
+    for (;;) {
+        n_frac_digits = 0;
+        n_zeros = 0;
+        has_digits = false;
+        for (; cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0; ++cp)
+            PUSH_DIGIT(d);
+        if (CH == '.') {
+            for (++cp; cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0; ++cp) {
+                PUSH_DIGIT(d);
+                ++n_frac_digits;
+            }
+        }
+        if (!has_digits)
+            return invalid_literal();
+        i64_accu = 0;
+        if (CH == 'e' || CH == 'E') {
+            bool neg_exp = false;
+            ++cp;
+            switch (CH) {
+                case '-':
+                    neg_exp = true;
+                    FALLTHROUGH;
+                case '+':
+                    ++cp;
+            }
+            if (cp == end || (d = RN_PARSE_MAP_DIGIT(*cp)) < 0)
+                return invalid_literal();
+            do {
+                i64_accu = i64_accu * 10 + d;
+                if (i64_accu > RN_BIG_MAX_EXP)
+                    // exp overflowed, so give up
+                    return RN_LIMIT_EXCEEDED;
+                ++cp;
+            } while (cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0);
+            if (neg_exp)
+                i64_accu = -i64_accu;
+        }
+        dc->exp = i64_accu - n_frac_digits + n_zeros;
+        if (parsed->is_quot || CH != '/')
+            break;
+        ++cp;
+        parsed->is_quot = true;
+        dc = &parsed->den;
+        rn_digit_chunks_init(dc, chunks + parsed->num.n_chunks);
+    }
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (cp != end)
+        return invalid_literal();
+    return RN_OK;
+
+#undef CH
+#undef PUSH_DIGIT
+}
+
+#ifdef RN_PARSE_NORMALIZE_FUNC
+// convert a formatted Rational literal
+// [(][+|-]<num>[/<num>][+|-][)]
+// where <num> is a decimal as above, with fmt->decimal_point in place of '.'
+// and fmt->group_sep allowed to split the digits of its integral part into
+// groups of three (the leading group may be shorter), to a canonical ascii
+// literal, mapping all digits to ascii digits.
+// Parentheses (negating the value) and a trailing sign are accepted only if
+// enabled in fmt and if there is no leading sign.
+// The result is written to buf, which must provide room for len + 1 chars;
+// its length is returned in *n.
+static inline rn_error_t
+RN_PARSE_NORMALIZE_FUNC(char *buf, size_t *n, const RN_PARSE_CHAR_T *literal,
+                        size_t len, const struct rn_literal_fmt *fmt) {
+    const RN_PARSE_CHAR_T *cp = literal;
+    const RN_PARSE_CHAR_T *end = literal + len;
+    char *out = buf;
+    bool neg = false;
+    bool has_sign = false;
+    bool paren = false;
+    bool is_quot = false;
+    bool grouped;
+    size_t n_digits;
+    size_t n_group_digits;
+    int d;
+
+// current char, 0 at the end of the literal
+#define CH ((uint32_t)(cp < end ? *cp : 0U))
+// current char equals uch
+#define AT(uch) (cp < end && *cp == (uch))
+#define EMIT_DIGIT(d) (*out++ = (char)('0' + (d)))
+
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (fmt->paren_negative && CH == '(') {
+        paren = true;
+        ++cp;
+    }
+    // sign, to be overwritten in case of a negative value
+    *out++ = '+';
+    switch (CH) {
+        case '-':
+            neg = true;
+            FALLTHROUGH;
+        case '+':
+            has_sign = true;
+            ++cp;
+    }
+    // numerator, followed by the denominator in case of a quotient
+    for (;;) {
+        n_digits = 0;
+        n_group_digits = 0;
+        grouped = false;
+        for (; cp < end; ++cp) {
+            if ((d = RN_PARSE_MAP_DIGIT(*cp)) >= 0) {
+                EMIT_DIGIT(d);
+                ++n_digits;
+                ++n_group_digits;
+            }
+            else if (*cp == fmt->group_sep && n_group_digits > 0 &&
+                     n_group_digits <= 3 &&
+                     (!grouped || n_group_digits == 3) &&
+                     cp + 1 < end && RN_PARSE_MAP_DIGIT(cp[1]) >= 0) {
+                grouped = true;
+                n_group_digits = 0;
+            }
+            else
+                break;
+        }
+        // the last group must be complete as well
+        if (grouped && n_group_digits != 3)
+            return invalid_literal();
+        if (AT(fmt->decimal_point)) {
+            *out++ = '.';
+            for (++cp; cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0; ++cp) {
+                EMIT_DIGIT(d);
+                ++n_digits;
+            }
+        }
+        if (n_digits == 0)
+            return invalid_literal();
+        if (CH == 'e' || CH == 'E') {
+            *out++ = 'e';
+            ++cp;
+            if (CH == '+' || CH == '-')
+                *out++ = (char)*cp++;
+            // missing digits are detected when parsing the result
+            for (; cp < end && (d = RN_PARSE_MAP_DIGIT(*cp)) >= 0; ++cp)
+                EMIT_DIGIT(d);
+        }
+        if (is_quot || CH != '/')
+            break;
+        *out++ = '/';
+        ++cp;
+        is_quot = true;
+    }
+    if (fmt->trailing_sign && !has_sign && !paren) {
+        switch (CH) {
+            case '-':
+                neg = true;
+                FALLTHROUGH;
+            case '+':
+                ++cp;
+        }
+    }
+    if (paren) {
+        if (has_sign || CH != ')')
+            return invalid_literal();
+        neg = true;
+        ++cp;
+    }
+    for (; cp < end && RN_PARSE_IS_SPACE(*cp); ++cp);
+    if (cp != end)
+        return invalid_literal();
+    if (neg)
+        *buf = '-';
+    *n = (size_t)(out - buf);
+    return RN_OK;
+
+#undef CH
+#undef AT
+#undef EMIT_DIGIT
+}
+#endif // RN_PARSE_NORMALIZE_FUNC
+
+#undef RN_PARSE_FUNC
+#undef RN_PARSE_BIG_FUNC
+#undef RN_PARSE_CHAR_T
+#undef RN_PARSE_IS_SPACE
+#undef RN_PARSE_MAP_DIGIT
+#undef RN_PARSE_DIGIT_CHUNKS
+#undef RN_PARSE_NORMALIZE_FUNC
@@ -0,0 +1,179 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#ifndef RATIONAL_PYLONG_MATH_H
+#define RATIONAL_PYLONG_MATH_H
+
+#include <Python.h>
+
+#include "common.h"
+#include "uint64_math.h"
+
+// Powers of 10 as Python ints
+
+// Cache of 10 ^ n for 0 <= n <= RN_MAX_PREC, filled lazily
+static PyObject *PyLong_10_POWS[RN_MAX_PREC + 1];
+
+// Returns a new reference to 10 ^ n (n >= 0).
+// Values exceeding the range of uint64_t are built from two cached halves,
+// so that 10 ^ n costs at most one multiplication of Python ints once the
+// smaller powers have been used.
+static PyObject *
+pylong_10_pow_n(Py_ssize_t n) {
+    PyObject *res = NULL;
+    PyObject *lhs = NULL;
+    PyObject *rhs = NULL;
+
+    assert(n >= 0);
+
+    if (n <= RN_MAX_PREC && PyLong_10_POWS[n] != NULL) {
+        Py_INCREF(PyLong_10_POWS[n]);
+        return PyLong_10_POWS[n];
+    }
+    if (n <= UINT64_10_POW_N_CUTOFF)
+        ASSIGN_AND_CHECK_NULL(res,
+                              PyLong_FromUnsignedLongLong(u64_10_pow_n(n)));
+    else {
+        ASSIGN_AND_CHECK_NULL(lhs, pylong_10_pow_n(n / 2));
+        ASSIGN_AND_CHECK_NULL(rhs, pylong_10_pow_n(n - n / 2));
+        ASSIGN_AND_CHECK_NULL(res, PyNumber_Multiply(lhs, rhs));
+    }
+    if (n <= RN_MAX_PREC) {
+        Py_INCREF(res);
+        PyLong_10_POWS[n] = res;
+    }
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(lhs);
+    Py_XDECREF(rhs);
+    return res;
+}
+
+// Returns a new reference to the int represented by n > 0 chunks of
+// UINT64_10_POW_N_CUTOFF decimal digits each, most significant chunk first.
+// The chunks are combined by divide and conquer, so that the multiplications
+// operate on factors of similar size and the total cost is dominated by the
+// last multiplication, instead of growing quadratically with n.
+static PyObject *
+pylong_from_dec_chunks(const uint64_t *chunks, size_t n) {
+    PyObject *res = NULL;
+    PyObject *hi = NULL;
+    PyObject *lo = NULL;
+    PyObject *scale = NULL;
+    PyObject *t = NULL;
+    size_t n_lo = n / 2;
+
+    assert(n > 0);
+
+    if (n == 1)
+        return PyLong_FromUnsignedLongLong(chunks[0]);
+    ASSIGN_AND_CHECK_NULL(hi, pylong_from_dec_chunks(chunks, n - n_lo));
+    ASSIGN_AND_CHECK_NULL(lo, pylong_from_dec_chunks(chunks + n - n_lo,
+                                                     n_lo));
+    ASSIGN_AND_CHECK_NULL(scale,
+                          pylong_10_pow_n(n_lo * UINT64_10_POW_N_CUTOFF));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(hi, scale));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_Add(t, lo));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(hi);
+    Py_XDECREF(lo);
+    Py_XDECREF(scale);
+    Py_XDECREF(t);
+    return res;
+}
+
+// Writes the n_digits decimal digits of 0 <= x < 10 ^ n_digits, left-padded
+// with zeros, to buf. Like pylong_from_dec_chunks, but in reverse: x is
+// split into halves by divide and conquer down to chunks fitting into
+// uint64_t, so that the conversion is not subject to the limit Python
+// imposes on the length of int-to-str conversions.
+// Returns 0 on success, -1 on error.
+static int
+pylong_write_dec_digits(char *buf, PyObject *x, size_t n_digits) {
+    PyObject *scale = NULL;
+    PyObject *qr = NULL;
+    size_t n_lo = n_digits / 2;
+    int rc = -1;
+
+    if (n_digits <= UINT64_10_POW_N_CUTOFF) {
+        uint64_t t = PyLong_AsUnsignedLongLong(x);
+        if (t == (uint64_t)-1 && PyErr_Occurred())
+            return -1;
+        for (size_t i = n_digits; i > 0; --i) {
+            buf[i - 1] = (char)('0' + t % 10);
+            t /= 10;
+        }
+        return 0;
+    }
+    ASSIGN_AND_CHECK_NULL(scale, pylong_10_pow_n((Py_ssize_t)n_lo));
+    ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(x, scale));
+    if (pylong_write_dec_digits(buf, PyTuple_GetItem(qr, 0),
+                                n_digits - n_lo) != 0 ||
+            pylong_write_dec_digits(buf + n_digits - n_lo,
+                                    PyTuple_GetItem(qr, 1), n_lo) != 0)
+        goto ERROR;
+    rc = 0;
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(scale);
+    Py_XDECREF(qr);
+    return rc;
+}
+
+// Returns a new reference to the decimal representation of the int x >= 0
+// (not subject to the limit on int-to-str conversions).
+static PyObject *
+pylong_to_dec_str(PyObject *x) {
+    PyObject *res = NULL;
+    PyObject *t = NULL;
+    char *buf = NULL;
+    char *cp;
+    size_t n_bits, n_digits;
+
+    ASSIGN_AND_CHECK_NULL(t, PyObject_CallFunctionObjArgs(PyLong_bit_length,
+                                                          x, NULL));
+    n_bits = PyLong_AsSize_t(t);
+    if (n_bits == (size_t)-1 && PyErr_Occurred())
+        goto ERROR;
+    // x < 2 ^ n_bits <= 10 ^ n_digits, as 0.30103 > log10(2)
+    n_digits = (size_t)((double)n_bits * 0.30103) + 1;
+    if ((buf = PyMem_Malloc(n_digits)) == NULL) {
+        PyErr_NoMemory();
+        goto ERROR;
+    }
+    if (pylong_write_dec_digits(buf, x, n_digits) != 0)
+        goto ERROR;
+    for (cp = buf; cp < buf + n_digits - 1 && *cp == '0'; ++cp);
+    res = PyUnicode_FromStringAndSize(cp, (Py_ssize_t)(buf + n_digits - cp));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    PyMem_Free(buf);
+    Py_XDECREF(t);
+    return res;
+}
+
+#endif //RATIONAL_PYLONG_MATH_H
@@ -10,22 +10,35 @@ $Revision$
 
 //#undef __SIZEOF_INT128__
 #define PY_SSIZE_T_CLEAN
+// By default, the extension is built against the limited API, so that one
+// wheel serves all Python versions >= 3.7. Defining RN_FULL_API gives
+// access to the internals of str objects, which are then parsed in place.
+#ifndef RN_FULL_API
 #define Py_LIMITED_API 0x03070000
+#endif
 
 #include <Python.h>
 #include <assert.h>
 #include <errno.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "common.h"
 #include "compiler_macros.h"
+#include "decimal_expansion.h"
 #include "docstrings.h"
+#include "format_spec.h"
+#include "hex_literal.h"
+#include "numeric_hash.h"
 #include "parse.h"
 #include "rn_fpdec.h"
+#include "rn_pyconv.h"
 #include "rn_pyint_quot.h"
 #include "rn_u64_quot.h"
 #include "rounding.h"
+#include "sort_key.h"
 
 
 // error handling
@@ -55,11 +68,64 @@ static PyObject *Integral = NULL;
 static PyObject *Fraction = NULL;
 static PyObject *Decimal = NULL;
 
-// Python constants for hash function
+// Rounding (will be imported from rounding.py)
 
-static PyObject *PyHASH_MODULUS = NULL;
-static PyObject *PyHASH_MODULUS_2 = NULL;
-static PyObject *PyHASH_INF = NULL;
+static PyObject *Rounding = NULL;
+static PyObject *get_dflt_rounding_mode = NULL;
+
+static enum RN_ROUNDING_MODE
+rn_rounding_mode() {
+    long rounding_mode = 0;
+    PyObject *dflt = NULL;
+    PyObject *val = NULL;
+
+#if !defined(Py_LIMITED_API) && PY_VERSION_HEX >= 0x03090000 || \
+    Py_LIMITED_API >= 0x030A0000
+    ASSIGN_AND_CHECK_NULL(dflt, PyObject_CallNoArgs(get_dflt_rounding_mode));
+#else
+    ASSIGN_AND_CHECK_NULL(dflt,
+                          PyObject_CallObject(get_dflt_rounding_mode, NULL));
+#endif
+    ASSIGN_AND_CHECK_NULL(val, PyObject_GetAttrString(dflt, "value"));
+    rounding_mode = PyLong_AsLong(val);
+
+ERROR:
+    Py_XDECREF(dflt);
+    Py_XDECREF(val);
+    return (enum RN_ROUNDING_MODE)rounding_mode;
+}
+
+// Get the rounding mode given as member of Rounding, or the default rounding
+// mode if None is given
+static int
+rn_rounding_mode_from_obj(enum RN_ROUNDING_MODE *rounding_mode,
+                          PyObject *rounding) {
+    PyObject *val = NULL;
+    long mode;
+
+    if (rounding == Py_None) {
+        *rounding_mode = rn_rounding_mode();
+        return PyErr_Occurred() ? -1 : 0;
+    }
+    if (!PyObject_IsInstance(rounding, Rounding)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Rounding must be of type 'Rounding'.");
+        return -1;
+    }
+    val = PyObject_GetAttrString(rounding, "value");
+    if (val == NULL)
+        return -1;
+    mode = PyLong_AsLong(val);
+    Py_DECREF(val);
+    if (mode == -1 && PyErr_Occurred())
+        return -1;
+    *rounding_mode = (enum RN_ROUNDING_MODE)mode;
+    return 0;
+}
+
+// Parameters for hash function (from sys.hash_info)
+
+static struct rn_hash_params rn_hash_params;
 
 /*============================================================================
 * Rational type
@@ -73,6 +139,7 @@ static PyObject *PyHASH_INF = NULL;
 typedef struct rational_object {
     PyObject_HEAD
     Py_hash_t hash;
+    Py_ssize_t magn;            // cached magnitude (or RN_UNDEF_MAGN)
     struct {
         PyObject *numerator;
         PyObject *denominator;
@@ -106,6 +173,21 @@ Rational_as_fraction(RationalObject *self, PyObject *args UNUSED);
 static error_t
 rn_assert_num_den(RationalObject *rn);
 
+static inline error_t
+check_n_convert_prec(PyObject *precision, long *long_prec);
+
+static PyObject *
+rn_pylong_quot_to_sci_str(bool neg, PyObject *num, PyObject *den,
+                          bool engineering);
+
+static int
+rn_adjust_inplace(RationalObject *rn, rn_prec_t to_prec,
+                  enum RN_ROUNDING_MODE rounding_mode);
+
+static PyObject *
+rn_adjusted(RationalObject *self, rn_prec_t to_prec,
+            enum RN_ROUNDING_MODE rounding_mode);
+
 // Consistency check
 
 static inline bool
@@ -171,6 +253,7 @@ RationalType_alloc(PyTypeObject *type) {
     }
 
     rn->hash = -1;
+    rn->magn = RN_UNDEF_MAGN;
     rn->numerator = NULL;
     rn->denominator = NULL;
     rn->variant = RN_FPDEC;
@@ -261,6 +344,7 @@ RationalType_from_rational_obj(PyTypeObject *type, RationalObject *rn) {
             self->denominator = rn->denominator;
         }
         self->hash = rn->hash;
+        self->magn = rn->magn;
         return (PyObject *)self;
     }
 }
@@ -289,7 +373,7 @@ RationalType_from_pylong(PyTypeObject *type, PyObject *val) {
         }
         else {
             self->sign = RN_SIGN_NEG;
-            U128_FROM_LO_HI(&self->coeff, -lval, 0ULL);
+            U128_FROM_LO_HI(&self->coeff, -(uint64_t)lval, 0ULL);
         }
         goto CLEAN_UP;
     }
@@ -467,68 +551,163 @@ CLEAN_UP:
     return res;
 }
 
+// Create a Rational from (-1) ^ neg * num * 10 ^ exp / den, with num and
+// den being non-negative ints, den > 0
 static PyObject *
-RationalType_from_str(PyTypeObject *type, PyObject *val) {
-    Py_UCS4 *buf;
-    error_t rc;
-    struct rn_parsed_repr parsed;
-    PyObject *frac = NULL;
+RationalType_from_pylong_quot(PyTypeObject *type, bool neg, PyObject *num,
+                              PyObject *den, int64_t exp) {
+    PyObject *scale = NULL;
+    PyObject *divisor = NULL;
+    PyObject *t = NULL;
     PyObject *res = NULL;
 
-    ASSIGN_AND_CHECK_NULL(buf, PyUnicode_AsUCS4Copy(val));
-    rc = rn_from_ucs4_literal(&parsed, buf);
-    PyMem_Free(buf);
-    if (rc < 0) {
-        if (PyErr_Occurred())
-            goto ERROR;
-        goto FALLBACK;  // fall back to Fraction
+    Py_INCREF(num);
+    Py_INCREF(den);
+    if (exp > 0) {
+        ASSIGN_AND_CHECK_NULL(scale, pylong_10_pow_n(exp));
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(num, scale));
+        Py_DECREF(num);
+        num = t;
     }
-    else {
+    else if (exp < 0) {
+        ASSIGN_AND_CHECK_NULL(scale, pylong_10_pow_n(-exp));
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(den, scale));
+        Py_DECREF(den);
+        den = t;
+    }
+    ASSIGN_AND_CHECK_NULL(divisor,
+                          PyObject_CallFunctionObjArgs(PyNumber_gcd,
+                                                       num, den, NULL));
+    if (PyObject_RichCompareBool(divisor, PyONE, Py_NE)) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_FloorDivide(num, divisor));
+        Py_DECREF(num);
+        num = t;
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_FloorDivide(den, divisor));
+        Py_DECREF(den);
+        den = t;
+    }
+    if (neg) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(num));
+        Py_DECREF(num);
+        num = t;
+    }
+    ASSIGN_AND_CHECK_NULL(res,
+                          RationalType_from_normalized_num_den(type, num,
+                                                               den));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_DECREF(num);
+    Py_DECREF(den);
+    Py_XDECREF(scale);
+    Py_XDECREF(divisor);
+    return res;
+}
+
+// Create a Rational from a parsed quotient
+static PyObject *
+RationalType_from_parsed_quot(PyTypeObject *type,
+                              struct rn_parsed_repr *parsed) {
+    uint128_t num, den, t;
+    uint64_t u64_den, divisor;
+    PyObject *py_num = NULL;
+    PyObject *py_den = NULL;
+    PyObject *res = NULL;
+    int64_t exp = (int64_t)parsed->exp - parsed->den_exp;
+    rn_error_t rc;
+
+    rc = rn_parsed_quot_to_int(parsed, &num, &den);
+    if (rc == RN_DIVISION_BY_ZERO) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Denominator = 0.");
+        return NULL;
+    }
+    if (rc == RN_OK && U128_HI(den) == 0) {
         RATIONAL_ALLOC_SELF(type);
-        res = (PyObject *)self;
-        if (parsed.is_quot) {
-            if (parsed.den == 0) {
-                PyErr_SetString(PyExc_ZeroDivisionError, "Denominator = 0.");
-                goto ERROR;
-            }
-            if (parsed.num == 0)
-                goto CLEAN_UP;
-            rnq_reduce_quot(&parsed.num, &parsed.den);
-            if (rnd_from_quot(&self->coeff, &self->exp, parsed.num,
-                              parsed.den) == 0) {
-                self->variant = RN_FPDEC;
-                self->prec = -self->exp;
-            }
-            else {
-                self->variant = RN_U64_QUOT;
-                self->u64_num = parsed.num;
-                self->u64_den = parsed.den;
-                self->exp = RN_UNDEF_EXP;
-                self->prec = RN_UNLIM_PREC;
-            }
-        }
-        else if (U128_EQ_ZERO(parsed.coeff))
-            goto CLEAN_UP;
-        else {
-            self->variant = RN_FPDEC;
-            parsed.exp += u128_eliminate_trailing_zeros(&parsed.coeff,
-                                                        UINT32_MAX);
-            self->coeff = parsed.coeff;
-            self->exp = parsed.exp;
-            self->prec = -parsed.exp;
-        }
-        if (parsed.neg)
+        if (U128_EQ_ZERO(num))
+            return (PyObject *)self;
+        // reduce num / den
+        u64_den = U128_LO(den);
+        t = num;
+        divisor = gcd(u128_idiv_u64(&t, u64_den), u64_den);
+        u128_idiv_u64(&num, divisor);
+        u64_den /= divisor;
+        if (parsed->neg)
             self->sign = RN_SIGN_NEG;
         else
             self->sign = RN_SIGN_POS;
-        goto CLEAN_UP;
+        if (rnd_from_u128_quot(&self->coeff, &self->exp, &num,
+                               u64_den) == RN_OK) {
+            self->variant = RN_FPDEC;
+            self->prec = -self->exp;
+            assert(rn_is_consistent(self));
+            return (PyObject *)self;
+        }
+        if (U128_HI(num) == 0) {
+            self->variant = RN_U64_QUOT;
+            self->u64_num = U128_LO(num);
+            self->u64_den = u64_den;
+            self->exp = RN_UNDEF_EXP;
+            self->prec = RN_UNLIM_PREC;
+            assert(rn_is_consistent(self));
+            return (PyObject *)self;
+        }
+        // numerator exceeds 64 bits
+        Py_DECREF(self);
+        U128_FROM_LO_HI(&den, u64_den, 0ULL);
+        exp = 0;
+    }
+    else {
+        num = parsed->coeff;
+        den = parsed->den_coeff;
     }
+    ASSIGN_AND_CHECK_NULL(py_num, pylong_from_u128(&num));
+    ASSIGN_AND_CHECK_NULL(py_den, pylong_from_u128(&den));
+    ASSIGN_AND_CHECK_NULL(res,
+                          RationalType_from_pylong_quot(type, parsed->neg,
+                                                        py_num, py_den,
+                                                        exp));
+    goto CLEAN_UP;
 
-FALLBACK:
-    ASSIGN_AND_CHECK_NULL(frac,
-                          PyObject_CallFunctionObjArgs(Fraction, val,
-                                                       NULL));
-    ASSIGN_AND_CHECK_NULL(res, RationalType_from_rational(type, frac));
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(py_num);
+    Py_XDECREF(py_den);
+    return res;
+}
+
+// Create a Rational from a parsed literal
+static PyObject *
+RationalType_from_parsed(PyTypeObject *type, rn_error_t rc,
+                         struct rn_parsed_repr *parsed) {
+    PyObject *res = NULL;
+
+    if (rc == RN_INVALID_LITERAL) {
+        PyErr_SetString(PyExc_ValueError, "Invalid literal for Rational.");
+        goto ERROR;
+    }
+    assert(rc == RN_OK);
+
+    if (parsed->is_quot)
+        return RationalType_from_parsed_quot(type, parsed);
+
+    RATIONAL_ALLOC_SELF(type);
+    res = (PyObject *)self;
+    if (U128_EQ_ZERO(parsed->coeff))
+        goto CLEAN_UP;
+    self->variant = RN_FPDEC;
+    parsed->exp += u128_eliminate_trailing_zeros(&parsed->coeff, UINT32_MAX);
+    self->coeff = parsed->coeff;
+    self->exp = parsed->exp;
+    self->prec = -parsed->exp;
+    if (parsed->neg)
+        self->sign = RN_SIGN_NEG;
+    else
+        self->sign = RN_SIGN_POS;
     goto CLEAN_UP;
 
 ERROR:
@@ -536,11 +715,499 @@ ERROR:
     Py_CLEAR(res);
 
 CLEAN_UP:
-    Py_XDECREF(frac);
     assert(rn_is_consistent((RationalObject *)res));
     return res;
 }
 
+// Create a Rational from a parsed literal exceeding the compact
+// representations
+static PyObject *
+RationalType_from_parsed_big(PyTypeObject *type, rn_error_t rc,
+                             struct rn_parsed_big_repr *parsed) {
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+    PyObject *res = NULL;
+    int64_t exp = parsed->num.exp;
+
+    if (rc == RN_INVALID_LITERAL)
+        return value_error_ptr("Invalid literal for Rational.");
+    if (rc == RN_LIMIT_EXCEEDED)
+        return value_error_ptr("Exponent of literal out of range.");
+    assert(rc == RN_OK);
+
+    if (parsed->is_quot) {
+        if (rn_digit_chunks_eq_zero(&parsed->den)) {
+            PyErr_SetString(PyExc_ZeroDivisionError, "Denominator = 0.");
+            return NULL;
+        }
+        exp -= parsed->den.exp;
+    }
+    if (rn_digit_chunks_eq_zero(&parsed->num))
+        return RationalType_from_pylong(type, PyZERO);
+
+    ASSIGN_AND_CHECK_NULL(num, pylong_from_digit_chunks(&parsed->num));
+    if (parsed->is_quot)
+        ASSIGN_AND_CHECK_NULL(den, pylong_from_digit_chunks(&parsed->den));
+    else {
+        Py_INCREF(PyONE);
+        den = PyONE;
+    }
+    ASSIGN_AND_CHECK_NULL(res,
+                          RationalType_from_pylong_quot(type, parsed->neg,
+                                                        num, den, exp));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    return res;
+}
+
+// Create a Rational from len chars, parsed by the functions instantiated
+// for the given kind of chars in parse.h
+#define RN_DEFINE_FROM_CHARS(kind, char_t)                                  \
+static PyObject *                                                           \
+RationalType_from_##kind##_chars(PyTypeObject *type, const char_t *chars,   \
+                                 Py_ssize_t len) {                          \
+    struct rn_parsed_repr parsed;                                           \
+    struct rn_parsed_big_repr big;                                          \
+    uint64_t *chunks;                                                       \
+    PyObject *res;                                                          \
+    rn_error_t rc;                                                          \
+                                                                            \
+    rc = rn_from_##kind##_literal(&parsed, chars, len);                     \
+    if (rc != RN_LIMIT_EXCEEDED)                                            \
+        return RationalType_from_parsed(type, rc, &parsed);                 \
+    chunks = PyMem_New(uint64_t, RN_BIG_N_CHUNKS(len));                     \
+    if (chunks == NULL)                                                     \
+        return PyErr_NoMemory();                                            \
+    rc = rn_big_from_##kind##_literal(&big, chunks, chars, len);            \
+    res = RationalType_from_parsed_big(type, rc, &big);                     \
+    PyMem_Free(chunks);                                                     \
+    return res;                                                             \
+}
+
+RN_DEFINE_FROM_CHARS(ascii, uint8_t)
+RN_DEFINE_FROM_CHARS(ucs4, uint32_t)
+#ifndef Py_LIMITED_API
+RN_DEFINE_FROM_CHARS(ucs1, uint8_t)
+RN_DEFINE_FROM_CHARS(ucs2, uint16_t)
+#endif
+
+#undef RN_DEFINE_FROM_CHARS
+
+// max length of literals parsed from a buffer on the stack
+#define RN_SHORT_LITERAL_LEN 64
+
+// Copy the content of a str to buf, if it fits into RN_SHORT_LITERAL_LEN
+// code points, otherwise to newly allocated memory to be freed by the caller.
+// (The limited API gives no access to the internal representation of str.)
+static Py_UCS4 *
+rn_str_as_ucs4(PyObject *val, Py_UCS4 *buf, Py_ssize_t *len) {
+    *len = PyUnicode_GetLength(val);
+    if (*len < 0)
+        return NULL;
+    if (*len <= RN_SHORT_LITERAL_LEN)
+        return PyUnicode_AsUCS4(val, buf, RN_SHORT_LITERAL_LEN, 0);
+    return PyUnicode_AsUCS4Copy(val);
+}
+
+static PyObject *
+RationalType_from_str(PyTypeObject *type, PyObject *val) {
+    Py_ssize_t len;
+
+#ifdef Py_LIMITED_API
+    Py_UCS4 short_buf[RN_SHORT_LITERAL_LEN];
+    Py_UCS4 *buf;
+    PyObject *res;
+
+    if ((buf = rn_str_as_ucs4(val, short_buf, &len)) == NULL)
+        return NULL;
+    res = RationalType_from_ucs4_chars(type, buf, len);
+    if (buf != short_buf)
+        PyMem_Free(buf);
+    return res;
+#else
+#if PY_VERSION_HEX < 0x030C0000
+    if (PyUnicode_READY(val) != 0)
+        return NULL;
+#endif
+    len = PyUnicode_GET_LENGTH(val);
+    switch (PyUnicode_KIND(val)) {
+        case PyUnicode_1BYTE_KIND:
+            return RationalType_from_ucs1_chars(type,
+                                                PyUnicode_1BYTE_DATA(val),
+                                                len);
+        case PyUnicode_2BYTE_KIND:
+            return RationalType_from_ucs2_chars(type,
+                                                PyUnicode_2BYTE_DATA(val),
+                                                len);
+        default:
+            return RationalType_from_ucs4_chars(type,
+                                                PyUnicode_4BYTE_DATA(val),
+                                                len);
+    }
+#endif
+}
+
+// Create a Rational from len chars of a formatted literal, which is
+// normalized by the function instantiated for the given kind of chars in
+// parse.h and then parsed as ascii literal
+#define RN_DEFINE_PARSE_CHARS(kind, char_t)                                 \
+static PyObject *                                                           \
+RationalType_parse_##kind##_chars(PyTypeObject *type, const char_t *chars,  \
+                                  Py_ssize_t len,                           \
+                                  const struct rn_literal_fmt *fmt) {       \
+    char short_buf[RN_SHORT_LITERAL_LEN + 1];                               \
+    char *buf = short_buf;                                                  \
+    PyObject *res;                                                          \
+    size_t n;                                                               \
+                                                                            \
+    if (len > RN_SHORT_LITERAL_LEN &&                                       \
+            (buf = PyMem_Malloc((size_t)len + 1)) == NULL)                  \
+        return PyErr_NoMemory();                                            \
+    if (rn_normalize_##kind##_literal(buf, &n, chars, len, fmt) == RN_OK)  \
+        res = RationalType_from_ascii_chars(type, (const uint8_t *)buf,     \
+                                            (Py_ssize_t)n);                 \
+    else                                                                    \
+        res = value_error_ptr("Invalid literal for Rational.");             \
+    if (buf != short_buf)                                                   \
+        PyMem_Free(buf);                                                    \
+    return res;                                                             \
+}
+
+RN_DEFINE_PARSE_CHARS(ucs4, uint32_t)
+#ifndef Py_LIMITED_API
+RN_DEFINE_PARSE_CHARS(ucs1, uint8_t)
+RN_DEFINE_PARSE_CHARS(ucs2, uint16_t)
+#endif
+
+#undef RN_DEFINE_PARSE_CHARS
+
+// Get the single char given as str by obj (or RN_NO_GROUP_SEP, if accepted
+// and obj is None or empty)
+static int
+rn_get_fmt_char(uint32_t *uch, PyObject *obj, const char *name,
+                bool optional) {
+    Py_ssize_t len;
+
+    if (obj == Py_None && optional) {
+        *uch = RN_NO_GROUP_SEP;
+        return 0;
+    }
+    if (!PyUnicode_Check(obj)) { // NOLINT(hicpp-signed-bitwise)
+        PyErr_Format(PyExc_TypeError, "%s must be a str%s.", name,
+                     optional ? " or None" : "");
+        return -1;
+    }
+    len = PyUnicode_GetLength(obj);
+    if (len > 1 || (len == 0 && !optional)) {
+        PyErr_Format(PyExc_ValueError, "%s must be a single char%s.", name,
+                     optional ? " or empty" : "");
+        return -1;
+    }
+    *uch = len == 0 ? RN_NO_GROUP_SEP : PyUnicode_ReadChar(obj, 0);
+    return 0;
+}
+
+static PyObject *
+RationalType_parse(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"s", "decimal_point", "group_sep",
+                               "paren_negative", "trailing_sign", NULL};
+    PyObject *val = NULL;
+    PyObject *decimal_point = NULL;
+    PyObject *group_sep = NULL;
+    int paren_negative = 1;
+    int trailing_sign = 1;
+    struct rn_literal_fmt fmt;
+    Py_ssize_t len;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "U|OOpp", kw_names, &val,
+                                     &decimal_point, &group_sep,
+                                     &paren_negative, &trailing_sign))
+        return NULL;
+    fmt.decimal_point = '.';
+    fmt.group_sep = ',';
+    if (decimal_point != NULL &&
+            rn_get_fmt_char(&fmt.decimal_point, decimal_point,
+                            "decimal_point", false) != 0)
+        return NULL;
+    if (group_sep != NULL &&
+            rn_get_fmt_char(&fmt.group_sep, group_sep, "group_sep",
+                            true) != 0)
+        return NULL;
+    if (fmt.decimal_point == fmt.group_sep)
+        return value_error_ptr(
+            "decimal_point and group_sep must be different.");
+    fmt.paren_negative = paren_negative;
+    fmt.trailing_sign = trailing_sign;
+
+#ifdef Py_LIMITED_API
+    {
+        Py_UCS4 short_buf[RN_SHORT_LITERAL_LEN];
+        Py_UCS4 *buf;
+        PyObject *res;
+
+        if ((buf = rn_str_as_ucs4(val, short_buf, &len)) == NULL)
+            return NULL;
+        res = RationalType_parse_ucs4_chars(type, buf, len, &fmt);
+        if (buf != short_buf)
+            PyMem_Free(buf);
+        return res;
+    }
+#else
+#if PY_VERSION_HEX < 0x030C0000
+    if (PyUnicode_READY(val) != 0)
+        return NULL;
+#endif
+    len = PyUnicode_GET_LENGTH(val);
+    switch (PyUnicode_KIND(val)) {
+        case PyUnicode_1BYTE_KIND:
+            return RationalType_parse_ucs1_chars(type,
+                                                 PyUnicode_1BYTE_DATA(val),
+                                                 len, &fmt);
+        case PyUnicode_2BYTE_KIND:
+            return RationalType_parse_ucs2_chars(type,
+                                                 PyUnicode_2BYTE_DATA(val),
+                                                 len, &fmt);
+        default:
+            return RationalType_parse_ucs4_chars(type,
+                                                 PyUnicode_4BYTE_DATA(val),
+                                                 len, &fmt);
+    }
+#endif
+}
+
+// Create a Rational from a parsed hex literal exceeding 128 bits
+static PyObject *
+RationalType_from_parsed_big_hex(PyTypeObject *type,
+                                 struct rn_parsed_hex_repr *parsed,
+                                 const char *digits) {
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+    PyObject *shift = NULL;
+    PyObject *t = NULL;
+    PyObject *res = NULL;
+
+    ASSIGN_AND_CHECK_NULL(num, PyLong_FromString(digits, NULL, 16));
+    if (parsed->sig_shift > 0) {
+        ASSIGN_AND_CHECK_NULL(shift, PyLong_FromLong(parsed->sig_shift));
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Rshift(num, shift));
+        Py_DECREF(num);
+        num = t;
+        Py_CLEAR(shift);
+    }
+    ASSIGN_AND_CHECK_NULL(shift,
+                          PyLong_FromLongLong(parsed->exp < 0 ?
+                                              -parsed->exp : parsed->exp));
+    if (parsed->exp >= 0) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Lshift(num, shift));
+        Py_DECREF(num);
+        num = t;
+        Py_INCREF(PyONE);
+        den = PyONE;
+    }
+    else
+        ASSIGN_AND_CHECK_NULL(den, PyNumber_Lshift(PyONE, shift));
+    if (parsed->neg) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(num));
+        Py_DECREF(num);
+        num = t;
+    }
+    // num is odd, so num / den is already reduced
+    ASSIGN_AND_CHECK_NULL(res,
+                          RationalType_from_normalized_num_den(type, num,
+                                                               den));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    Py_XDECREF(shift);
+    return res;
+}
+
+static PyObject *
+RationalType_fromhex(PyTypeObject *type, PyObject *val) {
+    Py_UCS4 short_buf[RN_SHORT_LITERAL_LEN];
+    char short_digits[RN_SHORT_LITERAL_LEN + 1];
+    Py_UCS4 *buf;
+    char *digits = short_digits;
+    struct rn_parsed_hex_repr hex;
+    struct rn_parsed_repr parsed;
+    PyObject *res = NULL;
+    Py_ssize_t len;
+    rn_error_t rc;
+
+    if (!PyUnicode_Check(val)) // NOLINT(hicpp-signed-bitwise)
+        return type_error_ptr("Argument must be a str.");
+    if ((buf = rn_str_as_ucs4(val, short_buf, &len)) == NULL)
+        return NULL;
+    if (len > RN_SHORT_LITERAL_LEN &&
+            (digits = PyMem_Malloc((size_t)len + 1)) == NULL) {
+        PyErr_NoMemory();
+        goto CLEAN_UP;
+    }
+    rc = rn_from_hex_literal(&hex, digits, buf, len);
+    if (rc == RN_INVALID_LITERAL)
+        PyErr_SetString(PyExc_ValueError,
+                        "Invalid hexadecimal literal for Rational.");
+    else if (rc == RN_LIMIT_EXCEEDED)
+        PyErr_SetString(PyExc_ValueError,
+                        "Exponent of literal out of range.");
+    else if (rn_parsed_hex_to_repr(&parsed, &hex) == RN_OK)
+        res = RationalType_from_parsed(type, RN_OK, &parsed);
+    else
+        res = RationalType_from_parsed_big_hex(type, &hex, digits);
+
+CLEAN_UP:
+    if (buf != short_buf)
+        PyMem_Free(buf);
+    if (digits != short_digits)
+        PyMem_Free(digits);
+    return res;
+}
+
+// Access to the content of bytes-like objects
+
+#if !defined(Py_LIMITED_API) || Py_LIMITED_API >= 0x030B0000
+#define RN_HAVE_BUFFER_API 1
+#endif
+
+// flag for PyMemoryView_FromMemory, not exposed by the limited API before 3.11
+#ifndef PyBUF_READ
+#define PyBUF_READ 0x100
+#endif
+
+struct rn_bytes_view {
+    const uint8_t *chars;
+    Py_ssize_t len;
+#ifdef RN_HAVE_BUFFER_API
+    Py_buffer buffer;
+    bool is_copy;               // owner is a copy, not the buffer exporter
+#endif
+    PyObject *owner;            // object to be released, if any
+};
+
+// Get a view on the content of a bytes-like object.
+// bytes and bytearray are accessed in place; other objects supporting the
+// buffer protocol are accessed in place only if the buffer API is
+// available and their buffer is C-contiguous, otherwise their content is
+// copied.
+static int
+rn_get_bytes_view(struct rn_bytes_view *view, PyObject *obj) {
+    view->owner = NULL;
+    if (PyBytes_Check(obj)) { // NOLINT(hicpp-signed-bitwise)
+        view->chars = (const uint8_t *)PyBytes_AsString(obj);
+        view->len = PyBytes_Size(obj);
+        return 0;
+    }
+    if (PyByteArray_Check(obj)) {
+        view->chars = (const uint8_t *)PyByteArray_AsString(obj);
+        view->len = PyByteArray_Size(obj);
+        return 0;
+    }
+#ifdef RN_HAVE_BUFFER_API
+    if (PyObject_GetBuffer(obj, &view->buffer, PyBUF_SIMPLE) == 0) {
+        view->chars = view->buffer.buf;
+        view->len = view->buffer.len;
+        view->owner = obj;
+        view->is_copy = false;
+        return 0;
+    }
+    // buffers not C-contiguous are copied, as without the buffer API
+    if (!PyErr_ExceptionMatches(PyExc_BufferError))
+        return -1;
+    PyErr_Clear();
+    view->is_copy = true;
+#endif
+    {
+        PyObject *mv = PyMemoryView_FromObject(obj);
+        if (mv == NULL)
+            return -1;
+        view->owner = PyBytes_FromObject(mv);
+        Py_DECREF(mv);
+        if (view->owner == NULL)
+            return -1;
+        view->chars = (const uint8_t *)PyBytes_AsString(view->owner);
+        view->len = PyBytes_Size(view->owner);
+    }
+    return 0;
+}
+
+// Check whether obj supports the buffer protocol
+static bool
+rn_supports_buffer(PyObject *obj) {
+#ifdef RN_HAVE_BUFFER_API
+    return PyObject_CheckBuffer(obj);
+#else
+    PyObject *mv = PyMemoryView_FromObject(obj);
+    if (mv == NULL) {
+        PyErr_Clear();
+        return false;
+    }
+    Py_DECREF(mv);
+    return true;
+#endif
+}
+
+static void
+rn_release_bytes_view(struct rn_bytes_view *view) {
+    if (view->owner == NULL)
+        return;
+#ifdef RN_HAVE_BUFFER_API
+    if (!view->is_copy) {
+        PyBuffer_Release(&view->buffer);
+        view->owner = NULL;
+        return;
+    }
+#endif
+    Py_DECREF(view->owner);
+    view->owner = NULL;
+}
+
+static PyObject *
+RationalType_from_bytes_like(PyTypeObject *type, PyObject *val) {
+    struct rn_bytes_view view;
+    PyObject *res;
+
+    if (rn_get_bytes_view(&view, val) != 0)
+        return NULL;
+    res = RationalType_from_ascii_chars(type, view.chars, view.len);
+    rn_release_bytes_view(&view);
+    return res;
+}
+
+static PyObject *
+RationalType_from_ascii(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"buffer", "start", "end", NULL};
+    PyObject *buffer = NULL;
+    Py_ssize_t start = 0;
+    Py_ssize_t end = PY_SSIZE_T_MAX;
+    Py_ssize_t len;
+    struct rn_bytes_view view;
+    PyObject *res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|nn", kw_names,
+                                     &buffer, &start, &end))
+        return NULL;
+    if (PyUnicode_Check(buffer)) // NOLINT(hicpp-signed-bitwise)
+        return type_error_ptr("A bytes-like object is required, not 'str'.");
+    if (rn_get_bytes_view(&view, buffer) != 0)
+        return NULL;
+    // same semantics as slicing, i.e. an empty slice if start >= end
+    len = PySlice_AdjustIndices(view.len, &start, &end, 1);
+    res = RationalType_from_ascii_chars(type, view.chars + start, len);
+    rn_release_bytes_view(&view);
+    return res;
+}
+
 static PyObject *
 RationalType_from_float(PyTypeObject *type, PyObject *val) {
     PyObject *res = NULL;
@@ -641,6 +1308,11 @@ RationalType_from_obj(PyTypeObject *type, PyObject *obj) {
     if (PyUnicode_Check(obj)) // NOLINT(hicpp-signed-bitwise)
         return RationalType_from_str(type, obj);
 
+    // bytes, bytearray
+    if (PyBytes_Check(obj) || // NOLINT(hicpp-signed-bitwise)
+            PyByteArray_Check(obj))
+        return RationalType_from_bytes_like(type, obj);
+
     // Python <int>
     if (PyLong_Check(obj)) // NOLINT(hicpp-signed-bitwise)
         return RationalType_from_pylong(type, obj);
@@ -661,25 +1333,57 @@ RationalType_from_obj(PyTypeObject *type, PyObject *obj) {
     if (PyFloat_Check(obj) || PyObject_IsInstance(obj, Real))
         return RationalType_from_float(type, obj);
 
+    // other objects supporting the buffer protocol
+    if (rn_supports_buffer(obj))
+        return RationalType_from_bytes_like(type, obj);
+
     // unable to create Rational
     return PyErr_Format(PyExc_TypeError, "Can't convert %R to Rational.", obj);
 }
 
 static PyObject *
 RationalType_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
-    static char *kw_names[] = {"numerator", "denominator", NULL};
+    static char *kw_names[] = {"numerator", "denominator", "precision",
+                               "rounding", NULL};
     PyObject *numerator = Py_None;
     PyObject *denominator = Py_None;
+    PyObject *precision = Py_None;
+    PyObject *rounding = Py_None;
+    enum RN_ROUNDING_MODE rounding_mode;
+    long to_prec = 0;
+    PyObject *res;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOOO", kw_names,
+                                     &numerator, &denominator, &precision,
+                                     &rounding))
+        return NULL;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO", kw_names,
-                                     &numerator, &denominator))
+    if (precision != Py_None) {
+        if (check_n_convert_prec(precision, &to_prec) != 0 ||
+                rn_rounding_mode_from_obj(&rounding_mode, rounding) != 0)
+            return NULL;
+        // a Rational given to the constructor of Rational is not copied
+        if (denominator == Py_None && type == RationalType &&
+                Rational_Check(numerator))
+            return rn_adjusted((RationalObject *)numerator,
+                               (rn_prec_t)to_prec, rounding_mode);
+    }
+    else if (rounding != Py_None &&
+             rn_rounding_mode_from_obj(&rounding_mode, rounding) != 0)
         return NULL;
 
     if (denominator == Py_None)
-        return (PyObject *)RationalType_from_obj(type, numerator);
-    if (PyObject_RichCompareBool(denominator, PyZERO, Py_EQ))
+        res = RationalType_from_obj(type, numerator);
+    else if (PyObject_RichCompareBool(denominator, PyZERO, Py_EQ))
         return value_error_ptr("Denominator must not be zero.");
-    return RationalType_from_num_den(type, numerator, denominator);
+    else
+        res = RationalType_from_num_den(type, numerator, denominator);
+    // the new instance is rounded in place, without creating another one
+    if (res != NULL && precision != Py_None &&
+            rn_adjust_inplace((RationalObject *)res, (rn_prec_t)to_prec,
+                              rounding_mode) != 0)
+        Py_CLEAR(res);
+    return res;
 }
 
 static inline error_t
@@ -768,18 +1472,29 @@ Rational_precision_get(RationalObject *self, void *closure UNUSED) {
 
 static inline Py_ssize_t
 rn_magnitude(RationalObject *self) {
+    Py_ssize_t magn = self->magn;
+
+    if (magn != RN_UNDEF_MAGN)
+        return magn;
     switch (self->variant) {
         case RN_FPDEC:
-            return rnd_magnitude(self->coeff, self->exp);
+            magn = rnd_magnitude(self->coeff, self->exp);
+            break;
         case RN_U64_QUOT:
-            return rnq_magnitude(self->u64_num, self->u64_den);
+            magn = rnq_magnitude(self->u64_num, self->u64_den);
+            break;
         case RN_PYINT_QUOT:
-            return rnp_magnitude(RN_PYINT_QUOT_PTR(self));
+            magn = rnp_magnitude(RN_PYINT_QUOT_PTR(self));
+            if (PyErr_Occurred())
+                return -1;
+            break;
         default:
             PyErr_SetString(PyExc_RuntimeError,
                             "Corrupted internal representation.");
             return -1;
     }
+    self->magn = magn;
+    return magn;
 }
 
 static PyObject *
@@ -792,11 +1507,9 @@ Rational_magnitude_get(RationalObject *self, void *closure UNUSED) {
     }
     switch (self->variant) {
         case RN_FPDEC:
-            magn = rnd_magnitude(self->coeff, self->exp);
-            return PyLong_FromLong(magn);
         case RN_U64_QUOT:
-            magn = rnq_magnitude(self->u64_num, self->u64_den);
-            return PyLong_FromLong(magn);
+            magn = rn_magnitude(self);
+            return PyLong_FromSsize_t(magn);
         case RN_PYINT_QUOT:
             return rnp_magnitude_pylong(RN_PYINT_QUOT_PTR(self));
         default:
@@ -810,7 +1523,6 @@ static error_t
 rn_assert_num_den(RationalObject *rn) {
     error_t rc = 0;
     PyObject *num = NULL;
-    PyObject *exp = NULL;
 
     if (rn->numerator == NULL) {
         assert(rn->denominator == NULL);
@@ -829,37 +1541,15 @@ rn_assert_num_den(RationalObject *rn) {
                     rn->denominator = PyONE;
                 }
                 else if (rn->exp < 0) {
-                    uint64_t d;
-                    rn_exp_t t = -rn->exp;
-                    if (t < UINT64_10_POW_N_CUTOFF) {
-                        d = u64_10_pow_n(t);
-                        ASSIGN_AND_CHECK_NULL(rn->denominator,
-                                              PyLong_FromLongLong(d));
-                    }
-                    else {
-                        ASSIGN_AND_CHECK_NULL(exp, PyLong_FromLong(t));
-                        ASSIGN_AND_CHECK_NULL(rn->denominator,
-                                              PyNumber_Power(PyTEN, exp,
-                                                             Py_None));
-                    }
+                    ASSIGN_AND_CHECK_NULL(rn->denominator,
+                                          pylong_10_pow_n(-rn->exp));
                 }
                 else {
-                    Py_XDECREF(num);
-                    if (rn->exp < UINT64_10_POW_N_CUTOFF) {
-                        uint64_t t = u64_10_pow_n(rn->exp);
-                        ASSIGN_AND_CHECK_NULL(num, PyLong_FromLong(t));
-                        ASSIGN_AND_CHECK_NULL(rn->numerator,
-                                              PyNumber_InPlaceMultiply
-                                                  (rn->numerator, num));
-                    }
-                    else {
-                        ASSIGN_AND_CHECK_NULL(exp, PyLong_FromLong(rn->exp));
-                        ASSIGN_AND_CHECK_NULL(num, PyNumber_Power(PyTEN, exp,
-                                                                  Py_None));
-                        ASSIGN_AND_CHECK_NULL(rn->numerator,
-                                              PyNumber_InPlaceMultiply
-                                                  (rn->numerator, num));
-                    }
+                    Py_CLEAR(num);
+                    ASSIGN_AND_CHECK_NULL(num, pylong_10_pow_n(rn->exp));
+                    ASSIGN_AND_CHECK_NULL(rn->numerator,
+                                          PyNumber_InPlaceMultiply
+                                              (rn->numerator, num));
                     Py_INCREF(PyONE);
                     rn->denominator = PyONE;
                 }
@@ -870,15 +1560,15 @@ rn_assert_num_den(RationalObject *rn) {
             case RN_U64_QUOT:
                 if (rn->sign == RN_SIGN_NEG) {
                     ASSIGN_AND_CHECK_NULL(num,
-                                          PyLong_FromLongLong(rn->u64_num));
+                                          PyLong_FromUnsignedLongLong(rn->u64_num));
                     ASSIGN_AND_CHECK_NULL(rn->numerator,
                                           PyNumber_Negative(num));
                 }
                 else
                     ASSIGN_AND_CHECK_NULL(rn->numerator,
-                                          PyLong_FromLongLong(rn->u64_num));
+                                          PyLong_FromUnsignedLongLong(rn->u64_num));
                 ASSIGN_AND_CHECK_NULL(rn->denominator,
-                                      PyLong_FromLongLong(rn->u64_den));
+                                      PyLong_FromUnsignedLongLong(rn->u64_den));
                 break;
             default:
                 PyErr_SetString(PyExc_RuntimeError,
@@ -896,7 +1586,6 @@ ERROR:
 
 CLEAN_UP:
     Py_XDECREF(num);
-    Py_XDECREF(exp);
     return rc;
 }
 
@@ -930,18 +1619,179 @@ Rational_imag_get(RationalObject *self UNUSED, void *closure UNUSED) {
 
 // String representation
 
-static PyObject *
-Rational_str(RationalObject *self) {
-    PyObject *res = NULL;
-    char *sign;
+// Policy for the representation of decimal values by str, repr and bytes:
+// exponent notation is used if the positional representation would have
+// more than rn_sci_threshold digits (0: never), engineering notation if
+// rn_sci_engineering is set.
+static size_t rn_sci_threshold = 0;
+static bool rn_sci_engineering = false;
+
+// max length of a fixed-point decimal in exponent notation
+#define RN_SCI_BUF_LEN 80
+
+// Number of digits of the positional representation of the fixed-point
+// decimal self, excluding the sign and the decimal point.
+static inline size_t
+rn_fpdec_n_pos_digits(RationalObject *self) {
+    return rnd_n_chars(false, self->coeff, self->exp) - (self->exp < 0);
+}
+
+static inline bool
+rn_use_sci_notation(RationalObject *self) {
+    return rn_sci_threshold > 0 && self->sign != RN_SIGN_ZERO &&
+           self->variant == RN_FPDEC &&
+           rn_fpdec_n_pos_digits(self) > rn_sci_threshold;
+}
+
+// Number of fractional digits of a reduced quotient with the denominator
+// den = 2 ^ n_2 * 5 ^ n_5, i.e. max(n_2, n_5), or -1 if den has other prime
+// factors, i.e. the quotient is not a decimal value.
+static inline int64_t
+u64_n_frac_digits(uint64_t den) {
+    unsigned n_2 = u64_n_trailing_0_bits(den);
+    unsigned n_5 = 0;
+
+    den >>= n_2;
+    for (; den % 5 == 0; den /= 5)
+        ++n_5;
+    return den == 1 ? (int64_t)MAX(n_2, n_5) : -1;
+}
+
+// Same as u64_n_frac_digits for an int den > 0. Returns -2 on error.
+static int64_t
+rn_pylong_n_frac_digits(PyObject *den) {
+    PyObject *t = NULL;
+    PyObject *low_bit = NULL;
+    PyObject *odd = NULL;
+    PyObject *pow5 = NULL;
+    uint64_t n_2, n_5 = 0, n_bits;
+    int64_t res = -2;
+    int cmp;
+
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(den));
+    ASSIGN_AND_CHECK_NULL(low_bit, PyNumber_And(den, t));
+    ASSIGN_AND_CHECK_NULL(odd, PyNumber_FloorDivide(den, low_bit));
+    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(t, PyObject_CallFunctionObjArgs(PyLong_bit_length,
+                                                          low_bit, NULL));
+    n_2 = PyLong_AsUnsignedLongLong(t) - 1;
+    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(t, PyObject_CallFunctionObjArgs(PyLong_bit_length,
+                                                          odd, NULL));
+    n_bits = PyLong_AsUnsignedLongLong(t);
+    if (PyErr_Occurred())
+        goto ERROR;
+    Py_CLEAR(t);
+    if (n_bits > 1) {
+        // 5 ^ n_5 has floor(n_5 * log2(5)) + 1 bits, so n_5 is the only
+        // candidate
+        n_5 = (uint64_t)((double)n_bits / 2.321928094887362);
+        ASSIGN_AND_CHECK_NULL(t, PyLong_FromUnsignedLongLong(n_5));
+        ASSIGN_AND_CHECK_NULL(pow5, PyNumber_Power(PyFIVE, t, Py_None));
+        if ((cmp = PyObject_RichCompareBool(pow5, odd, Py_EQ)) < 0)
+            goto ERROR;
+        if (!cmp) {
+            res = -1;
+            goto CLEAN_UP;
+        }
+    }
+    res = (int64_t)MAX(n_2, n_5);
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(t);
+    Py_XDECREF(low_bit);
+    Py_XDECREF(odd);
+    Py_XDECREF(pow5);
+    return res;
+}
+
+// Same as rn_use_sci_notation for quotients not held as fixed-point
+// decimal, so that decimal values are represented alike, regardless of
+// their internal representation. Returns -1 on error.
+static int
+rn_quot_use_sci_notation(RationalObject *self) {
+    int64_t n_frac;
+    Py_ssize_t magn;
+
+    if (rn_sci_threshold == 0 || self->sign == RN_SIGN_ZERO)
+        return 0;
+    if (self->variant == RN_U64_QUOT)
+        n_frac = u64_n_frac_digits(self->u64_den);
+    else if ((n_frac = rn_pylong_n_frac_digits(self->denominator)) == -2)
+        return -1;
+    if (n_frac < 0)
+        return 0;
+    if ((uint64_t)n_frac >= rn_sci_threshold)
+        return 1;
+    // the positional representation has max(magn + 1, 1) integral digits
+    if ((magn = rn_magnitude(self)) == -1 && PyErr_Occurred())
+        return -1;
+    return (uint64_t)(MAX(magn + 1, 1) + n_frac) > rn_sci_threshold;
+}
+
+// Exponent notation of the quotient self, which must not be held as
+// fixed-point decimal
+static PyObject *
+rn_quot_to_sci_str(RationalObject *self, bool engineering) {
+    PyObject *num;
+    PyObject *res;
+
+    if (rn_assert_num_den(self) != 0)
+        return NULL;
+    if ((num = PyNumber_Absolute(self->numerator)) == NULL)
+        return NULL;
+    res = rn_pylong_quot_to_sci_str(self->sign == RN_SIGN_NEG, num,
+                                    self->denominator, engineering);
+    Py_DECREF(num);
+    return res;
+}
+
+// Write the fixed-point decimal self in exponent notation to buf, which
+// must have room for RN_SCI_BUF_LEN chars. Returns the number of chars
+// written; no terminating 0 is added.
+static inline size_t
+rn_fpdec_to_sci_chars(char *buf, RationalObject *self, bool engineering) {
+    char digits[UINT128_10_POW_N_CUTOFF + 1];
+    size_t n_digits = u128_to_dec_digits(digits, self->coeff);
+    int64_t exp = self->exp;
+
+    // integral values may have trailing zeros in their coefficient
+    for (; n_digits > 1 && digits[n_digits - 1] == '0'; --n_digits)
+        ++exp;
+    assert(rn_format_sci_max_n_chars(n_digits) <= RN_SCI_BUF_LEN);
+    return rn_format_sci(buf, self->sign == RN_SIGN_NEG, engineering, digits,
+                         n_digits, exp);
+}
+
+static PyObject *
+Rational_str(RationalObject *self) {
+    PyObject *res = NULL;
+    char *sign;
+    int use_sci;
 
     if (self->sign == 0)
         return PyUnicode_FromString("0");
+    if (self->variant != RN_FPDEC &&
+            (use_sci = rn_quot_use_sci_notation(self)) != 0)
+        return use_sci < 0 ? NULL :
+               rn_quot_to_sci_str(self, rn_sci_engineering);
 
     sign = self->sign == RN_SIGN_NEG ? "-" : "";
     switch (self->variant) {
         case RN_FPDEC:
-            res = rnd_to_str(sign, self->coeff, self->exp);
+            if (rn_use_sci_notation(self)) {
+                char buf[RN_SCI_BUF_LEN];
+                size_t n_chars = rn_fpdec_to_sci_chars(buf, self,
+                                                       rn_sci_engineering);
+                res = PyUnicode_FromStringAndSize(buf, (Py_ssize_t)n_chars);
+            }
+            else
+                res = rnd_to_str(self->sign == RN_SIGN_NEG, self->coeff,
+                                 self->exp);
             break;
         case RN_U64_QUOT:
             if (self->u64_den == 1)
@@ -961,11 +1811,116 @@ Rational_str(RationalObject *self) {
     return res;
 }
 
+// ASCII representation of Rational values (the same as str gives)
+
+// max length of representations rendered on the stack
+#define RN_ASCII_SHORT_BUF_LEN 96
+
+struct rn_ascii_repr {
+    char *chars;                // terminated by 0
+    size_t len;
+    PyObject *owner;            // bytes object holding chars, if any
+    char short_buf[RN_ASCII_SHORT_BUF_LEN];
+};
+
+// Number of chars of the representation of self, which must not be a
+// RN_PYINT_QUOT
+static inline size_t
+rn_compact_n_ascii_chars(RationalObject *self) {
+    bool neg = self->sign == RN_SIGN_NEG;
+
+    if (self->sign == RN_SIGN_ZERO)
+        return 1;
+    if (self->variant == RN_FPDEC)
+        return rnd_n_chars(neg, self->coeff, self->exp);
+    return rnq_n_chars(neg, self->u64_num, self->u64_den);
+}
+
+// Write the representation of self, which must not be a RN_PYINT_QUOT,
+// followed by a terminating 0, to buf, which must have room for
+// rn_compact_n_ascii_chars(self) + 1 chars.
+static inline size_t
+rn_compact_to_ascii(char *buf, RationalObject *self) {
+    bool neg = self->sign == RN_SIGN_NEG;
+
+    if (self->sign == RN_SIGN_ZERO) {
+        buf[0] = '0';
+        buf[1] = 0;
+        return 1;
+    }
+    if (self->variant == RN_FPDEC)
+        return rnd_to_chars(buf, neg, self->coeff, self->exp);
+    return rnq_to_chars(buf, neg, self->u64_num, self->u64_den);
+}
+
+// Get the representation of self as ASCII chars. Fixed-point decimals and
+// 64-bit quotients are rendered directly, only quotients of Python ints and
+// 64-bit quotients in exponent notation take the detour via str.
+static int
+rn_get_ascii_repr(struct rn_ascii_repr *repr, RationalObject *self) {
+    PyObject *ustr;
+
+    repr->owner = NULL;
+    if (rn_use_sci_notation(self)) {
+        repr->chars = repr->short_buf;
+        repr->len = rn_fpdec_to_sci_chars(repr->chars, self,
+                                          rn_sci_engineering);
+        repr->chars[repr->len] = 0;
+        return 0;
+    }
+    if (self->sign == RN_SIGN_ZERO || self->variant == RN_FPDEC ||
+            (self->variant == RN_U64_QUOT &&
+             rn_quot_use_sci_notation(self) == 0)) {
+        repr->len = rn_compact_n_ascii_chars(self);
+        if (repr->len < RN_ASCII_SHORT_BUF_LEN)
+            repr->chars = repr->short_buf;
+        else if ((repr->chars = PyMem_Malloc(repr->len + 1)) == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        rn_compact_to_ascii(repr->chars, self);
+        return 0;
+    }
+    if ((ustr = Rational_str(self)) == NULL)
+        return -1;
+    repr->owner = PyUnicode_AsASCIIString(ustr);
+    Py_DECREF(ustr);
+    if (repr->owner == NULL)
+        return -1;
+    repr->chars = PyBytes_AsString(repr->owner);
+    repr->len = (size_t)PyBytes_Size(repr->owner);
+    return 0;
+}
+
+static void
+rn_release_ascii_repr(struct rn_ascii_repr *repr) {
+    if (repr->owner != NULL)
+        Py_CLEAR(repr->owner);
+    else if (repr->chars != repr->short_buf)
+        PyMem_Free(repr->chars);
+    repr->chars = NULL;
+}
+
 static PyObject *
 Rational_bytes(RationalObject *self, PyObject *args UNUSED) {
     PyObject *res = NULL;
     PyObject *ustr = NULL;
 
+    if (rn_use_sci_notation(self)) {
+        char buf[RN_SCI_BUF_LEN];
+        size_t n_chars = rn_fpdec_to_sci_chars(buf, self, rn_sci_engineering);
+        return PyBytes_FromStringAndSize(buf, (Py_ssize_t)n_chars);
+    }
+    if (self->sign == RN_SIGN_ZERO || self->variant == RN_FPDEC ||
+            (self->variant == RN_U64_QUOT &&
+             rn_quot_use_sci_notation(self) == 0)) {
+        // bytes objects have room for a terminating 0
+        size_t len = rn_compact_n_ascii_chars(self);
+        res = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)len);
+        if (res != NULL)
+            rn_compact_to_ascii(PyBytes_AsString(res), self);
+        return res;
+    }
     ustr = Rational_str(self);
     if (ustr) {
         res = PyUnicode_AsASCIIString(ustr);
@@ -974,23 +1929,216 @@ Rational_bytes(RationalObject *self, PyObject *args UNUSED) {
     return res;
 }
 
+#ifndef RN_HAVE_BUFFER_API
+// Get the truth value of attribute name of obj, or -1 on error
+static int
+rn_get_bool_attr(PyObject *obj, const char *name) {
+    PyObject *attr = PyObject_GetAttrString(obj, name);
+    int res;
+
+    if (attr == NULL)
+        return -1;
+    res = PyObject_IsTrue(attr);
+    Py_DECREF(attr);
+    return res;
+}
+#endif
+
+// Check that a buffer to be written to is writable and C-contiguous, with
+// the same exceptions for both ways of access used by rn_write_to_buffer.
+static int
+rn_check_target_buffer(bool readonly, bool c_contiguous) {
+    if (readonly) {
+        PyErr_SetString(PyExc_TypeError, "cannot modify read-only memory");
+        return -1;
+    }
+    if (!c_contiguous) {
+        PyErr_SetString(PyExc_BufferError, "Buffer is not C-contiguous.");
+        return -1;
+    }
+    return 0;
+}
+
+// Copy len chars to buffer[offset:offset + len]. bytearray is written in
+// place; other objects supporting the buffer protocol are written in place
+// only if the buffer API is available, otherwise via slice assignment to a
+// memoryview.
+static int
+rn_write_to_buffer(PyObject *buffer, Py_ssize_t offset, const char *chars,
+                   Py_ssize_t len) {
+    Py_ssize_t size;
+    char *target = NULL;
+    int rc = -1;
+#ifdef RN_HAVE_BUFFER_API
+    Py_buffer view;
+    bool has_view = false;
+#else
+    PyObject *view = NULL;
+    PyObject *src = NULL;
+#endif
+
+    if (PyByteArray_Check(buffer)) {
+        target = PyByteArray_AsString(buffer);
+        size = PyByteArray_Size(buffer);
+    }
+    else {
+#ifdef RN_HAVE_BUFFER_API
+        // get any buffer, so that the reason for rejecting it is known
+        if (PyObject_GetBuffer(buffer, &view, PyBUF_FULL_RO) != 0)
+            return -1;
+        has_view = true;
+        if (rn_check_target_buffer(view.readonly,
+                                   PyBuffer_IsContiguous(&view, 'C')) != 0)
+            goto CLEAN_UP;
+        target = view.buf;
+        size = view.len;
+#else
+        PyObject *mv;
+        int readonly, c_contiguous;
+        if ((mv = PyMemoryView_FromObject(buffer)) == NULL)
+            return -1;
+        if ((readonly = rn_get_bool_attr(mv, "readonly")) < 0 ||
+                (c_contiguous = rn_get_bool_attr(mv, "c_contiguous")) < 0 ||
+                rn_check_target_buffer(readonly, c_contiguous) != 0) {
+            Py_DECREF(mv);
+            return -1;
+        }
+        view = PyObject_CallMethod(mv, "cast", "s", "B");
+        Py_DECREF(mv);
+        if (view == NULL)
+            return -1;
+        if ((size = PyObject_Length(view)) < 0)
+            goto CLEAN_UP;
+#endif
+    }
+    if (offset > size || len > size - offset) {
+        PyErr_Format(PyExc_ValueError,
+                     "Writing %zd bytes at offset %zd requires a buffer of "
+                     "at least %zd bytes, but it has only %zd bytes.",
+                     len, offset, offset + len, size);
+        goto CLEAN_UP;
+    }
+    if (target != NULL)
+        memcpy(target + offset, chars, (size_t)len);
+#ifndef RN_HAVE_BUFFER_API
+    else {
+        // chars is only read, so casting away const is safe here
+        src = PyMemoryView_FromMemory((char *)chars, len, PyBUF_READ);
+        if (src == NULL ||
+                PySequence_SetSlice(view, offset, offset + len, src) != 0)
+            goto CLEAN_UP;
+    }
+#endif
+    rc = 0;
+
+CLEAN_UP:
+#ifdef RN_HAVE_BUFFER_API
+    if (has_view)
+        PyBuffer_Release(&view);
+#else
+    Py_XDECREF(view);
+    Py_XDECREF(src);
+#endif
+    return rc;
+}
+
+static PyObject *
+Rational_write_into(RationalObject *self, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"buffer", "offset", NULL};
+    PyObject *buffer = NULL;
+    Py_ssize_t offset = 0;
+    struct rn_ascii_repr repr;
+    PyObject *res = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|n", kw_names, &buffer,
+                                     &offset))
+        return NULL;
+    if (offset < 0) {
+        PyErr_SetString(PyExc_ValueError, "offset must be >= 0.");
+        return NULL;
+    }
+    if (rn_get_ascii_repr(&repr, self) != 0)
+        return NULL;
+    if (rn_write_to_buffer(buffer, offset, repr.chars,
+                           (Py_ssize_t)repr.len) == 0)
+        res = PyLong_FromSsize_t(offset + (Py_ssize_t)repr.len);
+    rn_release_ascii_repr(&repr);
+    return res;
+}
+
+// Name of a type as shown by repr. Heap types (Rational and all its
+// subclasses) hold their current name, which is replaced when the type is
+// renamed, so it is taken from there, if accessible. Otherwise it has to be
+// looked up as attribute.
+#if !defined(Py_LIMITED_API) || Py_LIMITED_API >= 0x030B0000
+#define RN_HAVE_TYPE_NAME_API 1
+#endif
+
+#ifdef RN_HAVE_TYPE_NAME_API
+static inline PyObject *
+rn_type_name(PyTypeObject *type) {
+#if PY_VERSION_HEX >= 0x030B0000
+    return PyType_GetName(type);
+#else
+    PyObject *name;
+
+    assert(PyType_HasFeature(type, Py_TPFLAGS_HEAPTYPE));
+    name = ((PyHeapTypeObject *)type)->ht_name;
+    Py_INCREF(name);
+    return name;
+#endif
+}
+#else
+// interned attribute name, initialized on import of the module
+static PyObject *PyStr__name__ = NULL;
+
+static inline PyObject *
+rn_type_name(PyTypeObject *type) {
+    return PyObject_GetAttr((PyObject *)type, PyStr__name__);
+}
+#endif
+
 static PyObject *
 Rational_repr(RationalObject *self) {
     PyObject *res = NULL;
     PyObject *cls_name = NULL;
-    cls_name = PyObject_GetAttrString((PyObject *)Py_TYPE(self), "__name__");
-    if (cls_name == NULL)
+    PyObject *str;
+    struct rn_ascii_repr repr;
+    int use_sci;
+
+    if ((cls_name = rn_type_name(Py_TYPE(self))) == NULL)
         return NULL;
+    if (self->variant != RN_FPDEC &&
+            (use_sci = rn_quot_use_sci_notation(self)) != 0) {
+        if (use_sci > 0 &&
+                (str = rn_quot_to_sci_str(self, rn_sci_engineering)) != NULL) {
+            res = PyUnicode_FromFormat("%U('%U')", cls_name, str);
+            Py_DECREF(str);
+        }
+        Py_DECREF(cls_name);
+        return res;
+    }
     switch (self->variant) {
         case RN_FPDEC:
-            if (self->exp < 0)
-                res = PyUnicode_FromFormat("%S('%S')", cls_name, self);
+            // rendered once, without creating an intermediate str
+            if (rn_get_ascii_repr(&repr, self) != 0)
+                break;
+            if (self->exp < 0 || rn_use_sci_notation(self))
+                res = PyUnicode_FromFormat("%U('%s')", cls_name, repr.chars);
             else
-                res = PyUnicode_FromFormat("%S(%S)", cls_name, self);
+                res = PyUnicode_FromFormat("%U(%s)", cls_name, repr.chars);
+            rn_release_ascii_repr(&repr);
+            break;
+        case RN_U64_QUOT:
+            res = PyUnicode_FromFormat("%U(%s%llu, %llu)", cls_name,
+                                       self->sign == RN_SIGN_NEG ? "-" : "",
+                                       (unsigned long long)self->u64_num,
+                                       (unsigned long long)self->u64_den);
             break;
         default:
-            rn_assert_num_den(self);
-            res = PyUnicode_FromFormat("%S(%S, %S)", cls_name,
+            if (rn_assert_num_den(self) != 0)
+                break;
+            res = PyUnicode_FromFormat("%U(%S, %S)", cls_name,
                                        self->numerator, self->denominator);
             break;
     }
@@ -998,76 +2146,982 @@ Rational_repr(RationalObject *self) {
     return res;
 }
 
+// Hexadecimal representation of (-1) ^ neg * num / den with num > 0 and
+// den being a power of 2, for values exceeding the compact representations
 static PyObject *
-Rational_format(RationalObject *self, PyObject *fmt_spec) {
+rn_pylong_quot_to_hex(bool neg, PyObject *num, PyObject *den) {
+    PyObject *sig = NULL;
+    PyObject *t = NULL;
+    PyObject *shift = NULL;
+    PyObject *hex_str = NULL;
+    PyObject *frac_digits = NULL;
     PyObject *res = NULL;
-/*
-    PyObject *utf8_fmt_spec = NULL;
-    uint8_t *formatted = NULL;
-
-    ASSIGN_AND_CHECK_NULL(utf8_fmt_spec, PyUnicode_AsUTF8String(fmt_spec));
-    formatted = fpdec_formatted(&self->coeff,
-                                (uint8_t *)PyBytes_AsString(utf8_fmt_spec));
-    if (formatted == NULL)
-        CHECK_FPDEC_ERROR(errno);
-    ASSIGN_AND_CHECK_NULL(res, PyUnicode_FromString((char *)formatted));
+    long long n_den_bits, n_trailing_0_bits, n_frac_bits, n_frac_digits, exp;
+
+#define ASSIGN_BIT_LENGTH(n, x)                                             \
+    do {                                                                    \
+        ASSIGN_AND_CHECK_NULL(t,                                            \
+                              PyObject_CallFunctionObjArgs(                 \
+                                  PyLong_bit_length, x, NULL));             \
+        n = PyLong_AsLongLong(t);                                           \
+        Py_CLEAR(t);                                                        \
+    } while (0)
+
+    // den = 2 ^ (n_den_bits - 1)
+    ASSIGN_BIT_LENGTH(n_den_bits, den);
+    // drop trailing zero bits of num
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(num));
+    ASSIGN_AND_CHECK_NULL(sig, PyNumber_And(num, t));
+    Py_CLEAR(t);
+    ASSIGN_BIT_LENGTH(n_trailing_0_bits, sig);
+    --n_trailing_0_bits;
+    Py_CLEAR(sig);
+    ASSIGN_AND_CHECK_NULL(shift, PyLong_FromLongLong(n_trailing_0_bits));
+    ASSIGN_AND_CHECK_NULL(sig, PyNumber_Rshift(num, shift));
+    Py_CLEAR(shift);
+    // sig = 1.<frac bits> * 2 ^ n_frac_bits
+    ASSIGN_BIT_LENGTH(n_frac_bits, sig);
+    --n_frac_bits;
+    exp = n_trailing_0_bits - (n_den_bits - 1) + n_frac_bits;
+    // align the fraction bits to whole hex digits; the leading 1 then
+    // becomes a hex digit of its own
+    n_frac_digits = (n_frac_bits + 3) / 4;
+    ASSIGN_AND_CHECK_NULL(shift,
+                          PyLong_FromLongLong(4 * n_frac_digits -
+                                              n_frac_bits));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Lshift(sig, shift));
+    ASSIGN_AND_CHECK_NULL(hex_str, PyNumber_ToBase(t, 16));
+    // skip "0x1"
+    ASSIGN_AND_CHECK_NULL(frac_digits,
+                          PyUnicode_Substring(hex_str, 3, PY_SSIZE_T_MAX));
+    ASSIGN_AND_CHECK_NULL(res,
+                          PyUnicode_FromFormat("%s0x1%s%Up%s%lld",
+                                               neg ? "-" : "",
+                                               n_frac_digits > 0 ? "." : "",
+                                               frac_digits,
+                                               exp < 0 ? "-" : "+",
+                                               exp < 0 ? -exp : exp));
     goto CLEAN_UP;
 
+#undef ASSIGN_BIT_LENGTH
+
 ERROR:
     assert(PyErr_Occurred());
 
 CLEAN_UP:
-    Py_XDECREF(utf8_fmt_spec);
-    fpdec_mem_free(formatted);
-*/
+    Py_XDECREF(sig);
+    Py_XDECREF(t);
+    Py_XDECREF(shift);
+    Py_XDECREF(hex_str);
+    Py_XDECREF(frac_digits);
     return res;
 }
 
+static PyObject *
+Rational_hex(RationalObject *self, PyObject *args UNUSED) {
+    char buf[RN_HEX_MAX_N_CHARS];
+    bool neg = self->sign == RN_SIGN_NEG;
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+    PyObject *t = NULL;
+    PyObject *mask = NULL;
+    PyObject *res = NULL;
+    uint128_t sig;
+    int64_t exp;
+
+    if (self->sign == RN_SIGN_ZERO)
+        return PyUnicode_FromString("0x0p+0");
+    switch (self->variant) {
+        case RN_FPDEC:
+            if (self->exp == 0) {
+                sig = self->coeff;
+                exp = 0;
+            }
+            else if (self->exp < 0 && self->exp >= -UINT64_10_POW_N_CUTOFF) {
+                // coeff / 10 ^ n = (coeff / 5 ^ n) / 2 ^ n
+                sig = self->coeff;
+                exp = self->exp;
+                if (u128_idiv_u64(&sig, u64_10_pow_n(-exp) >> -exp) != 0)
+                    goto NOT_DYADIC;
+            }
+            else
+                goto PYINT_QUOT;
+            break;
+        case RN_U64_QUOT:
+            if ((self->u64_den & (self->u64_den - 1)) != 0)
+                goto NOT_DYADIC;
+            U128_FROM_LO_HI(&sig, self->u64_num, 0ULL);
+            exp = -(int64_t)u64_n_trailing_0_bits(self->u64_den);
+            break;
+        default:
+            goto PYINT_QUOT;
+    }
+    rn_hex_to_chars(buf, neg, sig, exp);
+    return PyUnicode_FromString(buf);
 
-// Special methods
+PYINT_QUOT:
+    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
+    // den must be a power of 2
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Subtract(den, PyONE));
+    ASSIGN_AND_CHECK_NULL(mask, PyNumber_And(den, t));
+    if (PyObject_RichCompareBool(mask, PyZERO, Py_NE))
+        goto NOT_DYADIC;
+    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Absolute(num));
+    ASSIGN_AND_CHECK_NULL(res, rn_pylong_quot_to_hex(neg, t, den));
+    goto CLEAN_UP;
 
-static Py_hash_t
-Rational_hash(RationalObject *self) {
-    Py_hash_t res = self->hash;
+NOT_DYADIC:
+    PyErr_Format(PyExc_ValueError,
+                 "%R has no finite hexadecimal representation.", self);
 
-    if (res != -1)
-        return res;
+ERROR:
+    assert(PyErr_Occurred());
 
-    PyObject *inv_den = NULL;
-    PyObject *abs_num = NULL;
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    Py_XDECREF(t);
+    Py_XDECREF(mask);
+    return res;
+}
+
+// Exact decimal expansion
+
+// "[-]<int_digits>[.<prefix>[(<period>)]]" for the fraction r / den, which
+// must be reduced
+static PyObject *
+rn_u64_dec_expansion_as_str(bool neg, const char *int_digits, size_t n_int,
+                            uint64_t r, uint64_t den, uint64_t max_n_digits) {
+    uint64_t n_prefix = 0;
+    uint64_t n_period = 0;
+    uint64_t n_chars;
+    char *buf, *cp;
+    PyObject *res;
+
+    if (r != 0)
+        u64_dec_expansion_lengths(&n_prefix, &n_period, den);
+    if (n_prefix + n_period > max_n_digits) {
+        PyErr_Format(PyExc_ValueError,
+                     "Decimal expansion exceeds %llu fractional digits.",
+                     (unsigned long long)max_n_digits);
+        return NULL;
+    }
+    // sign, '.', '(' and ')'
+    n_chars = n_int + n_prefix + n_period + 4;
+    if (n_prefix + n_period >= (uint64_t)PY_SSIZE_T_MAX - n_chars)
+        return PyErr_NoMemory();
+    if ((buf = PyMem_Malloc((size_t)n_chars)) == NULL)
+        return PyErr_NoMemory();
+    cp = buf;
+    if (neg)
+        *cp++ = '-';
+    memcpy(cp, int_digits, n_int);
+    cp += n_int;
+    if (r != 0) {
+        *cp++ = '.';
+        cp = u64_write_frac_digits(cp, r, den, n_prefix);
+        if (n_period > 0) {
+            // the remainder after the prefix starts the period
+            uint128_t t;
+            for (uint64_t n = n_prefix; n > 0;) {
+                unsigned k = n < UINT64_10_POW_N_CUTOFF ?
+                             (unsigned)n : UINT64_10_POW_N_CUTOFF;
+                u64_mul_u64(&t, r, u64_10_pow_n(k));
+                r = u128_idiv_u64(&t, den);
+                n -= k;
+            }
+            *cp++ = '(';
+            cp = u64_write_frac_digits(cp, r, den, n_period);
+            *cp++ = ')';
+        }
+    }
+    res = PyUnicode_FromStringAndSize(buf, cp - buf);
+    PyMem_Free(buf);
+    return res;
+}
+
+// Split den > 0 into 2 ^ n_2 * 5 ^ n_5 * d with d coprime to 10. Returns a
+// new reference to d.
+static PyObject *
+rn_pylong_split_off_2_5(PyObject *den, uint64_t *n_2, uint64_t *n_5) {
+    PyObject *res = NULL;
     PyObject *t = NULL;
+    PyObject *low_bit = NULL;
+    PyObject *n_bits = NULL;
+    PyObject *qr = NULL;
+    int cmp;
+
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(den));
+    ASSIGN_AND_CHECK_NULL(low_bit, PyNumber_And(den, t));
+    ASSIGN_AND_CHECK_NULL(n_bits,
+                          PyObject_CallMethod(low_bit, "bit_length", NULL));
+    *n_2 = PyLong_AsUnsignedLongLong(n_bits) - 1;
+    *n_5 = 0;
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_FloorDivide(den, low_bit));
+    for (;;) {
+        ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(res, PyFIVE));
+        if ((cmp = PyObject_RichCompareBool(PyTuple_GetItem(qr, 1), PyZERO,
+                                            Py_NE)) != 0)
+            break;
+        Py_DECREF(res);
+        res = PyTuple_GetItem(qr, 0);
+        Py_INCREF(res);
+        Py_CLEAR(qr);
+        ++*n_5;
+    }
+    if (cmp < 0)
+        goto ERROR;
+    goto CLEAN_UP;
 
-    rn_assert_num_den(self);
-    /* To make sure that the hash of a Rational equals the hash of a
-     * numerically equal integer, float or Fraction instance, we follow the
-     * implementation in fractions.py.
-     * For the general rules for numeric hashes see the library docs,
-     * 'Built-in Types' / 'Hashing of numeric types'. */
-    ASSIGN_AND_CHECK_NULL(inv_den, PyNumber_Power(self->denominator,
-                                                  PyHASH_MODULUS_2,
-                                                  PyHASH_MODULUS));
-    if (PyObject_RichCompareBool(inv_den, PyZERO, Py_EQ))
-        res = PyLong_AsLong(PyHASH_INF);
+ERROR:
+    assert(PyErr_Occurred());
+    Py_CLEAR(res);
+
+CLEAN_UP:
+    Py_XDECREF(t);
+    Py_XDECREF(low_bit);
+    Py_XDECREF(n_bits);
+    Py_XDECREF(qr);
+    return res;
+}
+
+// Max length of the period searched for by rn_u128_mult_order_10. Longer
+// decimal expansions would need more than 16 GiB.
+#define RN_U128_MAX_N_PERIOD_DIGITS (1ULL << 34U)
+
+// Get the multiplicative order of 10 modulo n (see u128_mult_order_10),
+// if it does not exceed limit, otherwise 0.
+// Returns 0 on success, -1 on error.
+static int
+rn_u128_mult_order_10(uint64_t *order, const uint128_t *n, uint64_t limit) {
+    size_t table_size = u128_mult_order_10_table_size(limit);
+    struct u128_baby_step *table;
+
+    table = PyMem_Calloc(table_size, sizeof(struct u128_baby_step));
+    if (table == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    *order = u128_mult_order_10(n, limit, table, table_size);
+    PyMem_Free(table);
+    return 0;
+}
+
+// Same as rn_u64_dec_expansion_as_str for denominators exceeding 64 bits.
+// If the part of den coprime to 10 fits into 128 bits, the lengths are
+// computed upfront and the digits are derived from a single division,
+// otherwise the period is detected by the recurrence of the remainder.
+static PyObject *
+rn_pylong_dec_expansion_as_str(bool neg, PyObject *int_str, PyObject *r,
+                               PyObject *den, uint64_t max_n_digits) {
+    PyObject *res = NULL;
+    PyObject *t = NULL;
+    PyObject *qr = NULL;
+    PyObject *r_start = NULL;
+    PyObject *digits = NULL;
+    PyObject *prefix = NULL;
+    PyObject *period = NULL;
+    PyObject *hi = NULL;
+    PyObject *lo = NULL;
+    char *buf = NULL;
+    size_t buf_size = 64;
+    uint64_t n_digits = 0;
+    uint64_t n_prefix;
+    uint64_t n_period;
+    uint64_t n_2, n_5;
+    uint128_t cofactor;
+    int cmp;
+
+    Py_INCREF(r);
+    // number of non-repeating digits: max(n_2, n_5) for den = 2 ^ n_2 *
+    // 5 ^ n_5 * d with d coprime to 10
+    ASSIGN_AND_CHECK_NULL(t, rn_pylong_split_off_2_5(den, &n_2, &n_5));
+    n_prefix = MAX(n_2, n_5);
+    if (n_prefix > max_n_digits)
+        goto TOO_LONG;
+
+    // cofactor fits into uint128?
+    ASSIGN_AND_CHECK_NULL(hi, PyNumber_Rshift(t, Py64));
+    ASSIGN_AND_CHECK_NULL(lo, PyNumber_And(t, PyUInt64Max));
+    Py_CLEAR(t);
+    U128_FROM_LO_HI(&cofactor,
+                    PyLong_AsUnsignedLongLong(lo),
+                    PyLong_AsUnsignedLongLong(hi));
+    if (!PyErr_Occurred()) {
+        PyObject *pow10;
+        if (U128_HI(cofactor) != 0) {
+            // the order is only searched for up to the number of digits
+            // which could be generated
+            uint64_t limit = MIN(max_n_digits - n_prefix,
+                                 RN_U128_MAX_N_PERIOD_DIGITS);
+            if (rn_u128_mult_order_10(&n_period, &cofactor, limit) != 0)
+                goto ERROR;
+            if (n_period == 0) {
+                if (limit < max_n_digits - n_prefix) {
+                    PyErr_NoMemory();
+                    goto ERROR;
+                }
+                goto TOO_LONG;
+            }
+        }
+        else if (U128_LO(cofactor) == 1)
+            n_period = 0;
+        else
+            n_period = u64_mult_order_10(U128_LO(cofactor));
+        n_digits = n_prefix + n_period;
+        if (n_digits > max_n_digits)
+            goto TOO_LONG;
+        if (n_digits > PY_SSIZE_T_MAX / 4) {
+            PyErr_NoMemory();
+            goto ERROR;
+        }
+        // digits = r * 10 ^ n_digits // den, left-padded with zeros
+        ASSIGN_AND_CHECK_NULL(pow10, pylong_10_pow_n((Py_ssize_t)n_digits));
+        t = PyNumber_Multiply(r, pow10);
+        Py_DECREF(pow10);
+        if (t == NULL)
+            goto ERROR;
+        ASSIGN_AND_CHECK_NULL(qr, PyNumber_FloorDivide(t, den));
+        if ((buf = PyMem_Malloc(MAX(n_digits, 1))) == NULL) {
+            PyErr_NoMemory();
+            goto ERROR;
+        }
+        if (pylong_write_dec_digits(buf, qr, (size_t)n_digits) != 0)
+            goto ERROR;
+    }
     else {
-        // Optimized implementation from Python 3.9
-        ASSIGN_AND_CHECK_NULL(abs_num, PyNumber_Absolute(self->numerator));
-        ASSIGN_AND_CHECK_NULL(t,
-                              PyLong_FromLongLong(PyObject_Hash(abs_num)));
-        ASSIGN_AND_CHECK_NULL(t, PyNumber_InPlaceMultiply(t, inv_den));
-        res = PyObject_Hash(t);
+        PyErr_Clear();
+        if ((buf = PyMem_Malloc(buf_size)) == NULL) {
+            PyErr_NoMemory();
+            goto ERROR;
+        }
+        for (;;) {
+            if (n_digits == n_prefix) {
+                Py_INCREF(r);
+                r_start = r;
+            }
+            else if (n_digits > n_prefix) {
+                if ((cmp = PyObject_RichCompareBool(r, r_start, Py_EQ)) < 0)
+                    goto ERROR;
+                if (cmp)
+                    break;
+            }
+            if (n_digits == max_n_digits)
+                goto TOO_LONG;
+            // the period may be very long, so keep the loop interruptible
+            if (PyErr_CheckSignals() != 0)
+                goto ERROR;
+            if (n_digits == buf_size) {
+                char *new_buf = PyMem_Realloc(buf, 2 * buf_size);
+                if (new_buf == NULL) {
+                    PyErr_NoMemory();
+                    goto ERROR;
+                }
+                buf = new_buf;
+                buf_size *= 2;
+            }
+            Py_CLEAR(t);
+            Py_CLEAR(qr);
+            ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(r, PyTEN));
+            ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(t, den));
+            buf[n_digits++] =
+                (char)('0' + PyLong_AsLong(PyTuple_GetItem(qr, 0)));
+            Py_DECREF(r);
+            r = PyTuple_GetItem(qr, 1);
+            Py_INCREF(r);
+        }
+    }
+    ASSIGN_AND_CHECK_NULL(digits, PyUnicode_FromStringAndSize(buf, (Py_ssize_t)
+                                                              n_digits));
+
+    ASSIGN_AND_CHECK_NULL(prefix, PyUnicode_Substring(digits, 0, (Py_ssize_t)
+                                                      n_prefix));
+    if (n_digits > n_prefix) {
+        ASSIGN_AND_CHECK_NULL(period,
+                              PyUnicode_Substring(digits, (Py_ssize_t)n_prefix,
+                                                  (Py_ssize_t)n_digits));
+        res = PyUnicode_FromFormat("%s%U.%U(%U)", neg ? "-" : "", int_str,
+                                   prefix, period);
+    }
+    else
+        res = PyUnicode_FromFormat("%s%U.%U", neg ? "-" : "", int_str,
+                                   prefix);
+    goto CLEAN_UP;
+
+TOO_LONG:
+    PyErr_Format(PyExc_ValueError,
+                 "Decimal expansion exceeds %llu fractional digits.",
+                 (unsigned long long)max_n_digits);
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    PyMem_Free(buf);
+    Py_DECREF(r);
+    Py_XDECREF(t);
+    Py_XDECREF(qr);
+    Py_XDECREF(r_start);
+    Py_XDECREF(digits);
+    Py_XDECREF(prefix);
+    Py_XDECREF(period);
+    Py_XDECREF(hi);
+    Py_XDECREF(lo);
+    return res;
+}
+
+// Exponent notation of (-1) ^ neg * num / den, num > 0, for quotients not
+// held as fixed-point decimal. Returns NULL and sets a ValueError, if den is
+// not of the form 2 ^ n_2 * 5 ^ n_5.
+static PyObject *
+rn_pylong_quot_to_sci_str(bool neg, PyObject *num, PyObject *den,
+                          bool engineering) {
+    PyObject *res = NULL;
+    PyObject *cofactor = NULL;
+    PyObject *coeff = NULL;
+    PyObject *t = NULL;
+    PyObject *pow5 = NULL;
+    PyObject *str = NULL;
+    PyObject *ascii = NULL;
+    const char *digits;
+    char *buf = NULL;
+    size_t n_digits;
+    uint64_t n_2, n_5, n;
+    int64_t exp;
+    int cmp;
+
+    ASSIGN_AND_CHECK_NULL(cofactor, rn_pylong_split_off_2_5(den, &n_2, &n_5));
+    if ((cmp = PyObject_RichCompareBool(cofactor, PyONE, Py_NE)) != 0) {
+        if (cmp > 0)
+            PyErr_SetString(PyExc_ValueError,
+                            "Value has no finite decimal representation.");
+        goto ERROR;
+    }
+    // num / den = num * 2 ^ (n - n_2) * 5 ^ (n - n_5) / 10 ^ n
+    n = MAX(n_2, n_5);
+    ASSIGN_AND_CHECK_NULL(t, PyLong_FromUnsignedLongLong(n - n_2));
+    ASSIGN_AND_CHECK_NULL(coeff, PyNumber_Lshift(num, t));
+    Py_CLEAR(t);
+    if (n > n_5) {
+        ASSIGN_AND_CHECK_NULL(t, PyLong_FromUnsignedLongLong(n - n_5));
+        ASSIGN_AND_CHECK_NULL(pow5, PyNumber_Power(PyFIVE, t, Py_None));
+        Py_CLEAR(t);
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(coeff, pow5));
+        Py_DECREF(coeff);
+        coeff = t;
+        t = NULL;
+    }
+    ASSIGN_AND_CHECK_NULL(str, pylong_to_dec_str(coeff));
+    ASSIGN_AND_CHECK_NULL(ascii, PyUnicode_AsASCIIString(str));
+    digits = PyBytes_AsString(ascii);
+    n_digits = (size_t)PyBytes_Size(ascii);
+    exp = -(int64_t)n;
+    for (; n_digits > 1 && digits[n_digits - 1] == '0'; --n_digits)
+        ++exp;
+    if ((buf = PyMem_Malloc(rn_format_sci_max_n_chars(n_digits))) == NULL) {
+        PyErr_NoMemory();
+        goto ERROR;
+    }
+    res = PyUnicode_FromStringAndSize(buf, (Py_ssize_t)rn_format_sci(
+        buf, neg, engineering, digits, n_digits, exp));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    PyMem_Free(buf);
+    Py_XDECREF(cofactor);
+    Py_XDECREF(coeff);
+    Py_XDECREF(t);
+    Py_XDECREF(pow5);
+    Py_XDECREF(str);
+    Py_XDECREF(ascii);
+    return res;
+}
+
+static PyObject *
+Rational_to_sci_str(RationalObject *self, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"engineering", NULL};
+    int engineering = 0;
+    char buf[RN_SCI_BUF_LEN];
+    size_t n_chars;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kw_names,
+                                     &engineering))
+        return NULL;
+    if (self->sign == RN_SIGN_ZERO)
+        n_chars = rn_format_sci(buf, false, engineering, "0", 1, 0);
+    else if (self->variant == RN_FPDEC)
+        n_chars = rn_fpdec_to_sci_chars(buf, self, engineering);
+    else
+        return rn_quot_to_sci_str(self, engineering);
+    return PyUnicode_FromStringAndSize(buf, (Py_ssize_t)n_chars);
+}
+
+static PyObject *
+Rational_to_decimal_str(RationalObject *self, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"max_digits", NULL};
+    PyObject *max_digits = Py_None;
+    uint64_t max_n_digits = UINT64_MAX;
+    bool neg = self->sign == RN_SIGN_NEG;
+    char int_digits[UINT128_10_POW_N_CUTOFF + 1];
+    uint128_t int_part;
+    size_t n_int;
+    uint64_t den;
+    PyObject *abs_num = NULL;
+    PyObject *qr = NULL;
+    PyObject *int_str = NULL;
+    PyObject *int_bytes = NULL;
+    PyObject *res = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kw_names,
+                                     &max_digits))
+        return NULL;
+    if (max_digits != Py_None) {
+        if (!PyLong_Check(max_digits)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "max_digits must be an int or None.");
+            return NULL;
+        }
+        max_n_digits = PyLong_AsUnsignedLongLong(max_digits);
+        if (PyErr_Occurred()) {
+            if (!PyErr_ExceptionMatches(PyExc_OverflowError) ||
+                    PyObject_RichCompareBool(max_digits, PyZERO, Py_LT)) {
+                PyErr_Clear();
+                PyErr_SetString(PyExc_ValueError,
+                                "max_digits must be >= 0.");
+                return NULL;
+            }
+            // larger than any possible expansion
+            PyErr_Clear();
+            max_n_digits = UINT64_MAX;
+        }
+    }
+
+    switch (self->sign == RN_SIGN_ZERO ? RN_FPDEC : self->variant) {
+        case RN_FPDEC:
+            if (self->sign != RN_SIGN_ZERO && self->exp < 0 &&
+                    (uint64_t)-self->exp > max_n_digits) {
+                PyErr_Format(PyExc_ValueError,
+                             "Decimal expansion exceeds %llu fractional "
+                             "digits.", (unsigned long long)max_n_digits);
+                return NULL;
+            }
+            if (self->sign == RN_SIGN_ZERO)
+                return PyUnicode_FromString("0");
+            // positional, regardless of the str policy
+            return rnd_to_str(neg, self->coeff, self->exp);
+        case RN_U64_QUOT:
+            U128_FROM_LO_HI(&int_part, self->u64_num / self->u64_den, 0ULL);
+            n_int = u128_to_dec_digits(int_digits, int_part);
+            return rn_u64_dec_expansion_as_str(
+                neg, int_digits, n_int, self->u64_num % self->u64_den,
+                self->u64_den, max_n_digits);
+        default:
+            break;
+    }
+
+    if (rn_assert_num_den(self) != 0)
+        return NULL;
+    ASSIGN_AND_CHECK_NULL(abs_num, PyNumber_Absolute(self->numerator));
+    ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(abs_num, self->denominator));
+    ASSIGN_AND_CHECK_NULL(int_str,
+                          pylong_to_dec_str(PyTuple_GetItem(qr, 0)));
+    den = PyLong_AsUnsignedLongLong(self->denominator);
+    if (den == (uint64_t)-1 && PyErr_Occurred()) {
+        PyErr_Clear();
+        ASSIGN_AND_CHECK_NULL(res, rn_pylong_dec_expansion_as_str(
+            neg, int_str, PyTuple_GetItem(qr, 1), self->denominator,
+            max_n_digits));
+    }
+    else {
+        ASSIGN_AND_CHECK_NULL(int_bytes, PyUnicode_AsASCIIString(int_str));
+        ASSIGN_AND_CHECK_NULL(res, rn_u64_dec_expansion_as_str(
+            neg, PyBytes_AsString(int_bytes),
+            (size_t)PyBytes_Size(int_bytes),
+            PyLong_AsUnsignedLongLong(PyTuple_GetItem(qr, 1)), den,
+            max_n_digits));
     }
-    if (self->sign < 0)
-        res = -res;
-    self->hash = res;
     goto CLEAN_UP;
 
 ERROR:
     assert(PyErr_Occurred());
 
 CLEAN_UP:
-    Py_XDECREF(inv_den);
     Py_XDECREF(abs_num);
+    Py_XDECREF(qr);
+    Py_XDECREF(int_str);
+    Py_XDECREF(int_bytes);
+    return res;
+}
+
+// size of the buffers used for formatting on the stack
+#define RN_FMT_SHORT_BUF_LEN 128
+
+// Decimal digits of abs(x) for some Rational x, rounded as needed
+struct rn_dec_digits {
+    char buf[UINT128_10_POW_N_CUTOFF + 1];
+    const char *digits;
+    size_t n_digits;
+    int64_t exp;
+    PyObject *owner;        // bytes holding digits not fitting into buf
+};
+
+// Get the digits of abs(self) rounded to to_prec fractional digits
+static int
+rn_get_dec_digits(struct rn_dec_digits *dd, RationalObject *self,
+                  int64_t to_prec, enum RN_ROUNDING_MODE rounding_mode) {
+    bool neg = self->sign == RN_SIGN_NEG;
+    uint128_t coeff = UINT128_ZERO;
+    rn_exp_t exp = 0;
+    uint64_t num, den;
+    PyObject *s = NULL;
+    PyObject *t = NULL;
+    PyObject *n = NULL;
+    PyObject *str = NULL;
+    int rc = 0;
+
+    dd->owner = NULL;
+    if (self->sign == RN_SIGN_ZERO)
+        goto COMPACT;
+    if (self->variant == RN_FPDEC && to_prec >= -self->exp) {
+        // no rounding needed
+        coeff = self->coeff;
+        exp = self->exp;
+        goto COMPACT;
+    }
+    if (to_prec >= RN_MIN_PREC && to_prec <= RN_MAX_PREC) {
+        switch (self->variant) {
+            case RN_FPDEC:
+                coeff = self->coeff;
+                exp = self->exp;
+                if (rnd_adjust_coeff_exp(&coeff, &exp, neg,
+                                         (rn_prec_t)to_prec,
+                                         rounding_mode) == RN_OK)
+                    goto COMPACT;
+                break;
+            case RN_U64_QUOT:
+                num = self->u64_num;
+                den = self->u64_den;
+                if (rnq_adjust_quot(&num, &den, neg, (rn_prec_t)to_prec,
+                                    rounding_mode) == RN_OK &&
+                        (num == 0 ||
+                         rnd_from_quot(&coeff, &exp, num, den) == RN_OK))
+                    goto COMPACT;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // (abs(numerator) * 10 ^ to_prec / denominator), rounded to an int
+    if (rn_assert_num_den(self) != 0)
+        goto ERROR;
+    ASSIGN_AND_CHECK_NULL(s, pylong_10_pow_n(to_prec < 0 ? -to_prec :
+                                                           to_prec));
+    if (to_prec >= 0) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(self->numerator, s));
+        ASSIGN_AND_CHECK_NULL(n, rnp_div_rounded(t, self->denominator,
+                                                 rounding_mode));
+    }
+    else {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(self->denominator, s));
+        ASSIGN_AND_CHECK_NULL(n, rnp_div_rounded(self->numerator, t,
+                                                 rounding_mode));
+    }
+    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Absolute(n));
+    ASSIGN_AND_CHECK_NULL(str, PyObject_Str(t));
+    ASSIGN_AND_CHECK_NULL(dd->owner, PyUnicode_AsASCIIString(str));
+    dd->digits = PyBytes_AsString(dd->owner);
+    dd->n_digits = (size_t)PyBytes_Size(dd->owner);
+    dd->exp = -to_prec;
+    goto CLEAN_UP;
+
+COMPACT:
+    dd->n_digits = u128_to_dec_digits(dd->buf, coeff);
+    dd->digits = dd->buf;
+    dd->exp = U128_EQ_ZERO(coeff) ? 0 : exp;
+    return 0;
+
+ERROR:
+    assert(PyErr_Occurred());
+    rc = -1;
+
+CLEAN_UP:
+    Py_XDECREF(s);
     Py_XDECREF(t);
+    Py_XDECREF(n);
+    Py_XDECREF(str);
+    return rc;
+}
+
+// Lay out sign and body according to spec
+static PyObject *
+rn_fmt_layout_as_str(const struct rn_format_spec *spec, char sign,
+                     const char *body, size_t n_body) {
+    char short_buf[RN_FMT_SHORT_BUF_LEN];
+    char *buf = short_buf;
+    struct rn_fmt_layout layout;
+    size_t n_bytes;
+    PyObject *res;
+
+    rn_fmt_get_layout(&layout, spec, sign, body, n_body);
+    if (layout.n_bytes > RN_FMT_SHORT_BUF_LEN &&
+            (buf = PyMem_Malloc(layout.n_bytes)) == NULL)
+        return PyErr_NoMemory();
+    n_bytes = rn_fmt_write_layout(buf, &layout, spec, sign, body, n_body);
+    if (spec->n_fill_bytes == 1)
+        res = PyUnicode_FromStringAndSize(buf, (Py_ssize_t)n_bytes);
+    else
+        res = PyUnicode_DecodeUTF8(buf, (Py_ssize_t)n_bytes,
+                                   "surrogatepass");
+    if (buf != short_buf)
+        PyMem_Free(buf);
+    return res;
+}
+
+// Lay out the chars of str(self) according to spec, which has neither type
+// nor precision
+static PyObject *
+rn_formatted_as_str(RationalObject *self, const struct rn_format_spec *spec) {
+    struct rn_ascii_repr repr;
+    const char *body;
+    char *buf = NULL;
+    size_t n_body, n_int;
+    char sign;
+    PyObject *res = NULL;
+
+    if (rn_get_ascii_repr(&repr, self) != 0)
+        return NULL;
+    body = repr.chars;
+    n_body = repr.len;
+    if (*body == '-') {
+        sign = '-';
+        ++body;
+        --n_body;
+    }
+    else
+        sign = spec->sign == '-' ? 0 : spec->sign;
+    // alternate form: decimal point after the integral digits of a decimal
+    // (body is terminated by 0)
+    for (n_int = 0; body[n_int] >= '0' && body[n_int] <= '9'; ++n_int);
+    if (spec->alternate && body[n_int] != '.' && body[n_int] != '/') {
+        if ((buf = PyMem_Malloc(n_body + 1)) == NULL) {
+            PyErr_NoMemory();
+            goto CLEAN_UP;
+        }
+        memcpy(buf, body, n_int);
+        buf[n_int] = '.';
+        memcpy(buf + n_int + 1, body + n_int, n_body - n_int);
+        body = buf;
+        ++n_body;
+    }
+    res = rn_fmt_layout_as_str(spec, sign, body, n_body);
+
+CLEAN_UP:
+    PyMem_Free(buf);
+    rn_release_ascii_repr(&repr);
+    return res;
+}
+
+static PyObject *
+rn_formatted(RationalObject *self, const struct rn_format_spec *spec) {
+    char short_buf[RN_FMT_SHORT_BUF_LEN];
+    char *buf = short_buf;
+    struct rn_dec_digits dd = {.owner = NULL};
+    enum RN_ROUNDING_MODE rounding_mode;
+    // values given as fixed-point decimal have a default precision
+    bool is_dec = self->sign == RN_SIGN_ZERO || self->variant == RN_FPDEC;
+    int64_t n_frac_digits = self->sign == RN_SIGN_ZERO ? 0 : -self->exp;
+    char type = spec->type;
+    size_t prec = spec->prec;
+    int64_t magn = 0;
+    int64_t to_prec;
+    size_t n_body, max_n_chars;
+    char sign;
+    PyObject *res = NULL;
+
+    if (type == 0) {
+        // same chars as str(self), including the str policy
+        if (prec == RN_FMT_UNDEF_PREC)
+            return rn_formatted_as_str(self, spec);
+        type = 'f';
+    }
+    if (self->sign != RN_SIGN_ZERO) {
+        if ((magn = rn_magnitude(self)) == -1 && PyErr_Occurred())
+            return NULL;
+    }
+    // default precision: all digits of fixed-point decimals,
+    // RN_FMT_DFLT_PREC for all others
+    switch (type) {
+        case 'e':
+        case 'E':
+            if (prec == RN_FMT_UNDEF_PREC)
+                prec = is_dec ? (size_t)MAX(magn + n_frac_digits, 0) :
+                       RN_FMT_DFLT_PREC;
+            to_prec = (int64_t)prec - magn;
+            break;
+        case 'g':
+        case 'G':
+            if (prec == RN_FMT_UNDEF_PREC)
+                prec = is_dec ? (size_t)MAX(magn + n_frac_digits + 1, 1) :
+                       RN_FMT_DFLT_PREC;
+            else if (prec == 0)
+                prec = 1;
+            to_prec = (int64_t)prec - 1 - magn;
+            break;
+        case '%':
+            if (prec == RN_FMT_UNDEF_PREC)
+                prec = is_dec ? (size_t)MAX(n_frac_digits - 2, 0) :
+                       RN_FMT_DFLT_PREC;
+            to_prec = (int64_t)prec + 2;
+            break;
+        default:
+            if (prec == RN_FMT_UNDEF_PREC)
+                prec = is_dec ? (size_t)MAX(n_frac_digits, 0) :
+                       RN_FMT_DFLT_PREC;
+            to_prec = (int64_t)prec;
+            break;
+    }
+
+    rounding_mode = rn_rounding_mode();
+    if (PyErr_Occurred())
+        return NULL;
+    if (rn_get_dec_digits(&dd, self, to_prec, rounding_mode) != 0)
+        return NULL;
+    if (type == '%')
+        dd.exp += 2;
+    max_n_chars = rn_format_dec_max_n_chars(dd.n_digits, dd.exp, prec);
+    if (max_n_chars > RN_FMT_SHORT_BUF_LEN &&
+            (buf = PyMem_Malloc(max_n_chars)) == NULL) {
+        PyErr_NoMemory();
+        goto ERROR;
+    }
+    n_body = rn_format_dec(buf, type, prec, spec->alternate, dd.digits,
+                           dd.n_digits, dd.exp);
+    if (self->sign == RN_SIGN_NEG &&
+            !(spec->no_neg_zero && dd.n_digits == 1 && dd.digits[0] == '0'))
+        sign = '-';
+    else
+        sign = spec->sign == '-' ? 0 : spec->sign;
+    ASSIGN_AND_CHECK_NULL(res, rn_fmt_layout_as_str(spec, sign, buf,
+                                                    n_body));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    if (buf != short_buf)
+        PyMem_Free(buf);
+    Py_XDECREF(dd.owner);
+    return res;
+}
+
+static PyObject *
+Rational_format(RationalObject *self, PyObject *fmt_spec) {
+    Py_UCS4 short_buf[RN_SHORT_LITERAL_LEN];
+    Py_UCS4 *buf;
+    Py_ssize_t len;
+    struct rn_format_spec spec;
+    rn_error_t rc;
+
+    if (!PyUnicode_Check(fmt_spec)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Format specifier must be a string.");
+        return NULL;
+    }
+    if ((buf = rn_str_as_ucs4(fmt_spec, short_buf, &len)) == NULL)
+        return NULL;
+    if (len == 0)
+        rc = RN_OK;
+    else
+        rc = rn_parse_format_spec(&spec, buf, (size_t)len);
+    if (buf != short_buf)
+        PyMem_Free(buf);
+    switch (rc) {
+        case RN_OK:
+            break;
+        case RN_LIMIT_EXCEEDED:
+            PyErr_SetString(PyExc_ValueError,
+                            "Too many decimal digits in format string.");
+            return NULL;
+        default:
+            PyErr_Format(PyExc_ValueError,
+                         "Invalid format specifier '%U' for object of "
+                         "type 'Rational'.", fmt_spec);
+            return NULL;
+    }
+    if (len == 0)
+        return PyObject_Str((PyObject *)self);
+    return rn_formatted(self, &spec);
+}
+
+// Special methods
+
+// Residue modulo P of the absolute value of the Python int x
+static int
+rn_pylong_hash_residue(uint64_t *res, PyObject *x, bool neg) {
+    Py_hash_t h = PyObject_Hash(x);
+
+    if (h == -1)
+        return -1;
+    if (neg) {
+        // hash(-x) == -hash(x), but -1 is mapped to -2 and thus ambiguous
+        if (h == -2) {
+            PyObject *abs_x = PyNumber_Absolute(x);
+            if (abs_x == NULL)
+                return -1;
+            h = PyObject_Hash(abs_x);
+            Py_DECREF(abs_x);
+            if (h == -1)
+                return -1;
+        }
+        else
+            h = -h;
+    }
+    *res = (uint64_t)h;
+    return 0;
+}
+
+static Py_hash_t
+Rational_hash(RationalObject *self) {
+    Py_hash_t res = self->hash;
+    uint64_t h, h_num, h_den;
+
+    if (res != -1)
+        return res;
+
+    /* To make sure that the hash of a Rational equals the hash of a
+     * numerically equal integer, float, Fraction or Decimal instance, it
+     * is computed as |num| * den ^ -1 mod P, negated for negative values
+     * (see numeric_hash.h). */
+    switch (self->variant) {
+        case RN_FPDEC:
+            h = rn_hash_fpdec(&rn_hash_params, &self->coeff, self->exp);
+            break;
+        case RN_U64_QUOT:
+            h = rn_hash_u64_quot(&rn_hash_params, self->u64_num,
+                                 self->u64_den);
+            break;
+        default:
+            // the hash of a non-negative int is its residue modulo P
+            if (rn_pylong_hash_residue(&h_num, self->numerator,
+                                       self->sign < 0) != 0 ||
+                rn_pylong_hash_residue(&h_den, self->denominator,
+                                       false) != 0)
+                return -1;
+            h = rn_hash_quot_residues(&rn_hash_params, h_num, h_den);
+    }
+    res = self->sign < 0 ? -(Py_hash_t)h : (Py_hash_t)h;
+    // -1 is reserved for signaling an error
+    if (res == -1)
+        res = -2;
+    self->hash = res;
     return res;
 }
 
@@ -1083,36 +3137,172 @@ Rational_deepcopy(RationalObject *self, PyObject *memo UNUSED) {
     return (PyObject *)self;
 }
 
+// Compare self with sign * coeff * 10 ^ exp natively.
+// Returns false if self is too large for a native comparison.
+static inline bool
+rn_cmp_fpdec(int *res, RationalObject *self, rn_sign_t sign,
+             uint128_t coeff, rn_exp_t exp) {
+    Py_ssize_t smagn, omagn;
+
+    *res = CMP(self->sign, sign);
+    if (*res != 0 || sign == 0)
+        return true;
+    if (self->variant == RN_PYINT_QUOT)
+        return false;
+    // here: self != 0 and other != 0, same sign
+    smagn = rn_magnitude(self);
+    omagn = rnd_magnitude(coeff, exp);
+    if (smagn != omagn)
+        *res = CMP(smagn, omagn) * sign;
+    else if (self->variant == RN_FPDEC)
+        *res = rnd_cmp(self->coeff, self->exp, coeff, exp) * sign;
+    else
+        *res = rnq_cmp_fpdec(self->u64_num, self->u64_den, coeff, exp) *
+               sign;
+    return true;
+}
+
+// Compare self with sign * num / den natively.
+// Returns false if self is too large for a native comparison.
+static inline bool
+rn_cmp_u64_quot(int *res, RationalObject *self, rn_sign_t sign,
+                uint64_t num, uint64_t den) {
+    Py_ssize_t smagn, omagn;
+
+    *res = CMP(self->sign, sign);
+    if (*res != 0 || sign == 0)
+        return true;
+    switch (self->variant) {
+        case RN_U64_QUOT:
+            *res = rnq_cmp(self->u64_num, self->u64_den, num, den) * sign;
+            return true;
+        case RN_FPDEC:
+            smagn = rn_magnitude(self);
+            omagn = rnq_magnitude(num, den);
+            if (smagn != omagn)
+                *res = CMP(smagn, omagn) * sign;
+            else
+                *res = -rnq_cmp_fpdec(num, den, self->coeff, self->exp) *
+                       sign;
+            return true;
+        default:
+            return false;
+    }
+}
+
 static inline int
 Rational_cmp(RationalObject *self, RationalObject *other) {
     Py_ssize_t smagn, omagn;
-    int8_t cmp = CMP(self->sign, other->sign);
-    if (cmp != 0 || self->sign == 0)
-        return cmp;
-    // here: self != 0 and other != 0, same sign
+    int res;
+
+    switch (other->variant) {
+        case RN_FPDEC:
+            if (rn_cmp_fpdec(&res, self, other->sign, other->coeff,
+                             other->exp))
+                return res;
+            break;
+        case RN_U64_QUOT:
+            if (rn_cmp_u64_quot(&res, self, other->sign, other->u64_num,
+                                other->u64_den))
+                return res;
+            break;
+        default:
+            break;
+    }
+    // here: at least one of them is too large for a native comparison
+    res = CMP(self->sign, other->sign);
+    if (res != 0 || self->sign == 0)
+        return res;
     smagn = rn_magnitude(self);
     omagn = rn_magnitude(other);
     if (smagn != omagn)
         return CMP(smagn, omagn) * self->sign;
-    // same magnitude and same sign
-    switch (self->variant) {
-        case RN_FPDEC:
-            if (other->variant == RN_FPDEC) {
-                return rnd_cmp(self->coeff, self->exp,
-                               other->coeff, other->exp);
-            }
-            FALLTHROUGH;
-        case RN_U64_QUOT:
-            rn_assert_num_den(self);
-            FALLTHROUGH;
-        case RN_PYINT_QUOT:
-            rn_assert_num_den(other);
-            return rnp_cmp(RN_PYINT_QUOT_PTR(self), RN_PYINT_QUOT_PTR(other));
-        default:
-            PyErr_SetString(PyExc_RuntimeError,
-                            "Corrupted internal representation.");
+    if (rn_assert_num_den(self) != 0 || rn_assert_num_den(other) != 0)
+        return 0;
+    return rnp_cmp(RN_PYINT_QUOT_PTR(self), RN_PYINT_QUOT_PTR(other));
+}
+
+// Compare self with the int v natively.
+// Returns false if self is too large for a native comparison.
+static inline bool
+rn_cmp_to_int64(int *res, RationalObject *self, long long v) {
+    uint128_t coeff;
+
+    U128_FROM_LO_HI(&coeff, v < 0 ? -(uint64_t)v : (uint64_t)v, 0ULL);
+    return rn_cmp_fpdec(res, self, (rn_sign_t)CMP(v, 0), coeff, 0);
+}
+
+// Compare self with the finite float d natively, if possible.
+// Returns false if d or self can't be handled without Python ints.
+static inline bool
+rn_cmp_to_double(int *res, RationalObject *self, double d) {
+    rn_sign_t sign = d < 0. ? RN_SIGN_NEG : d > 0. ? RN_SIGN_POS : 0;
+    uint64_t mant;
+    int exp;
+    unsigned n_bits;
+
+    if (sign == 0)
+        return rn_cmp_fpdec(res, self, 0, UINT128_ZERO, 0);
+    // |d| = mant * 2 ^ exp, mant odd, exactly
+    mant = (uint64_t)ldexp(frexp(fabs(d), &exp), 53);
+    exp -= 53;
+    n_bits = u64_n_trailing_0_bits(mant);
+    mant >>= n_bits;
+    exp += (int)n_bits;
+    if (exp < 0) {
+        if (exp < -63)
+            return false;
+        return rn_cmp_u64_quot(res, self, sign, mant, 1ULL << (unsigned)-exp);
     }
-    return 0;
+    else {
+        uint128_t coeff;
+
+        n_bits = 64U - u64_n_leading_0_bits(mant);
+        if (n_bits + exp > 128U)
+            return false;
+        if (exp >= 64)
+            U128_FROM_LO_HI(&coeff, 0ULL, mant << (unsigned)(exp - 64));
+        else {
+            U128_FROM_LO_HI(&coeff, mant, 0ULL);
+            coeff = u128_shift_left(&coeff, (unsigned)exp);
+        }
+        return rn_cmp_fpdec(res, self, sign, coeff, 0);
+    }
+}
+
+// Compare self with the Decimal other, based on the coefficient and
+// exponent parsed from its string representation (which is much cheaper
+// than calling as_tuple or as_integer_ratio).
+// Returns 1 if *res has been set, 0 if other must be compared via
+// as_integer_ratio (i.e. it is not finite, exceeds the compact
+// representation or self is too large) and -1 on error.
+static int
+rn_cmp_to_decimal(int *res, RationalObject *self, PyObject *other) {
+    Py_UCS4 buf[RN_SHORT_LITERAL_LEN];
+    struct rn_parsed_repr parsed;
+    PyObject *str;
+    Py_ssize_t len;
+    rn_sign_t sign;
+
+    if ((str = PyObject_Str(other)) == NULL)
+        return -1;
+    len = PyUnicode_GetLength(str);
+    if (len < 0 || len > RN_SHORT_LITERAL_LEN) {
+        Py_DECREF(str);
+        return len < 0 ? -1 : 0;
+    }
+    if (PyUnicode_AsUCS4(str, buf, RN_SHORT_LITERAL_LEN, 0) == NULL) {
+        Py_DECREF(str);
+        return -1;
+    }
+    Py_DECREF(str);
+    // 'NaN', 'Infinity' etc. are rejected as invalid literals
+    if (rn_from_ucs4_literal(&parsed, buf, len) != RN_OK)
+        return 0;
+    assert(!parsed.is_quot);
+    sign = U128_EQ_ZERO(parsed.coeff) ? RN_SIGN_ZERO :
+           parsed.neg ? RN_SIGN_NEG : RN_SIGN_POS;
+    return rn_cmp_fpdec(res, self, sign, parsed.coeff, parsed.exp);
 }
 
 static PyObject *
@@ -1176,18 +3366,44 @@ static PyObject *
 Rational_richcompare(RationalObject *self, PyObject *other, int op) {
     PyObject *res = NULL;
     PyObject *t = NULL;
+    int r;
 
     // Rational
     if (Rational_Check(other)) {
-        int r = Rational_cmp(self, (RationalObject *)other);
+        r = Rational_cmp(self, (RationalObject *)other);
         if (PyErr_Occurred())
             return NULL;
         Py_RETURN_RICHCOMPARE(r, 0, op);
     }
 
     // Python <int>
-    if (PyLong_Check(other)) // NOLINT(hicpp-signed-bitwise)
+    if (PyLong_Check(other)) { // NOLINT(hicpp-signed-bitwise)
+        int overflow;
+        long long v = PyLong_AsLongLongAndOverflow(other, &overflow);
+        if (v == -1 && PyErr_Occurred())
+            return NULL;
+        if (overflow == 0 && rn_cmp_to_int64(&r, self, v))
+            Py_RETURN_RICHCOMPARE(r, 0, op);
         return Rational_cmp_to_int(self, other, op);
+    }
+
+    // Python <float>
+    if (PyFloat_Check(other)) {
+        double d = PyFloat_AsDouble(other);
+        if (isfinite(d) && rn_cmp_to_double(&r, self, d))
+            Py_RETURN_RICHCOMPARE(r, 0, op);
+        // fall through to the generic path below
+    }
+
+    // Decimal (subclasses might override __str__)
+    if ((PyObject *)Py_TYPE(other) == Decimal) {
+        int rc = rn_cmp_to_decimal(&r, self, other);
+        if (rc < 0)
+            return NULL;
+        if (rc > 0)
+            Py_RETURN_RICHCOMPARE(r, 0, op);
+        // fall through to the generic path below
+    }
 
     // Integral
     if (PyObject_IsInstance(other, Integral)) {
@@ -1267,6 +3483,7 @@ Rational_neg(RationalObject *self) {
     }
     RATIONAL_ALLOC(Py_TYPE(self), res);
     Rational_raw_data_copy(res, self);
+    res->magn = self->magn;
     res->sign *= -1;
     if (self->numerator != NULL) {
         res->numerator = PyNumber_Negative(self->numerator);
@@ -1290,6 +3507,7 @@ Rational_abs(RationalObject *self) {
     }
     RATIONAL_ALLOC(Py_TYPE(self), res);
     Rational_raw_data_copy(res, self);
+    res->magn = self->magn;
     res->sign = RN_SIGN_POS;
     if (self->numerator != NULL) {
         res->numerator = PyNumber_Absolute(self->numerator);
@@ -1618,72 +3836,91 @@ Rational_pow(PyObject *x, PyObject *y, PyObject *mod) {
 
 // Converting methods
 
-static PyObject *
-rn_adjusted(RationalObject *self, rn_prec_t to_prec,
-            enum RN_ROUNDING_MODE rounding_mode) {
-    RATIONAL_ALLOC_RESULT(Py_TYPE(self));
+// Adjust rn in place to to_prec fractional digits. Must only be applied to
+// new instances not yet handed out.
+static int
+rn_adjust_inplace(RationalObject *rn, rn_prec_t to_prec,
+                  enum RN_ROUNDING_MODE rounding_mode) {
+    PyIntQuot quot = {NULL, NULL};
+    int rc;
 
-    if (self->sign == RN_SIGN_ZERO) {
-        Py_INCREF(self);
-        res = self;
-        goto CLEAN_UP;
-    }
+    if (rn->sign == RN_SIGN_ZERO)
+        return 0;
 
-    Rational_raw_data_copy(res, self);
-    switch (res->variant) {
+    // the compact variants are left unchanged if they can't be adjusted
+    switch (rn->variant) {
         case RN_FPDEC:
-            if (rnd_adjust_coeff_exp(&res->coeff, &res->exp,
-                                     res->sign == RN_SIGN_NEG, to_prec,
-                                     rounding_mode) == 0) {
-                if (U128_EQ_ZERO(res->coeff))
-                    res->sign = RN_SIGN_ZERO;
-            }
-            else goto FALLBACK;
+            if (rnd_adjust_coeff_exp(&rn->coeff, &rn->exp,
+                                     rn->sign == RN_SIGN_NEG, to_prec,
+                                     rounding_mode) != 0)
+                goto FALLBACK;
+            if (U128_EQ_ZERO(rn->coeff))
+                rn->sign = RN_SIGN_ZERO;
             break;
         case RN_U64_QUOT:
-            if (rnq_adjust_quot(&res->u64_num, &res->u64_den,
-                                res->sign == RN_SIGN_NEG, to_prec,
-                                rounding_mode) == 0) {
-                if (res->u64_num == 0)
-                    rn_set_to_zero(res);
-                else if (rnd_from_quot(&res->coeff, &res->exp,
-                                       res->u64_num, res->u64_den) == 0)
-                    res->variant = RN_FPDEC;
-            }
-            else goto FALLBACK;
-            break;
-        case RN_PYINT_QUOT: {
-            CHECK_RC(rnp_adjusted(RN_PYINT_QUOT_PTR(res),
-                                  RN_PYINT_QUOT_PTR(self), to_prec,
-                                  rounding_mode));
-            rn_optimize_pyquot(res);
+            if (rnq_adjust_quot(&rn->u64_num, &rn->u64_den,
+                                rn->sign == RN_SIGN_NEG, to_prec,
+                                rounding_mode) != 0)
+                goto FALLBACK;
+            if (rn->u64_num == 0)
+                rn_set_to_zero(rn);
+            else if (rnd_from_quot(&rn->coeff, &rn->exp,
+                                   rn->u64_num, rn->u64_den) == 0)
+                rn->variant = RN_FPDEC;
             break;
-        }
+        case RN_PYINT_QUOT:
+            goto FALLBACK;
         default:
             PyErr_SetString(PyExc_RuntimeError,
                             "Internal representation error");
-            goto ERROR;
+            return -1;
     }
-    res->prec = to_prec;
-    goto CLEAN_UP;
+    // numerator and denominator of the unadjusted value are outdated
+    Py_CLEAR(rn->numerator);
+    Py_CLEAR(rn->denominator);
+    goto DONE;
 
 FALLBACK:
-    if (rn_assert_num_den(self) == 0) {
-        CHECK_RC(rnp_adjusted(RN_PYINT_QUOT_PTR(res),
-                              RN_PYINT_QUOT_PTR(self), to_prec,
-                              rounding_mode));
-        res->variant = RN_PYINT_QUOT;
-        rn_optimize_pyquot(res);
-        res->prec = to_prec;
-        goto CLEAN_UP;
-    }
+    if (rn_assert_num_den(rn) != 0)
+        return -1;
+    // take over the unadjusted numerator and denominator
+    quot = *RN_PYINT_QUOT_PTR(rn);
+    rn->numerator = NULL;
+    rn->denominator = NULL;
+    rc = rnp_adjusted(RN_PYINT_QUOT_PTR(rn), &quot, to_prec, rounding_mode);
+    Py_DECREF(quot.numerator);
+    Py_DECREF(quot.denominator);
+    if (rc != 0)
+        return -1;
+    rn->variant = RN_PYINT_QUOT;
+    rn_optimize_pyquot(rn);
+
+DONE:
+    rn->prec = to_prec;
+    rn->hash = -1;
+    rn->magn = RN_UNDEF_MAGN;
+    assert(rn_is_consistent(rn));
+    return 0;
+}
 
-ERROR:
-    assert(PyErr_Occurred());
-    Py_CLEAR(res);
+static PyObject *
+rn_adjusted(RationalObject *self, rn_prec_t to_prec,
+            enum RN_ROUNDING_MODE rounding_mode) {
+    if (self->sign == RN_SIGN_ZERO) {
+        Py_INCREF(self);
+        return (PyObject *)self;
+    }
 
-CLEAN_UP:
-    assert(rn_is_consistent(res));
+    RATIONAL_ALLOC_RESULT(Py_TYPE(self));
+    Rational_raw_data_copy(res, self);
+    if (self->numerator != NULL) {
+        Py_INCREF(self->numerator);
+        res->numerator = self->numerator;
+        Py_INCREF(self->denominator);
+        res->denominator = self->denominator;
+    }
+    if (rn_adjust_inplace(res, to_prec, rounding_mode) != 0)
+        Py_CLEAR(res);
     return (PyObject *)res;
 }
 
@@ -1809,69 +4046,502 @@ ERROR:
     assert(PyErr_Occurred());
 
 CLEAN_UP:
-    Py_XDECREF(num);
-    Py_XDECREF(den);
-    return res;
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    return res;
+}
+
+static PyObject *
+Rational_as_integer_ratio(RationalObject *self, PyObject *args UNUSED) {
+    PyObject *res = NULL;
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+
+    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(res, PyTuple_Pack(2, num, den));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    return res;
+}
+
+static PyObject *
+Rational_floor(RationalObject *self, PyObject *args UNUSED) {
+    PyObject *res = NULL;
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+
+    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_FloorDivide(num, den));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    return res;
+}
+
+static PyObject *
+Rational_ceil(RationalObject *self, PyObject *args UNUSED) {
+    PyObject *res = NULL;
+    PyObject *num = NULL;
+    PyObject *den = NULL;
+    PyObject *t = NULL;
+
+    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(num));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_InPlaceFloorDivide(t, den));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_Negative(t));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(num);
+    Py_XDECREF(den);
+    Py_XDECREF(t);
+    return res;
+}
+
+static PyObject *
+Rational_round(RationalObject *self, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"ndigits", NULL};
+    PyObject *ndigits = Py_None;
+    PyObject *adj = NULL;
+    PyObject *res = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kw_names,
+                                     &ndigits))
+        return NULL;
+
+    if (ndigits == Py_None) {
+        if (self->sign == RN_SIGN_ZERO) {
+            Py_INCREF(PyZERO);
+            return PyZERO;
+        }
+        ASSIGN_AND_CHECK_NULL(adj, rn_adjusted(self, 0, RN_ROUND_HALF_EVEN));
+        ASSIGN_AND_CHECK_NULL(res, Rational_int((RationalObject *)adj, NULL));
+    }
+    else {
+        long to_prec;
+        if (check_n_convert_prec(ndigits, &to_prec) != 0)
+            goto ERROR;
+        if (self->sign == RN_SIGN_ZERO) {
+            Py_INCREF(self);
+            return (PyObject *)self;
+        }
+        ASSIGN_AND_CHECK_NULL(res, rn_adjusted(self, to_prec,
+                                               RN_ROUND_HALF_EVEN));
+    }
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(adj);
+    return res;
+}
+
+// Sort keys (see sort_key.h)
+
+// sort keys of values with a compact representation always fit into a
+// buffer of this size
+#define RN_SORT_KEY_SHORT_LEN 1024
+
+struct rn_sort_key_buf {
+    uint8_t *data;
+    size_t len;
+    size_t size;
+    uint8_t short_buf[RN_SORT_KEY_SHORT_LEN];
+};
+
+// Make room for n more bytes in kb
+static int
+rn_sort_key_buf_reserve(struct rn_sort_key_buf *kb, size_t n) {
+    size_t size;
+    uint8_t *data;
+
+    if (kb->len + n <= kb->size)
+        return 0;
+    size = MAX(2 * kb->size, kb->len + n);
+    if (kb->data == kb->short_buf) {
+        if ((data = PyMem_Malloc(size)) != NULL)
+            memcpy(data, kb->short_buf, kb->len);
+    }
+    else
+        data = PyMem_Realloc(kb->data, size);
+    if (data == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    kb->data = data;
+    kb->size = size;
+    return 0;
+}
+
+// Append the term a > 0 at the given position of a continued fraction
+static int
+rn_sort_key_put_pylong_term(struct rn_sort_key_buf *kb, PyObject *a,
+                            size_t pos) {
+    PyObject *t = NULL;
+    PyObject *bytes = NULL;
+    uint64_t u64;
+    long long n_bits;
+    size_t n;
+    int rc = -1;
+
+    u64 = PyLong_AsUnsignedLongLong(a);
+    if (u64 != (uint64_t)-1 || !PyErr_Occurred()) {
+        if (rn_sort_key_buf_reserve(kb, RN_SORT_KEY_MAX_U64_TERM_LEN) != 0)
+            return -1;
+        kb->len += rn_sort_key_put_u64_term(kb->data + kb->len, u64,
+                                            pos & 1U);
+        return 0;
+    }
+    if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+        return -1;
+    PyErr_Clear();
+    ASSIGN_AND_CHECK_NULL(t, PyObject_CallFunctionObjArgs(PyLong_bit_length,
+                                                          a, NULL));
+    n_bits = PyLong_AsLongLong(t);
+    if (n_bits == -1 && PyErr_Occurred())
+        goto ERROR;
+    n = ((size_t)n_bits + 7) / 8;
+    ASSIGN_AND_CHECK_NULL(bytes, PyObject_CallMethod(a, "to_bytes", "ns",
+                                                     (Py_ssize_t)n, "big"));
+    if (rn_sort_key_buf_reserve(kb, RN_SORT_KEY_MAX_U64_TERM_LEN + n) != 0)
+        goto ERROR;
+    kb->len += rn_sort_key_put_term(kb->data + kb->len,
+                                    (uint8_t *)PyBytes_AsString(bytes), n,
+                                    pos & 1U);
+    rc = 0;
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(t);
+    Py_XDECREF(bytes);
+    return rc;
+}
+
+// Append <pairs> <end> [<terms>] for |self| with the last pair being the
+// factor of 10 ^ exp
+static int
+rn_sort_key_put_pyint_quot(struct rn_sort_key_buf *kb, RationalObject *self,
+                           bool pad, int64_t exp) {
+    char digits[2 * RN_SORT_KEY_N_PAIRS];
+    PyObject *p = NULL;
+    PyObject *q = NULL;
+    PyObject *t = NULL;
+    PyObject *scale = NULL;
+    PyObject *qr = NULL;
+    PyObject *str = NULL;
+    PyObject *ascii = NULL;
+    Py_ssize_t n_digits;
+    int64_t key_exp;
+    int rc = -1;
+
+    ASSIGN_AND_CHECK_NULL(t, Rational_numerator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(p, PyNumber_Absolute(t));
+    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(q, Rational_denominator_get(self, NULL));
+    ASSIGN_AND_CHECK_NULL(scale, pylong_10_pow_n(exp < 0 ? -exp : exp));
+    if (exp < 0) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(p, scale));
+        Py_DECREF(p);
+        p = t;
+    }
+    else {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(q, scale));
+        Py_DECREF(q);
+        q = t;
+    }
+    t = NULL;
+    ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(p, q));
+    ASSIGN_AND_CHECK_NULL(str, PyObject_Str(PyTuple_GetItem(qr, 0)));
+    ASSIGN_AND_CHECK_NULL(ascii, PyUnicode_AsASCIIString(str));
+    n_digits = PyBytes_Size(ascii);
+    assert(pad + n_digits == 2 * RN_SORT_KEY_N_PAIRS);
+    digits[0] = '0';
+    memcpy(digits + pad, PyBytes_AsString(ascii), (size_t)n_digits);
+    kb->len += rn_sort_key_put_pairs(kb->data + kb->len, digits,
+                                     2 * RN_SORT_KEY_N_PAIRS);
+    Py_DECREF(p);
+    p = PyTuple_GetItem(qr, 1);
+    Py_INCREF(p);
+    if (PyObject_Not(p)) {
+        kb->data[kb->len++] = RN_SORT_KEY_EXACT;
+        rc = 0;
+        goto CLEAN_UP;
+    }
+    key_exp = exp / 2 + RN_SORT_KEY_N_PAIRS - 1;
+    if (ABS(key_exp) > RN_SORT_KEY_MAX_INEXACT_EXP) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Magnitude of value exceeds the limit for sort keys "
+                        "of non-decimal values.");
+        goto ERROR;
+    }
+    kb->data[kb->len++] = RN_SORT_KEY_INEXACT;
+    // continued fraction of p / q
+    for (size_t pos = 1;; ++pos) {
+        uint64_t u64_p, u64_q = PyLong_AsUnsignedLongLong(q);
+        if (u64_q != (uint64_t)-1 || !PyErr_Occurred()) {
+            // remaining terms can be calculated natively
+            u64_p = PyLong_AsUnsignedLongLong(p);
+            if (rn_sort_key_buf_reserve(kb, 100 *
+                                        RN_SORT_KEY_MAX_U64_TERM_LEN) != 0)
+                goto ERROR;
+            kb->len += rn_sort_key_put_u64_cont_frac(kb->data + kb->len,
+                                                     u64_p, u64_q, pos);
+            break;
+        }
+        if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+            goto ERROR;
+        PyErr_Clear();
+        if (PyObject_Not(p)) {
+            if (rn_sort_key_buf_reserve(kb, 1) != 0)
+                goto ERROR;
+            kb->len += rn_sort_key_put_inf_term(kb->data + kb->len,
+                                                pos & 1U);
+            break;
+        }
+        Py_CLEAR(qr);
+        ASSIGN_AND_CHECK_NULL(qr, PyNumber_Divmod(q, p));
+        if (rn_sort_key_put_pylong_term(kb, PyTuple_GetItem(qr, 0),
+                                        pos) != 0)
+            goto ERROR;
+        Py_DECREF(q);
+        q = p;
+        p = PyTuple_GetItem(qr, 1);
+        Py_INCREF(p);
+    }
+    rc = 0;
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(p);
+    Py_XDECREF(q);
+    Py_XDECREF(t);
+    Py_XDECREF(scale);
+    Py_XDECREF(qr);
+    Py_XDECREF(str);
+    Py_XDECREF(ascii);
+    return rc;
 }
 
 static PyObject *
-Rational_as_integer_ratio(RationalObject *self, PyObject *args UNUSED) {
+Rational_sort_key(RationalObject *self, PyObject *args UNUSED) {
+    struct rn_sort_key_buf kb;
     PyObject *res = NULL;
-    PyObject *num = NULL;
-    PyObject *den = NULL;
+    Py_ssize_t magn;
+    int64_t exp, pairs_exp;
+    bool pad;
 
-    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(res, PyTuple_Pack(2, num, den));
+    if (self->sign == RN_SIGN_ZERO) {
+        const char zero = RN_SORT_KEY_ZERO;
+        return PyBytes_FromStringAndSize(&zero, 1);
+    }
+    magn = rn_magnitude(self);
+    if (magn == -1 && PyErr_Occurred())
+        return NULL;
+    // 100 ^ exp <= |self| < 100 ^ (exp + 1)
+    exp = magn >= 0 ? magn / 2 : -((1 - (int64_t)magn) / 2);
+    // leading base-100 digit < 10?
+    pad = magn == 2 * exp;
+    // decimal exponent of the last pair
+    pairs_exp = 2 * (exp - RN_SORT_KEY_N_PAIRS + 1);
+
+    kb.data = kb.short_buf;
+    kb.size = RN_SORT_KEY_SHORT_LEN;
+    kb.data[0] = self->sign == RN_SIGN_NEG ? RN_SORT_KEY_NEG :
+                 RN_SORT_KEY_POS;
+    kb.len = 1 + rn_sort_key_put_exp(kb.data + 1, exp);
+    switch (self->variant) {
+        case RN_FPDEC: {
+            // coeff has at most 39 digits, so |self| is represented exactly
+            char digits[2 * RN_SORT_KEY_N_PAIRS + 2];
+            size_t n_digits = pad;
+            digits[0] = '0';
+            n_digits += u128_to_dec_digits(digits + pad, self->coeff);
+            if (n_digits & 1U)
+                digits[n_digits++] = '0';
+            kb.len += rn_sort_key_put_pairs(kb.data + kb.len, digits,
+                                            n_digits);
+            kb.data[kb.len++] = RN_SORT_KEY_EXACT;
+            break;
+        }
+        case RN_U64_QUOT: {
+            // -58 <= pairs_exp <= -20, because -20 <= magn <= 19
+            uint64_t num = self->u64_num, den = self->u64_den;
+            uint64_t r = num % den;
+            uint64_t n_frac_digits = (uint64_t)-pairs_exp;
+            char digits[1 + UINT128_10_POW_N_CUTOFF + 1 + 58];
+            char *cp = digits + 1, *end = cp;
+            // integral part of |self| * 10 ^ n_frac_digits
+            if (num >= den) {
+                uint128_t q;
+                U128_FROM_LO_HI(&q, num / den, 0ULL);
+                end += u128_to_dec_digits(cp, q);
+            }
+            end = u64_write_frac_digits(end, r, den, n_frac_digits);
+            while (*cp == '0')
+                ++cp;
+            if (pad)
+                *(--cp) = '0';
+            assert(end - cp == 2 * RN_SORT_KEY_N_PAIRS);
+            kb.len += rn_sort_key_put_pairs(kb.data + kb.len, cp,
+                                            2 * RN_SORT_KEY_N_PAIRS);
+            // remaining fraction r / den
+            r = u64_mulmod(r, u64_powmod(10, n_frac_digits, den), den);
+            if (r == 0)
+                kb.data[kb.len++] = RN_SORT_KEY_EXACT;
+            else {
+                kb.data[kb.len++] = RN_SORT_KEY_INEXACT;
+                kb.len += rn_sort_key_put_u64_cont_frac(kb.data + kb.len,
+                                                        r, den, 1);
+            }
+            break;
+        }
+        case RN_PYINT_QUOT:
+            if (rn_sort_key_put_pyint_quot(&kb, self, pad, pairs_exp) != 0)
+                goto ERROR;
+            break;
+        default:
+            PyErr_SetString(PyExc_RuntimeError,
+                            "Corrupted internal representation.");
+            goto ERROR;
+    }
+    assert(kb.len <= kb.size);
+    if (self->sign == RN_SIGN_NEG) {
+        for (size_t i = 1; i < kb.len; ++i)
+            kb.data[i] ^= 0xffU;
+    }
+    res = PyBytes_FromStringAndSize((char *)kb.data, (Py_ssize_t)kb.len);
     goto CLEAN_UP;
 
 ERROR:
     assert(PyErr_Occurred());
 
 CLEAN_UP:
-    Py_XDECREF(num);
-    Py_XDECREF(den);
+    if (kb.data != kb.short_buf)
+        PyMem_Free(kb.data);
     return res;
 }
 
+// Create an int from its n big-endian bytes
 static PyObject *
-Rational_floor(RationalObject *self, PyObject *args UNUSED) {
-    PyObject *res = NULL;
-    PyObject *num = NULL;
-    PyObject *den = NULL;
-
-    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(res, PyNumber_FloorDivide(num, den));
-    goto CLEAN_UP;
-
-ERROR:
-    assert(PyErr_Occurred());
-
-CLEAN_UP:
-    Py_XDECREF(num);
-    Py_XDECREF(den);
+rn_pylong_from_be_bytes(const uint8_t *bytes, size_t n) {
+    static const char hex_digits[] = "0123456789abcdef";
+    uint64_t u64 = 0;
+    char *hex;
+    PyObject *res;
+
+    if (n <= 8) {
+        for (size_t i = 0; i < n; ++i)
+            u64 = (u64 << 8U) + bytes[i];
+        return PyLong_FromUnsignedLongLong(u64);
+    }
+    if ((hex = PyMem_Malloc(2 * n + 1)) == NULL)
+        return PyErr_NoMemory();
+    for (size_t i = 0; i < n; ++i) {
+        hex[2 * i] = hex_digits[bytes[i] >> 4U];
+        hex[2 * i + 1] = hex_digits[bytes[i] & 0xfU];
+    }
+    hex[2 * n] = '\0';
+    res = PyLong_FromString(hex, NULL, 16);
+    PyMem_Free(hex);
     return res;
 }
 
+// Create a Rational from <terms> of a sort key (body already complemented
+// for negative values), with digits holding the given pairs padded to
+// RN_SORT_KEY_N_PAIRS. term_buf must provide space for len bytes.
 static PyObject *
-Rational_ceil(RationalObject *self, PyObject *args UNUSED) {
-    PyObject *res = NULL;
+RationalType_from_sort_key_terms(PyTypeObject *type, bool neg, int64_t exp,
+                                 const char *digits, const uint8_t *buf,
+                                 size_t len, uint8_t *term_buf) {
+    PyObject *terms = NULL;
+    PyObject *pairs = NULL;
     PyObject *num = NULL;
     PyObject *den = NULL;
     PyObject *t = NULL;
-
-    ASSIGN_AND_CHECK_NULL(num, Rational_numerator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(den, Rational_denominator_get(self, NULL));
-    ASSIGN_AND_CHECK_NULL(t, PyNumber_Negative(num));
-    ASSIGN_AND_CHECK_NULL(t, PyNumber_InPlaceFloorDivide(t, den));
-    ASSIGN_AND_CHECK_NULL(res, PyNumber_Negative(t));
+    PyObject *res = NULL;
+    bool last_is_one = false;
+    Py_ssize_t n_terms;
+    size_t pos, n, n_read;
+
+    ASSIGN_AND_CHECK_NULL(terms, PyList_New(0));
+    for (pos = 1;; ++pos) {
+        n_read = rn_sort_key_get_term(term_buf, &n, buf, len, pos & 1U);
+        if (n_read == 0)
+            goto INVALID;
+        buf += n_read;
+        len -= n_read;
+        if (n == 0)
+            break;
+        last_is_one = n == 1 && term_buf[0] == 1;
+        ASSIGN_AND_CHECK_NULL(t, rn_pylong_from_be_bytes(term_buf, n));
+        if (PyList_Append(terms, t) != 0)
+            goto ERROR;
+        Py_CLEAR(t);
+    }
+    // the continued fraction must be canonical, i.e. its last term > 1
+    if (len != 0 || pos == 1 || last_is_one)
+        goto INVALID;
+
+    // num / den = [a1; a2, ... an]
+    n_terms = PyList_Size(terms);
+    num = PyList_GetItem(terms, n_terms - 1);
+    Py_INCREF(num);
+    Py_INCREF(PyONE);
+    den = PyONE;
+    for (Py_ssize_t i = n_terms - 2; i >= 0; --i) {
+        ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(PyList_GetItem(terms, i),
+                                                   num));
+        ASSIGN_AND_CHECK_NULL(pairs, PyNumber_Add(t, den));
+        Py_CLEAR(t);
+        Py_DECREF(den);
+        den = num;
+        num = pairs;
+        pairs = NULL;
+    }
+    // |value| = (pairs + den / num) * 10 ^ exp
+    ASSIGN_AND_CHECK_NULL(pairs, PyLong_FromString(digits, NULL, 10));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(pairs, num));
+    Py_CLEAR(pairs);
+    ASSIGN_AND_CHECK_NULL(pairs, PyNumber_Add(t, den));
+    ASSIGN_AND_CHECK_NULL(res, RationalType_from_pylong_quot(type, neg,
+                                                             pairs, num,
+                                                             exp));
     goto CLEAN_UP;
 
+INVALID:
+    PyErr_SetString(PyExc_ValueError, "Invalid sort key.");
+
 ERROR:
     assert(PyErr_Occurred());
 
 CLEAN_UP:
+    Py_XDECREF(terms);
+    Py_XDECREF(pairs);
     Py_XDECREF(num);
     Py_XDECREF(den);
     Py_XDECREF(t);
@@ -1879,42 +4549,102 @@ CLEAN_UP:
 }
 
 static PyObject *
-Rational_round(RationalObject *self, PyObject *args, PyObject *kwds) {
-    static char *kw_names[] = {"ndigits", NULL};
-    PyObject *ndigits = Py_None;
-    PyObject *adj = NULL;
+RationalType_from_sort_key_chars(PyTypeObject *type, const uint8_t *key,
+                                 size_t len) {
+    uint8_t short_buf[2 * RN_SORT_KEY_SHORT_LEN];
+    uint8_t *body = short_buf;
+    // room for sign, digits, 'E' and exponent
+    char literal[2 * RN_SORT_KEY_N_PAIRS + 32];
+    char *digits;
+    const uint8_t mask = len > 0 && key[0] == RN_SORT_KEY_NEG ? 0xffU : 0U;
     PyObject *res = NULL;
-
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kw_names,
-                                     &ndigits))
-        return NULL;
-
-    if (ndigits == Py_None) {
-        if (self->sign == RN_SIGN_ZERO) {
-            Py_INCREF(PyZERO);
-            return PyZERO;
-        }
-        ASSIGN_AND_CHECK_NULL(adj, rn_adjusted(self, 0, RN_ROUND_HALF_EVEN));
-        ASSIGN_AND_CHECK_NULL(res, Rational_int((RationalObject *)adj, NULL));
+    size_t n_read, n_pairs = 0;
+    int64_t exp;
+    bool neg;
+
+    if (len == 0)
+        goto INVALID;
+    if (key[0] == RN_SORT_KEY_ZERO) {
+        if (len != 1)
+            goto INVALID;
+        return RationalType_from_pylong(type, PyZERO);
     }
-    else {
-        long to_prec;
-        if (check_n_convert_prec(ndigits, &to_prec) != 0)
-            goto ERROR;
-        if (self->sign == RN_SIGN_ZERO) {
-            Py_INCREF(self);
-            return (PyObject *)self;
+    if (key[0] != RN_SORT_KEY_NEG && key[0] != RN_SORT_KEY_POS)
+        goto INVALID;
+    neg = key[0] == RN_SORT_KEY_NEG;
+    // body and space for the terms
+    --len;
+    if (len > RN_SORT_KEY_SHORT_LEN &&
+            (body = PyMem_Malloc(2 * len)) == NULL)
+        return PyErr_NoMemory();
+    for (size_t i = 0; i < len; ++i)
+        body[i] = key[i + 1] ^ mask;
+
+    if ((n_read = rn_sort_key_get_exp(&exp, body, len)) == 0)
+        goto INVALID;
+    digits = literal + neg;
+    literal[0] = '-';
+    for (; n_read < len && body[n_read] >= RN_SORT_KEY_PAIR_OFFSET;
+           ++n_read, ++n_pairs) {
+        unsigned d = body[n_read] - RN_SORT_KEY_PAIR_OFFSET;
+        if (d > 99 || n_pairs == RN_SORT_KEY_N_PAIRS)
+            goto INVALID;
+        digits[2 * n_pairs] = (char)('0' + d / 10);
+        digits[2 * n_pairs + 1] = (char)('0' + d % 10);
+    }
+    // leading and trailing pairs must not be zero
+    if (n_pairs == 0 || n_read == len ||
+            body[n_read - n_pairs] == RN_SORT_KEY_PAIR_OFFSET ||
+            body[n_read - 1] == RN_SORT_KEY_PAIR_OFFSET)
+        goto INVALID;
+    if (body[n_read] == RN_SORT_KEY_EXACT) {
+        int n;
+        if (n_read + 1 != len)
+            goto INVALID;
+        n = snprintf(digits + 2 * n_pairs, 32, "E%lld",
+                     (long long)(2 * (exp - (int64_t)n_pairs + 1)));
+        res = RationalType_from_ascii_chars(type, (const uint8_t *)literal,
+                                            (Py_ssize_t)(neg + 2 * n_pairs +
+                                                         (size_t)n));
+    }
+    else if (body[n_read] == RN_SORT_KEY_INEXACT) {
+        if (ABS(exp) > RN_SORT_KEY_MAX_INEXACT_EXP)
+            goto INVALID;
+        for (; n_pairs < RN_SORT_KEY_N_PAIRS; ++n_pairs) {
+            digits[2 * n_pairs] = '0';
+            digits[2 * n_pairs + 1] = '0';
         }
-        ASSIGN_AND_CHECK_NULL(res, rn_adjusted(self, to_prec,
-                                               RN_ROUND_HALF_EVEN));
+        digits[2 * n_pairs] = '\0';
+        ++n_read;
+        res = RationalType_from_sort_key_terms(
+            type, neg, 2 * (exp - RN_SORT_KEY_N_PAIRS + 1), digits,
+            body + n_read, len - n_read, body + len);
     }
+    else
+        goto INVALID;
     goto CLEAN_UP;
 
-ERROR:
-    assert(PyErr_Occurred());
+INVALID:
+    PyErr_SetString(PyExc_ValueError, "Invalid sort key.");
 
 CLEAN_UP:
-    Py_XDECREF(adj);
+    if (body != short_buf)
+        PyMem_Free(body);
+    return res;
+}
+
+static PyObject *
+RationalType_from_sort_key(PyTypeObject *type, PyObject *key) {
+    struct rn_bytes_view view;
+    PyObject *res;
+
+    if (PyUnicode_Check(key)) // NOLINT(hicpp-signed-bitwise)
+        return type_error_ptr("A bytes-like object is required, not 'str'.");
+    if (rn_get_bytes_view(&view, key) != 0)
+        return NULL;
+    res = RationalType_from_sort_key_chars(type, view.chars,
+                                           (size_t)view.len);
+    rn_release_bytes_view(&view);
     return res;
 }
 
@@ -1967,6 +4697,22 @@ static PyMethodDef Rational_methods[] = {
      (PyCFunction)RationalType_from_decimal_or_int,
      METH_O | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
      RationalType_from_decimal_doc},
+    {"from_ascii",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)RationalType_from_ascii,
+     METH_VARARGS | METH_KEYWORDS | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
+     RationalType_from_ascii_doc},
+    {"parse",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)RationalType_parse,
+     METH_VARARGS | METH_KEYWORDS | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
+     RationalType_parse_doc},
+    {"fromhex",
+     (PyCFunction)RationalType_fromhex,
+     METH_O | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
+     RationalType_fromhex_doc},
+    {"from_sort_key",
+     (PyCFunction)RationalType_from_sort_key,
+     METH_O | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
+     RationalType_from_sort_key_doc},
     {"rounded",
      (PyCFunction)(void *)(PyCFunctionWithKeywords)Rational_rounded,
      METH_VARARGS | METH_KEYWORDS | METH_CLASS, // NOLINT(hicpp-signed-bitwise)
@@ -1988,6 +4734,26 @@ static PyMethodDef Rational_methods[] = {
      (PyCFunction)Rational_as_integer_ratio,
      METH_NOARGS,
      Rational_as_integer_ratio_doc},
+    {"hex",
+     (PyCFunction)Rational_hex,
+     METH_NOARGS,
+     Rational_hex_doc},
+    {"sort_key",
+     (PyCFunction)Rational_sort_key,
+     METH_NOARGS,
+     Rational_sort_key_doc},
+    {"to_decimal_str",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)Rational_to_decimal_str,
+     METH_VARARGS | METH_KEYWORDS, // NOLINT(hicpp-signed-bitwise)
+     Rational_to_decimal_str_doc},
+    {"to_sci_str",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)Rational_to_sci_str,
+     METH_VARARGS | METH_KEYWORDS, // NOLINT(hicpp-signed-bitwise)
+     Rational_to_sci_str_doc},
+    {"write_into",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)Rational_write_into,
+     METH_VARARGS | METH_KEYWORDS, // NOLINT(hicpp-signed-bitwise)
+     Rational_write_into_doc},
     // special methods
     {"__copy__",
      (PyCFunction)Rational_copy,
@@ -2071,6 +4837,265 @@ static PyType_Spec RationalType_spec = {
     Rational_type_slots                     /* slots */
 };
 
+/*============================================================================
+* Parser type
+* ==========================================================================*/
+
+// Literals are separated by ascii whitespace. Complete literals are parsed
+// in place from the chunk given to `feed`; only a literal not yet terminated
+// at the end of a chunk is kept until the following chunk(s) complete it.
+// After an invalid literal, the values parsed before it and the rest of the
+// chunk are kept, so that the next call of `feed` or `close` resumes there.
+
+#define RN_PARSER_MIN_PENDING_SIZE 64
+
+typedef struct {
+    PyObject_HEAD
+    uint8_t *pending;           // start of the literal not yet terminated
+    Py_ssize_t n_pending;
+    Py_ssize_t pending_size;
+    bool resume;                // pending holds the input following an
+                                // invalid literal
+    PyObject *parsed;           // values parsed before an invalid literal
+} ParserObject;
+
+static PyTypeObject *ParserType;
+
+static PyObject *
+ParserType_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {NULL};
+    allocfunc tp_alloc = (allocfunc)PyType_GetSlot(type, Py_tp_alloc);
+    ParserObject *self;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kw_names))
+        return NULL;
+    self = (ParserObject *)tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+    self->pending = NULL;
+    self->n_pending = 0;
+    self->pending_size = 0;
+    self->resume = false;
+    self->parsed = NULL;
+    return (PyObject *)self;
+}
+
+static void
+Parser_dealloc(ParserObject *self) {
+    freefunc tp_free = (freefunc)PyType_GetSlot(Py_TYPE(self), Py_tp_free);
+    PyMem_Free(self->pending);
+    Py_XDECREF(self->parsed);
+    tp_free(self);
+}
+
+static int
+Parser_add_pending(ParserObject *self, const uint8_t *chars, Py_ssize_t len) {
+    Py_ssize_t n_needed = self->n_pending + len;
+
+    if (n_needed > self->pending_size) {
+        Py_ssize_t new_size = Py_MAX(RN_PARSER_MIN_PENDING_SIZE,
+                                     self->pending_size);
+        uint8_t *new_pending;
+
+        while (new_size < n_needed)
+            new_size *= 2;
+        new_pending = PyMem_Realloc(self->pending, (size_t)new_size);
+        if (new_pending == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->pending = new_pending;
+        self->pending_size = new_size;
+    }
+    memcpy(self->pending + self->n_pending, chars, (size_t)len);
+    self->n_pending = n_needed;
+    return 0;
+}
+
+static int
+Parser_append_rational(PyObject *list, const uint8_t *chars, Py_ssize_t len) {
+    PyObject *rn = RationalType_from_ascii_chars(RationalType, chars, len);
+    int rc;
+
+    if (rn == NULL)
+        return -1;
+    rc = PyList_Append(list, rn);
+    Py_DECREF(rn);
+    return rc;
+}
+
+// Parse the pending literal, append the result to list and reset the
+// pending literal (also in case of an error).
+static int
+Parser_flush_pending(ParserObject *self, PyObject *list) {
+    Py_ssize_t n_pending = self->n_pending;
+
+    self->n_pending = 0;
+    return Parser_append_rational(list, self->pending, n_pending);
+}
+
+// Parse the literals in chars[0:len], continuing the pending literal, if
+// any, and append the results to list. A literal reaching up to the end of
+// chars is kept as pending literal. In case of an invalid literal, the rest
+// of chars is kept as input to be parsed by the next call of feed or close.
+static int
+Parser_parse_chunk(ParserObject *self, PyObject *list, const uint8_t *chars,
+                   Py_ssize_t len) {
+    const uint8_t *cp = chars;
+    const uint8_t *end = chars + len;
+    const uint8_t *start;
+
+    if (self->n_pending > 0) {
+        // continue the literal left over from the preceding chunk(s)
+        for (start = cp; cp < end && !rn_is_ascii_space(*cp); ++cp);
+        if (Parser_add_pending(self, start, cp - start) != 0)
+            return -1;
+        if (cp == end)
+            return 0;
+        if (Parser_flush_pending(self, list) != 0)
+            goto INVALID;
+    }
+    for (;;) {
+        for (; cp < end && rn_is_ascii_space(*cp); ++cp);
+        if (cp == end)
+            break;
+        for (start = cp; cp < end && !rn_is_ascii_space(*cp); ++cp);
+        if (cp == end) {
+            // literal may be continued in the next chunk
+            if (Parser_add_pending(self, start, cp - start) != 0)
+                return -1;
+            break;
+        }
+        if (Parser_append_rational(list, start, cp - start) != 0)
+            goto INVALID;
+    }
+    return 0;
+
+INVALID:
+    // cp points to the whitespace following the invalid literal
+    assert(self->n_pending == 0);
+    if (Parser_add_pending(self, cp, end - cp) == 0)
+        self->resume = true;
+    return -1;
+}
+
+// Parse the input kept after an invalid literal, followed by chars[0:len]
+static int
+Parser_resume(ParserObject *self, PyObject *list, const uint8_t *chars,
+              Py_ssize_t len) {
+    uint8_t *buf;
+    Py_ssize_t n;
+    int rc;
+
+    if (len > 0 && Parser_add_pending(self, chars, len) != 0)
+        return -1;
+    buf = self->pending;
+    n = self->n_pending;
+    self->pending = NULL;
+    self->n_pending = 0;
+    self->pending_size = 0;
+    self->resume = false;
+    rc = Parser_parse_chunk(self, list, buf, n);
+    PyMem_Free(buf);
+    return rc;
+}
+
+// Return the values parsed before an invalid literal, if any, as list to be
+// extended
+static PyObject *
+Parser_take_parsed(ParserObject *self) {
+    PyObject *res = self->parsed;
+
+    self->parsed = NULL;
+    return res != NULL ? res : PyList_New(0);
+}
+
+static PyObject *
+Parser_feed(ParserObject *self, PyObject *data) {
+    struct rn_bytes_view view;
+    PyObject *res = NULL;
+    int rc;
+
+    if (PyUnicode_Check(data)) // NOLINT(hicpp-signed-bitwise)
+        return type_error_ptr("A bytes-like object is required, not 'str'.");
+    if (rn_get_bytes_view(&view, data) != 0)
+        return NULL;
+    ASSIGN_AND_CHECK_NULL(res, Parser_take_parsed(self));
+    if (self->resume)
+        rc = Parser_resume(self, res, view.chars, view.len);
+    else
+        rc = Parser_parse_chunk(self, res, view.chars, view.len);
+    if (rc != 0) {
+        // keep the values parsed so far for the next call
+        self->parsed = res;
+        res = NULL;
+    }
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    rn_release_bytes_view(&view);
+    return res;
+}
+
+static PyObject *
+Parser_close(ParserObject *self, PyObject *args UNUSED) {
+    PyObject *res = Parser_take_parsed(self);
+
+    if (res == NULL)
+        return NULL;
+    if ((self->resume && Parser_resume(self, res, NULL, 0) != 0) ||
+            (self->n_pending > 0 && Parser_flush_pending(self, res) != 0)) {
+        // keep the values parsed so far for the next call
+        self->parsed = res;
+        return NULL;
+    }
+    return res;
+}
+
+static PyObject *
+Parser_pending_get(ParserObject *self, void *closure UNUSED) {
+    return PyBytes_FromStringAndSize((const char *)self->pending,
+                                     self->n_pending);
+}
+
+static PyGetSetDef Parser_properties[] = {
+    {"pending", (getter)Parser_pending_get, 0,
+     Parser_pending_doc, 0},
+    {0, 0, 0, 0, 0}};
+
+static PyMethodDef Parser_methods[] = {
+    {"feed",
+     (PyCFunction)Parser_feed,
+     METH_O,
+     Parser_feed_doc},
+    {"close",
+     (PyCFunction)Parser_close,
+     METH_NOARGS,
+     Parser_close_doc},
+    {0, 0, 0, 0}
+};
+
+static PyType_Slot Parser_type_slots[] = {
+    {Py_tp_doc, (void *)ParserType_doc},
+    {Py_tp_new, ParserType_new},
+    {Py_tp_dealloc, Parser_dealloc},
+    {Py_tp_free, PyObject_Del},
+    {Py_tp_getset, Parser_properties},
+    {Py_tp_methods, Parser_methods},
+    {0, NULL}
+};
+
+static PyType_Spec ParserType_spec = {
+    "rational.Parser",                      /* name */
+    sizeof(ParserObject),                   /* basicsize */
+    0,                                      /* itemsize */
+    0,                                      /* flags */
+    Parser_type_slots                       /* slots */
+};
+
 /*============================================================================
 * rational module
 * ==========================================================================*/
@@ -2086,6 +5111,96 @@ static PyType_Spec RationalType_spec = {
 
 PyDoc_STRVAR(rational_doc, "Rational number arithmetic.");
 
+static PyObject *
+rational_get_str_policy(PyObject *module UNUSED, PyObject *args UNUSED) {
+    PyObject *engineering = rn_sci_engineering ? Py_True : Py_False;
+
+    if (rn_sci_threshold == 0)
+        return Py_BuildValue("(OO)", Py_None, engineering);
+    return Py_BuildValue("(nO)", (Py_ssize_t)rn_sci_threshold, engineering);
+}
+
+static PyObject *
+rational_set_str_policy(PyObject *module, PyObject *args, PyObject *kwds) {
+    static char *kw_names[] = {"sci_threshold", "engineering", NULL};
+    PyObject *sci_threshold = Py_None;
+    int engineering = 0;
+    Py_ssize_t threshold = 0;
+    PyObject *prev;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Op", kw_names,
+                                     &sci_threshold, &engineering))
+        return NULL;
+    if (sci_threshold != Py_None) {
+        if (!PyLong_Check(sci_threshold) || PyBool_Check(sci_threshold)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "sci_threshold must be an int or None.");
+            return NULL;
+        }
+        threshold = PyLong_AsSsize_t(sci_threshold);
+        if (threshold == -1 && PyErr_Occurred()) {
+            if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+                return NULL;
+            // too large to ever be exceeded, or negative
+            PyErr_Clear();
+            threshold = PyObject_RichCompareBool(sci_threshold, PyZERO,
+                                                 Py_GT) ?
+                        PY_SSIZE_T_MAX : 0;
+        }
+        if (threshold < 1) {
+            PyErr_SetString(PyExc_ValueError, "sci_threshold must be >= 1.");
+            return NULL;
+        }
+    }
+    if ((prev = rational_get_str_policy(module, NULL)) == NULL)
+        return NULL;
+    rn_sci_threshold = (size_t)threshold;
+    rn_sci_engineering = engineering;
+    return prev;
+}
+
+static PyMethodDef rational_methods[] = {
+    {"get_str_policy",
+     (PyCFunction)rational_get_str_policy,
+     METH_NOARGS,
+     rational_get_str_policy_doc},
+    {"set_str_policy",
+     (PyCFunction)(void *)(PyCFunctionWithKeywords)rational_set_str_policy,
+     METH_VARARGS | METH_KEYWORDS, // NOLINT(hicpp-signed-bitwise)
+     rational_set_str_policy_doc},
+    {0, 0, 0, 0}
+};
+
+static int
+rn_init_hash_params(PyObject *hash_info) {
+    PyObject *modulus = NULL;
+    PyObject *inf = NULL;
+    uint64_t m, h_inf;
+    int rc = -1;
+
+    ASSIGN_AND_CHECK_NULL(modulus,
+                          PyObject_GetAttrString(hash_info, "modulus"));
+    ASSIGN_AND_CHECK_NULL(inf, PyObject_GetAttrString(hash_info, "inf"));
+    m = PyLong_AsUnsignedLongLong(modulus);
+    h_inf = PyLong_AsUnsignedLongLong(inf);
+    if (PyErr_Occurred())
+        goto ERROR;
+    // CPython's modulus is always a Mersenne prime
+    if (m < 15 || (m & (m + 1)) != 0 || m > (uint64_t)INT64_MAX) {
+        PyErr_SetString(PyExc_SystemError,
+                        "Unsupported modulus in sys.hash_info.");
+        goto ERROR;
+    }
+    rn_hash_params_init(&rn_hash_params, 64U - u64_n_leading_0_bits(m),
+                        h_inf);
+    rc = 0;
+
+ERROR:
+    Py_XDECREF(modulus);
+    Py_XDECREF(inf);
+    return rc;
+}
+
 static int
 rational_exec(PyObject *module) {
     int rc = 0;
@@ -2124,14 +5239,17 @@ rational_exec(PyObject *module) {
     ASSIGN_AND_CHECK_NULL(sys, PyImport_ImportModule("sys"));
     ASSIGN_AND_CHECK_NULL(hash_info,
                           PyObject_GetAttrString(sys, "hash_info"));
-    ASSIGN_AND_CHECK_NULL(PyHASH_MODULUS,
-                          PyObject_GetAttrString(hash_info, "modulus"));
-    ASSIGN_AND_CHECK_NULL(PyHASH_INF,
-                          PyObject_GetAttrString(hash_info, "inf"));
+    if (rn_init_hash_params(hash_info) != 0)
+        goto ERROR;
     /* PyLong methods */
     ASSIGN_AND_CHECK_NULL(PyLong_bit_length,
                           PyObject_GetAttrString((PyObject *)&PyLong_Type,
                                                  "bit_length"));
+#ifndef RN_HAVE_TYPE_NAME_API
+    /* Attribute names */
+    ASSIGN_AND_CHECK_NULL(PyStr__name__,
+                          PyUnicode_InternFromString("__name__"));
+#endif
     /* Import from rounding */
     PyObject *rounding = NULL;
     ASSIGN_AND_CHECK_NULL(rounding,
@@ -2152,14 +5270,19 @@ rational_exec(PyObject *module) {
     ASSIGN_AND_CHECK_NULL(PyUInt64Max,
                           PyLong_FromUnsignedLongLong(UINT64_MAX));
     ASSIGN_AND_CHECK_NULL(Py2pow64, PyNumber_Lshift(PyONE, Py64));
-    ASSIGN_AND_CHECK_NULL(PyHASH_MODULUS_2,
-                          PyLong_FromLongLong(PyLong_AsLongLong(PyHASH_MODULUS)
-                                              - 2));
 
     /* Add types */
     ASSIGN_AND_CHECK_NULL(RationalType,
                           (PyTypeObject *)PyType_FromSpec(&RationalType_spec));
     PYMOD_ADD_OBJ(module, "Rational", (PyObject *)RationalType);
+    ASSIGN_AND_CHECK_NULL(ParserType,
+                          (PyTypeObject *)PyType_FromSpec(&ParserType_spec));
+    PYMOD_ADD_OBJ(module, "Parser", (PyObject *)ParserType);
+
+    /* Version of the Unicode database the digit table is based on */
+    if (PyModule_AddStringConstant(module, "_unidata_version",
+                                   NON_ASCII_DIGIT_UNIDATA_VERSION) < 0)
+        goto ERROR;
 
     /* Register RationalType as Rational */
     ASSIGN_AND_CHECK_NULL(RationalType,
@@ -2178,12 +5301,16 @@ ERROR:
     Py_CLEAR(Fraction);
     Py_CLEAR(Decimal);
     Py_CLEAR(RationalType);
+    Py_CLEAR(ParserType);
     Py_CLEAR(Rounding);
     Py_CLEAR(get_dflt_rounding_mode);
     Py_CLEAR(PyNumber_gcd);
     Py_CLEAR(PyNumber_log10);
     Py_CLEAR(PyNumber_floor);
     Py_CLEAR(PyLong_bit_length);
+#ifndef RN_HAVE_TYPE_NAME_API
+    Py_CLEAR(PyStr__name__);
+#endif
     Py_CLEAR(PyZERO);
     Py_CLEAR(PyONE);
     Py_CLEAR(PyTWO);
@@ -2192,9 +5319,6 @@ ERROR:
     Py_CLEAR(Py64);
     Py_CLEAR(PyUInt64Max);
     Py_CLEAR(Py2pow64);
-    Py_CLEAR(PyHASH_MODULUS);
-    Py_CLEAR(PyHASH_MODULUS_2);
-    Py_CLEAR(PyHASH_INF);
     rc = -1;
 
 CLEAN_UP:
@@ -2218,7 +5342,7 @@ static struct PyModuleDef rational_module = {
     "rational",                         /* m_name */
     rational_doc,                       /* m_doc */
     0,                                  /* m_size */
-    NULL,                               /* m_methods */
+    rational_methods,                   /* m_methods */
     rational_slots,                     /* m_slots */
     NULL,                               /* m_traverse */
     NULL,                               /* m_clear */
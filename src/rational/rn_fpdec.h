@@ -11,8 +11,7 @@ $Revision$
 #ifndef RATIONAL_RN_FPDEC_H
 #define RATIONAL_RN_FPDEC_H
 
-#include <Python.h>
-
+#include "librational.h"
 #ifdef __SIZEOF_INT128__
 #include "uint128_math_native.h"
 #else
@@ -20,6 +19,7 @@ $Revision$
 #endif // __int128
 
 #include "rounding.h"
+#include "uint256_math.h"
 
 // maximum power of 10 less than UINT64_MAX (10 ^ UINT64_10_POW_N_CUTOFF)
 #define MPT 10000000000000000000UL
@@ -116,97 +116,50 @@ u128_idiv_mpt(uint128_t *x) {
         return u128_idiv_mpt_special(x);
 }
 
-static inline PyObject *
-rnd_to_str(const char *sign, uint128_t coeff, int exp) {
-    PyObject *res = NULL;
-    size_t n_dec_digits = U128_MAGNITUDE(coeff) + 1;
-    size_t n_int_digits = n_dec_digits;
-    size_t n_trailing_int_digits = 0;
-    size_t n_leading_frac_digits = 0;
-    size_t n_frac_digits = 0;
+// Number of chars of the decimal representation of (-1) ^ neg * coeff *
+// 10 ^ exp, excluding the terminating 0; coeff must not be zero.
+static inline size_t
+rnd_n_chars(bool neg, uint128_t coeff, int exp) {
+    size_t n_dec_digits = u128_magnitude(coeff) + 1;
     size_t n_char;
-    uint8_t *digits, *dp, *buf, *cp;
-    uint8_t d;
 
-    if (exp < 0) {
-        unsigned abs_exp = ABS(exp);
-        if (abs_exp < n_dec_digits) {
-            n_frac_digits = abs_exp;
-            n_int_digits = n_dec_digits - n_frac_digits;
-        }
-        else {
-            n_int_digits = 0;
-            n_trailing_int_digits = 1;
-            n_frac_digits = n_dec_digits;
-            n_leading_frac_digits = abs_exp - n_frac_digits;
-        }
-    }
-    else if (exp > 0) {
-        n_trailing_int_digits = exp;
-    }
-    n_char = n_int_digits + n_trailing_int_digits + n_leading_frac_digits +
-        n_frac_digits + 3;
-    buf = PyMem_Malloc(n_char);
-    if (buf == NULL) {
-        return PyErr_NoMemory();
-    }
-    dp = buf + n_char - 1;
-    *dp = 0;
-    while (U128_NE_ZERO(coeff)) {
-        d = u128_idiv_10(&coeff);
-        *(--dp) = '0' + d;
-    }
-    cp = buf;
-    if (*sign != 0)
-        *cp++ = *sign;
-    for (size_t i = 0; i < n_int_digits; ++i) {
-        *cp++ = *dp++;
-    }
-    for (size_t i = 0; i < n_trailing_int_digits; ++i)
-        *cp++ = '0';
-    if (n_frac_digits > 0) {
-        *cp++ = '.';
-        for (size_t i = 0; i < n_leading_frac_digits; ++i)
-            *cp++ = '0';
-        for (size_t i = 0; i < n_frac_digits; ++i) {
-            *cp++ = *dp++;
-        }
-    }
-    *cp = 0;
-    res = PyUnicode_FromString((char *)buf);
-    PyMem_Free(buf);
-    return res;
+    if (exp >= 0)
+        n_char = n_dec_digits + exp;
+    else if ((size_t)-exp < n_dec_digits)
+        n_char = n_dec_digits + 1;
+    else
+        n_char = -exp + 2;
+    return n_char + neg;
 }
 
-static inline PyObject *
-PyLong_from_u128_lo_hi(uint64_t lo, uint64_t hi) {
-    PyObject *res = NULL;
-    PyObject *res_hi = NULL;
-    PyObject *res_lo = NULL;
-    PyObject *t = NULL;
-
-    ASSIGN_AND_CHECK_NULL(res_hi, PyLong_FromUnsignedLongLong(hi));
-    ASSIGN_AND_CHECK_NULL(res_lo, PyLong_FromUnsignedLongLong(lo));
-    ASSIGN_AND_CHECK_NULL(t, PyNumber_Lshift(res_hi, Py64));
-    ASSIGN_AND_CHECK_NULL(res, PyNumber_Add(t, res_lo));
-    goto CLEAN_UP;
-
-ERROR:
-    assert(PyErr_Occurred());
+// Write the decimal representation of (-1) ^ neg * coeff * 10 ^ exp,
+// followed by a terminating 0, to buf, which must have room for
+// rnd_n_chars(neg, coeff, exp) + 1 chars. Returns the number of chars
+// written, excluding the terminating 0.
+static inline size_t
+rnd_to_chars(char *buf, bool neg, uint128_t coeff, int exp) {
+    size_t n_char = rnd_n_chars(neg, coeff, exp);
+    char *cp = buf + n_char;
 
-CLEAN_UP:
-    Py_XDECREF(res_hi);
-    Py_XDECREF(res_lo);
-    Py_XDECREF(t);
-    return res;
-}
-
-static inline PyObject *
-pylong_from_u128(const uint128_t *ui) {
-    if (U128P_HI(ui) == 0)
-        return PyLong_FromUnsignedLongLong(U128P_LO(ui));
-    else
-        return PyLong_from_u128_lo_hi(U128P_LO(ui), U128P_HI(ui));
+    // the digits are generated from right to left
+    *cp = 0;
+    if (exp >= 0) {
+        for (int i = 0; i < exp; ++i)
+            *(--cp) = '0';
+    }
+    else {
+        for (int i = 0; i < -exp; ++i)
+            *(--cp) = '0' + (U128_NE_ZERO(coeff) ? u128_idiv_10(&coeff) : 0);
+        *(--cp) = '.';
+        if (U128_EQ_ZERO(coeff))
+            *(--cp) = '0';
+    }
+    while (U128_NE_ZERO(coeff))
+        *(--cp) = '0' + u128_idiv_10(&coeff);
+    if (neg)
+        *(--cp) = '-';
+    assert(cp == buf);
+    return n_char;
 }
 
 static inline uint64_t
@@ -270,65 +223,66 @@ least_pow_10_multiple(uint64_t *factor, uint64_t n) {
     return -1;
 }
 
-static inline error_t
+static inline rn_error_t
 rnd_from_quot(uint128_t *coeff, rn_exp_t *exp, uint64_t num, uint64_t den) {
     uint64_t factor;
     int32_t m = least_pow_10_multiple(&factor, den);
     if (m < 0)
-        return -1;
+        return RN_LIMIT_EXCEEDED;
     *exp = -m;
     u64_mul_u64(coeff, num, factor);
-    return 0;
+    return RN_OK;
 }
 
-static inline Py_ssize_t
+// Same as rnd_from_quot for a numerator < 2 ^ 128
+static inline rn_error_t
+rnd_from_u128_quot(uint128_t *coeff, rn_exp_t *exp, const uint128_t *num,
+                   uint64_t den) {
+    uint64_t factor;
+    int32_t m;
+
+    if (U128P_HI(num) == 0)
+        return rnd_from_quot(coeff, exp, U128P_LO(num), den);
+    m = least_pow_10_multiple(&factor, den);
+    // factor <= 10 ^ m, so the product is < 10 ^ UINT128_10_POW_N_CUTOFF
+    if (m < 0 || u128_magnitude(*num) + m >= UINT128_10_POW_N_CUTOFF)
+        return RN_LIMIT_EXCEEDED;
+    *exp = -m;
+    *coeff = *num;
+    u128_imul_u64(coeff, factor);
+    return RN_OK;
+}
+
+static inline int
 rnd_magnitude(uint128_t coeff, rn_exp_t exp) {
-    if (U128_HI(coeff) == 0)
-        return U64_MAGNITUDE(U128_LO(coeff)) + exp;
-    else
-        return U128_MAGNITUDE(coeff) + exp;
+    return u128_magnitude(coeff) + exp;
 }
 
 // pre-condition: same magnitude
 static inline int
 rnd_cmp(uint128_t x_coeff, rn_exp_t x_exp, uint128_t y_coeff, rn_exp_t y_exp) {
-    uint8_t e;
-    if (x_exp > y_exp) {
-        e = x_exp - y_exp;  // 0 < e <= 38
-        if (e <= UINT64_10_POW_N_CUTOFF) {
-            uint64_t sh = u64_10_pow_n(e);
-            u128_imul_u64(&x_coeff, sh);
-        }
-        else {
-            uint64_t sh = u64_10_pow_n(UINT64_10_POW_N_CUTOFF);
-            u128_imul_u64(&x_coeff, sh);
-            sh = u64_10_pow_n(e - UINT64_10_POW_N_CUTOFF);
-            u128_imul_u64(&x_coeff, sh);
-        }
-    }
-    else if (y_exp > x_exp) {
-        e = y_exp - x_exp;  // 0 < e <= 38
-        if (e <= UINT64_10_POW_N_CUTOFF) {
-            uint64_t sh = u64_10_pow_n(e);
-            u128_imul_u64(&y_coeff, sh);
-        }
-        else {
-            uint64_t sh = u64_10_pow_n(UINT64_10_POW_N_CUTOFF);
-            u128_imul_u64(&y_coeff, sh);
-            sh = u64_10_pow_n(e - UINT64_10_POW_N_CUTOFF);
-            u128_imul_u64(&y_coeff, sh);
-        }
-    }
-    return u128_cmp(x_coeff, y_coeff);
+    uint256_t x, y;
+
+    if (x_exp == y_exp)
+        return u128_cmp(x_coeff, y_coeff);
+    // the scaled coefficient has as many digits as the other one, i.e. it
+    // may exceed 128 bits
+    u256_from_u128(&x, &x_coeff);
+    u256_from_u128(&y, &y_coeff);
+    if (x_exp > y_exp)
+        u256_imul_10_pow_n(&x, x_exp - y_exp);
+    else
+        u256_imul_10_pow_n(&y, y_exp - x_exp);
+    return u256_cmp(&x, &y);
 }
 
-static inline error_t
+static inline rn_error_t
 rnd_adjust_coeff_exp(uint128_t *coeff, rn_exp_t *exp, bool neg,
                      rn_prec_t to_prec, enum RN_ROUNDING_MODE rounding_mode) {
-    assert(!U128_EQ_ZERO(coeff));
+    assert(!U128P_EQ_ZERO(coeff));
     int sh = -(to_prec + *exp);
 
-    if (sh > U128_MAGNITUDE(*coeff) + 1) {
+    if (sh > u128_magnitude(*coeff) + 1) {
         // coeff * 10 ^ exp < 10 ^ to_prec / 2
         if (u64_delta_rounded(neg, rounding_mode) == 0) {
             *coeff = UINT128_ZERO;
@@ -338,11 +292,11 @@ rnd_adjust_coeff_exp(uint128_t *coeff, rn_exp_t *exp, bool neg,
             *coeff = UINT128_ONE;
             *exp = -to_prec;
         }
-        return 0;
+        return RN_OK;
     }
 
     if (sh > UINT64_10_POW_N_CUTOFF)
-        return -1;
+        return RN_LIMIT_EXCEEDED;
 
     if (sh > 0) {
         uint128_t t;
@@ -350,89 +304,7 @@ rnd_adjust_coeff_exp(uint128_t *coeff, rn_exp_t *exp, bool neg,
         u128_idiv_rounded(coeff, &t, neg, rounding_mode);
         *exp = -to_prec;
     }
-    return 0;
-}
-
-static inline PyObject *
-rnd_coeff_mul_10_pow_exp(uint128_t *coeff, rn_exp_t exp) {
-    PyObject *res = NULL;
-    PyObject *e = NULL;
-    PyObject *t = NULL;
-
-    ASSIGN_AND_CHECK_NULL(e, PyLong_FromLong(exp));
-    ASSIGN_AND_CHECK_NULL(t, PyNumber_Power(PyTEN, e, Py_None));
-    ASSIGN_AND_CHECK_NULL(res, pylong_from_u128(coeff));
-    ASSIGN_AND_CHECK_NULL(res, PyNumber_InPlaceMultiply(res, t));
-
-ERROR:
-    assert (PyErr_Occurred());
-
-CLEAN_UP:
-    Py_XDECREF(e);
-    Py_XDECREF(t);
-    return res;
-}
-
-static inline PyObject *
-rnd_coeff_floordiv_10_pow_exp(uint128_t *coeff, rn_exp_t exp) {
-    PyObject *res = NULL;
-    PyObject *e = NULL;
-    PyObject *t = NULL;
-
-    ASSIGN_AND_CHECK_NULL(e, PyLong_FromLong(exp));
-    ASSIGN_AND_CHECK_NULL(t, PyNumber_Power(PyTEN, e, Py_None));
-    ASSIGN_AND_CHECK_NULL(res, pylong_from_u128(coeff));
-    ASSIGN_AND_CHECK_NULL(res, PyNumber_InPlaceFloorDivide(res, t));
-
-ERROR:
-    assert (PyErr_Occurred());
-
-CLEAN_UP:
-    Py_XDECREF(e);
-    Py_XDECREF(t);
-    return res;
-}
-
-static inline PyObject *
-rnd_to_int(rn_sign_t sign, uint128_t coeff, rn_exp_t exp) {
-    PyObject *res = NULL;
-    PyObject *abs_res = NULL;
-    int32_t abs_exp = ABS(exp);
-
-    if (abs_exp < UINT64_10_POW_N_CUTOFF) {
-        int32_t sh = u64_10_pow_n(abs_exp);
-        if (exp < 0) {
-            u128_idiv_u64(&coeff, sh);
-            ASSIGN_AND_CHECK_NULL(abs_res, pylong_from_u128(&coeff));
-        }
-        else {
-            uint128_t t = coeff;
-            u128_imul_u64(&t, sh);
-            if (u128_cmp(t, UINT128_MAX) == 0)
-                ASSIGN_AND_CHECK_NULL(abs_res,
-                                      rnd_coeff_mul_10_pow_exp(&coeff, exp));
-            ASSIGN_AND_CHECK_NULL(abs_res, pylong_from_u128(&coeff));
-        }
-    }
-    else if (exp < 0)
-        ASSIGN_AND_CHECK_NULL(abs_res,
-                              rnd_coeff_floordiv_10_pow_exp(&coeff, -exp));
-    else
-        ASSIGN_AND_CHECK_NULL(abs_res, rnd_coeff_mul_10_pow_exp(&coeff, exp));
-    if (sign == RN_SIGN_NEG)
-        ASSIGN_AND_CHECK_NULL(res, PyNumber_Negative(abs_res));
-    else {
-        Py_INCREF(abs_res);
-        res = abs_res;
-    }
-    goto CLEAN_UP;
-
-ERROR:
-    assert (PyErr_Occurred());
-
-CLEAN_UP:
-    Py_XDECREF(abs_res);
-    return res;
+    return RN_OK;
 }
 
 #endif //RATIONAL_RN_FPDEC_H
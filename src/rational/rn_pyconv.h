@@ -0,0 +1,192 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#ifndef RATIONAL_RN_PYCONV_H
+#define RATIONAL_RN_PYCONV_H
+
+#include <Python.h>
+
+#include "common.h"
+#include "parse.h"
+#include "pylong_math.h"
+#include "rn_fpdec.h"
+#include "rn_u64_quot.h"
+
+// Conversion of fixed-point decimals and 64-bit quotients to Python objects
+
+static inline PyObject *
+rnd_to_str(bool neg, uint128_t coeff, rn_exp_t exp) {
+    PyObject *res = NULL;
+    size_t n_char = rnd_n_chars(neg, coeff, exp);
+    char *buf;
+
+    buf = PyMem_Malloc(n_char + 1);
+    if (buf == NULL) {
+        return PyErr_NoMemory();
+    }
+    rnd_to_chars(buf, neg, coeff, exp);
+    res = PyUnicode_FromStringAndSize(buf, n_char);
+    PyMem_Free(buf);
+    return res;
+}
+
+static inline PyObject *
+PyLong_from_u128_lo_hi(uint64_t lo, uint64_t hi) {
+    PyObject *res = NULL;
+    PyObject *res_hi = NULL;
+    PyObject *res_lo = NULL;
+    PyObject *t = NULL;
+
+    ASSIGN_AND_CHECK_NULL(res_hi, PyLong_FromUnsignedLongLong(hi));
+    ASSIGN_AND_CHECK_NULL(res_lo, PyLong_FromUnsignedLongLong(lo));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Lshift(res_hi, Py64));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_Add(t, res_lo));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(res_hi);
+    Py_XDECREF(res_lo);
+    Py_XDECREF(t);
+    return res;
+}
+
+static inline PyObject *
+pylong_from_u128(const uint128_t *ui) {
+    if (U128P_HI(ui) == 0)
+        return PyLong_FromUnsignedLongLong(U128P_LO(ui));
+    else
+        return PyLong_from_u128_lo_hi(U128P_LO(ui), U128P_HI(ui));
+}
+
+// Returns a new reference to the int represented by the digits in dc,
+// ignoring dc->exp.
+static PyObject *
+pylong_from_digit_chunks(const struct rn_digit_chunks *dc) {
+    PyObject *res = NULL;
+    PyObject *hi = NULL;
+    PyObject *scale = NULL;
+    PyObject *tail = NULL;
+    PyObject *t = NULL;
+
+    if (dc->n_chunks == 0)
+        return PyLong_FromUnsignedLongLong(dc->tail);
+    ASSIGN_AND_CHECK_NULL(hi, pylong_from_dec_chunks(dc->chunks,
+                                                     dc->n_chunks));
+    if (dc->n_tail_digits == 0)
+        return hi;
+    ASSIGN_AND_CHECK_NULL(scale, pylong_10_pow_n(dc->n_tail_digits));
+    ASSIGN_AND_CHECK_NULL(tail, PyLong_FromUnsignedLongLong(dc->tail));
+    ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(hi, scale));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_Add(t, tail));
+    goto CLEAN_UP;
+
+ERROR:
+    assert(PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(hi);
+    Py_XDECREF(scale);
+    Py_XDECREF(tail);
+    Py_XDECREF(t);
+    return res;
+}
+
+static inline PyObject *
+rnd_coeff_mul_10_pow_exp(uint128_t *coeff, rn_exp_t exp) {
+    PyObject *res = NULL;
+    PyObject *t = NULL;
+
+    ASSIGN_AND_CHECK_NULL(t, pylong_10_pow_n(exp));
+    ASSIGN_AND_CHECK_NULL(res, pylong_from_u128(coeff));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_InPlaceMultiply(res, t));
+    goto CLEAN_UP;
+
+ERROR:
+    assert (PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(t);
+    return res;
+}
+
+static inline PyObject *
+rnd_coeff_floordiv_10_pow_exp(uint128_t *coeff, rn_exp_t exp) {
+    PyObject *res = NULL;
+    PyObject *t = NULL;
+
+    ASSIGN_AND_CHECK_NULL(t, pylong_10_pow_n(exp));
+    ASSIGN_AND_CHECK_NULL(res, pylong_from_u128(coeff));
+    ASSIGN_AND_CHECK_NULL(res, PyNumber_InPlaceFloorDivide(res, t));
+    goto CLEAN_UP;
+
+ERROR:
+    assert (PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(t);
+    return res;
+}
+
+static inline PyObject *
+rnd_to_int(rn_sign_t sign, uint128_t coeff, rn_exp_t exp) {
+    PyObject *res = NULL;
+    PyObject *abs_res = NULL;
+    int32_t abs_exp = ABS(exp);
+
+    if (abs_exp < UINT64_10_POW_N_CUTOFF) {
+        int32_t sh = u64_10_pow_n(abs_exp);
+        if (exp < 0) {
+            u128_idiv_u64(&coeff, sh);
+            ASSIGN_AND_CHECK_NULL(abs_res, pylong_from_u128(&coeff));
+        }
+        else {
+            uint128_t t = coeff;
+            u128_imul_u64(&t, sh);
+            if (u128_cmp(t, UINT128_MAX) == 0)
+                ASSIGN_AND_CHECK_NULL(abs_res,
+                                      rnd_coeff_mul_10_pow_exp(&coeff, exp));
+            ASSIGN_AND_CHECK_NULL(abs_res, pylong_from_u128(&coeff));
+        }
+    }
+    else if (exp < 0)
+        ASSIGN_AND_CHECK_NULL(abs_res,
+                              rnd_coeff_floordiv_10_pow_exp(&coeff, -exp));
+    else
+        ASSIGN_AND_CHECK_NULL(abs_res, rnd_coeff_mul_10_pow_exp(&coeff, exp));
+    if (sign == RN_SIGN_NEG)
+        ASSIGN_AND_CHECK_NULL(res, PyNumber_Negative(abs_res));
+    else {
+        Py_INCREF(abs_res);
+        res = abs_res;
+    }
+    goto CLEAN_UP;
+
+ERROR:
+    assert (PyErr_Occurred());
+
+CLEAN_UP:
+    Py_XDECREF(abs_res);
+    return res;
+}
+
+static inline PyObject *
+rnq_to_int(rn_sign_t sign, uint64_t num, uint64_t den) {
+    return PyLong_FromLongLong(sign * (int64_t)(num / den));
+}
+
+static inline PyObject *
+rnq_to_float(rn_sign_t sign, uint64_t num, uint64_t den) {
+    return PyFloat_FromDouble(sign * (double)num / den);
+}
+
+#endif //RATIONAL_RN_PYCONV_H
@@ -16,6 +16,7 @@ $Revision$
 #include <stdlib.h>
 
 #include "common.h"
+#include "pylong_math.h"
 #include "rounding.h"
 
 // Python math functions
@@ -71,6 +72,12 @@ rnp_magnitude_pylong(PyIntQuot *quot) {
     PyObject *log10_den = NULL;
     PyObject *log10_quot = NULL;
     PyObject *magn_quot = NULL;
+    PyObject *lhs = NULL;
+    PyObject *rhs = NULL;
+    PyObject *upper = NULL;
+    PyObject *t = NULL;
+    Py_ssize_t magn;
+    int cmp;
 
     ASSIGN_AND_CHECK_NULL(abs_num, PyNumber_Absolute(quot->numerator));
     ASSIGN_AND_CHECK_NULL(log10_num,
@@ -84,16 +91,54 @@ rnp_magnitude_pylong(PyIntQuot *quot) {
     ASSIGN_AND_CHECK_NULL(magn_quot,
                           PyObject_CallFunctionObjArgs(PyNumber_floor,
                                                        log10_quot, NULL));
+    // the logarithms are calculated in floating point, so the result may be
+    // off by one near powers of 10; check 10 ^ magn <= |num| / den < 10 ^
+    // (magn + 1) exactly
+    magn = PyLong_AsSsize_t(magn_quot);
+    if (magn == -1 && PyErr_Occurred())
+        goto ERROR;
+    ASSIGN_AND_CHECK_NULL(t, pylong_10_pow_n(magn < 0 ? -magn : magn));
+    if (magn < 0) {
+        ASSIGN_AND_CHECK_NULL(lhs, PyNumber_Multiply(abs_num, t));
+        Py_INCREF(quot->denominator);
+        rhs = quot->denominator;
+    }
+    else {
+        Py_INCREF(abs_num);
+        lhs = abs_num;
+        ASSIGN_AND_CHECK_NULL(rhs, PyNumber_Multiply(quot->denominator, t));
+    }
+    Py_CLEAR(t);
+    if ((cmp = PyObject_RichCompareBool(lhs, rhs, Py_LT)) == -1)
+        goto ERROR;
+    if (cmp)
+        --magn;
+    else {
+        ASSIGN_AND_CHECK_NULL(t, PyLong_FromLong(10L));
+        ASSIGN_AND_CHECK_NULL(upper, PyNumber_Multiply(rhs, t));
+        if ((cmp = PyObject_RichCompareBool(lhs, upper, Py_GE)) == -1)
+            goto ERROR;
+        if (!cmp)
+            goto CLEAN_UP;
+        ++magn;
+    }
+    Py_DECREF(magn_quot);
+    magn_quot = PyLong_FromSsize_t(magn);
     goto CLEAN_UP;
 
 ERROR:
     assert(PyErr_Occurred());
+    Py_CLEAR(magn_quot);
 
 CLEAN_UP:
     Py_XDECREF(abs_num);
     Py_XDECREF(log10_num);
     Py_XDECREF(log10_den);
     Py_XDECREF(log10_quot);
+    Py_XDECREF(lhs);
+    Py_XDECREF(rhs);
+    Py_XDECREF(upper);
+    Py_XDECREF(t);
     return magn_quot;
 }
 
@@ -284,9 +329,7 @@ rnp_adjusted(PyIntQuot *trgt, PyIntQuot *src, rn_prec_t to_prec,
     PyObject *t = NULL;
     PyObject *s = NULL;
 
-    ASSIGN_AND_CHECK_NULL(t, PyLong_FromLong(ABS(to_prec)));
-    ASSIGN_AND_CHECK_NULL(s, PyNumber_Power(PyTEN, t, Py_None));
-    Py_CLEAR(t);
+    ASSIGN_AND_CHECK_NULL(s, pylong_10_pow_n(ABS(to_prec)));
     if (to_prec >= 0) {
         ASSIGN_AND_CHECK_NULL(t, PyNumber_Multiply(src->numerator, s));
         ASSIGN_AND_CHECK_NULL(trgt->numerator,
@@ -13,12 +13,58 @@ $Revision$
 
 #include <assert.h>
 
+#include "librational.h"
 #include "rounding.h"
+#include "uint256_math.h"
 #include "uint64_math.h"
 
-static inline Py_ssize_t
+// Exact magnitude of num / den.
+// With m = magnitude(num) - magnitude(den) the magnitude of the quotient is
+// either m or m - 1, depending on whether num / den >= 10 ^ m.
+static inline int
 rnq_magnitude(uint64_t num, uint64_t den) {
-    return (Py_ssize_t)floor(log10(num) - log10(den));
+    int magn = u64_magnitude(num) - u64_magnitude(den);
+    uint128_t n, d;
+
+    if (magn >= 0) {
+        U128_FROM_LO_HI(&n, num, 0ULL);
+        u64_mul_u64(&d, den, u64_10_pow_n(magn));
+    }
+    else {
+        u64_mul_u64(&n, num, u64_10_pow_n(-magn));
+        U128_FROM_LO_HI(&d, den, 0ULL);
+    }
+    return magn - u128_lt(n, d);
+}
+
+// Compare x_num / x_den and y_num / y_den (all > 0)
+static inline int
+rnq_cmp(uint64_t x_num, uint64_t x_den, uint64_t y_num, uint64_t y_den) {
+    uint128_t lhs, rhs;
+
+    u64_mul_u64(&lhs, x_num, y_den);
+    u64_mul_u64(&rhs, y_num, x_den);
+    return u128_cmp(lhs, rhs);
+}
+
+// Compare num / den and coeff * 10 ^ exp (all > 0)
+// pre-condition: same magnitude
+static inline int
+rnq_cmp_fpdec(uint64_t num, uint64_t den, uint128_t coeff, rn_exp_t exp) {
+    uint256_t lhs, rhs;
+    uint128_t t;
+
+    // both cross products are less than 10 * 2 ^ 192, because the
+    // magnitude of num / den is in [-20, 19]
+    U128_FROM_LO_HI(&t, num, 0ULL);
+    u256_from_u128(&lhs, &t);
+    u256_from_u128(&rhs, &coeff);
+    u256_imul_u64(&rhs, den);
+    if (exp > 0)
+        u256_imul_10_pow_n(&rhs, exp);
+    else
+        u256_imul_10_pow_n(&lhs, -exp);
+    return u256_cmp(&lhs, &rhs);
 }
 
 static inline uint64_t
@@ -43,7 +89,7 @@ rnq_reduce_quot(uint64_t *num, uint64_t *den) {
     *den /= d;
 }
 
-static inline error_t
+static inline rn_error_t
 rnq_adjust_quot(uint64_t *num, uint64_t *den, bool neg, rn_prec_t to_prec,
                 enum RN_ROUNDING_MODE rounding_mode) {
     assert(*num > 0 && *den > 0);
@@ -59,7 +105,7 @@ rnq_adjust_quot(uint64_t *num, uint64_t *den, bool neg, rn_prec_t to_prec,
         }
         else {
             if (p > UINT64_10_POW_N_CUTOFF)
-                return -1;
+                return RN_LIMIT_EXCEEDED;
             if (to_prec == 0) {
                 *num = 1;
                 *den = 1;
@@ -73,21 +119,21 @@ rnq_adjust_quot(uint64_t *num, uint64_t *den, bool neg, rn_prec_t to_prec,
                 *den = 1;
             }
         }
-        return 0;
+        return RN_OK;
     }
 
     if (p > UINT64_10_POW_N_CUTOFF)
-        return -1;
+        return RN_LIMIT_EXCEEDED;
 
     if (to_prec > 0) {
         t = u64_10_pow_n(p);
         u64_mul_u64(&n, *num, t);
         U128_FROM_LO_HI(&d, *den, 0ULL);
         u128_idiv_rounded(&n, &d, neg, rounding_mode);
-        p = u128_eliminate_trailing_zeros(&n, UINT64_10_POW_N_CUTOFF);
+        p = u128_eliminate_trailing_zeros(&n, p);
         t /= u64_10_pow_n(p);
         if (U128_HI(n) != 0)
-            return -1;
+            return RN_LIMIT_EXCEEDED;
         *num = U128_LO(n);
         *den = t;
         rnq_reduce_quot(num, den);
@@ -106,17 +152,45 @@ rnq_adjust_quot(uint64_t *num, uint64_t *den, bool neg, rn_prec_t to_prec,
         u64_idiv_rounded(num, *den, neg, rounding_mode);
         *den = 1;
     }
-    return 0;
+    return RN_OK;
 }
 
-static inline PyObject *
-rnq_to_int(rn_sign_t sign, uint64_t num, uint64_t den) {
-    return PyLong_FromLongLong(sign * (int64_t)(num / den));
+// Number of chars needed for the representation of (-1) ^ neg * num / den,
+// num > 0, i.e. "[-]<num>[/<den>]".
+static inline size_t
+rnq_n_chars(bool neg, uint64_t num, uint64_t den) {
+    size_t n_char = u64_magnitude(num) + 1;
+
+    if (den != 1)
+        n_char += u64_magnitude(den) + 2;
+    return n_char + neg;
 }
 
-static inline PyObject *
-rnq_to_float(rn_sign_t sign, uint64_t num, uint64_t den) {
-    return PyFloat_FromDouble(sign * (double)num / den);
+// Write the representation of (-1) ^ neg * num / den, followed by a
+// terminating 0, to buf, which must have room for rnq_n_chars(neg, num, den)
+// + 1 chars. Returns the number of chars written, excluding the terminating 0.
+static inline size_t
+rnq_to_chars(char *buf, bool neg, uint64_t num, uint64_t den) {
+    size_t n_char = rnq_n_chars(neg, num, den);
+    char *cp = buf + n_char;
+
+    // the digits are generated from right to left
+    *cp = 0;
+    if (den != 1) {
+        do {
+            *(--cp) = (char)('0' + den % 10);
+            den /= 10;
+        } while (den > 0);
+        *(--cp) = '/';
+    }
+    do {
+        *(--cp) = (char)('0' + num % 10);
+        num /= 10;
+    } while (num > 0);
+    if (neg)
+        *(--cp) = '-';
+    assert(cp == buf);
+    return n_char;
 }
 
 #endif //RATIONAL_RN_U64_QUOT_H
@@ -0,0 +1,266 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Order-preserving binary encoding of rational values ("sort keys"): the
+ * order of the keys as given by memcmp (shorter key first on a common
+ * prefix) equals the numeric order of the encoded values, and equal values
+ * give equal keys.
+ *
+ * 0 is encoded as the single byte RN_SORT_KEY_ZERO, any other x as
+ *
+ *   <sign> <exp> <pairs> <end> [<terms>]
+ *
+ * <sign>   RN_SORT_KEY_NEG or RN_SORT_KEY_POS. (0x00 and 0xff never start a
+ *          key, so they can serve as open bounds.)
+ * <exp>    E with 100 ^ E <= |x| < 100 ^ (E + 1), as order-preserving
+ *          signed varint
+ * <pairs>  the leading RN_SORT_KEY_N_PAIRS base-100 digits of |x|, i.e. the
+ *          integral part of |x| / 100 ^ (E - RN_SORT_KEY_N_PAIRS + 1),
+ *          without trailing zeros, one byte each (digit + 2)
+ * <end>    RN_SORT_KEY_EXACT, if the pairs represent |x| exactly, otherwise
+ *          RN_SORT_KEY_INEXACT, followed by
+ * <terms>  the continued fraction [0; a1, a2, ... an] of the fractional part
+ *          r of |x| / 100 ^ (E - RN_SORT_KEY_N_PAIRS + 1), terminated by an
+ *          infinite term. As r decreases with the terms at odd positions,
+ *          these are complemented.
+ *
+ * For negative values all bytes following <sign> are complemented. All
+ * parts are self-delimiting, so no key is a prefix of another one, and the
+ * complement reverses the order.
+ *
+ * The coefficient of a fixed-point decimal has at most 39 digits, so these
+ * are always encoded exactly. */
+
+#ifndef RATIONAL_SORT_KEY_H
+#define RATIONAL_SORT_KEY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RN_SORT_KEY_NEG 0x01
+#define RN_SORT_KEY_ZERO 0x02
+#define RN_SORT_KEY_POS 0x03
+
+#define RN_SORT_KEY_EXACT 0x00
+#define RN_SORT_KEY_INEXACT 0x01
+#define RN_SORT_KEY_PAIR_OFFSET 0x02
+
+#define RN_SORT_KEY_N_PAIRS 20
+
+// max number of bytes needed for <sign> <exp> <pairs> <end>
+#define RN_SORT_KEY_MAX_HEAD_LEN (1 + 9 + RN_SORT_KEY_N_PAIRS + 1)
+
+// max abs value of <exp> accepted by the decoder, so that the decimal
+// exponents derived from it are in the range accepted for literals
+#define RN_SORT_KEY_MAX_EXP (INT32_MAX / 2 - RN_SORT_KEY_N_PAIRS)
+
+// max abs value of <exp> of inexact keys: the decoder builds a quotient
+// scaled by 100 ^ |<exp>|, so that a short key with a large <exp> would
+// expand to a huge int; sort_key rejects inexact values beyond this limit
+#define RN_SORT_KEY_MAX_INEXACT_EXP 0x10000
+
+// terms < RN_SORT_KEY_TERM_1 are encoded as single byte, larger ones as
+// RN_SORT_KEY_TERM_1 + n - 1, followed by their n big-endian bytes, if
+// n < RN_SORT_KEY_LONG_TERM - RN_SORT_KEY_TERM_1 + 1, otherwise as
+// RN_SORT_KEY_LONG_TERM, followed by n as 8 big-endian bytes and the bytes
+// of the term
+#define RN_SORT_KEY_TERM_1 0xf8
+#define RN_SORT_KEY_LONG_TERM 0xfe
+#define RN_SORT_KEY_INF_TERM 0xff
+
+// max number of bytes needed for a term fitting into 64 bits
+#define RN_SORT_KEY_MAX_U64_TERM_LEN 9
+
+// Write the big-endian bytes of x > 0, without leading zeros, to buf.
+// Returns the number of bytes written.
+static inline size_t
+u64_to_be_bytes(uint8_t *buf, uint64_t x) {
+    size_t n = 0;
+
+    for (uint64_t t = x; t != 0; t >>= 8U)
+        ++n;
+    for (size_t i = n; i > 0; --i, x >>= 8U)
+        buf[i - 1] = (uint8_t)(x & 0xffU);
+    return n;
+}
+
+// Write <exp> to buf. Returns the number of bytes written.
+static inline size_t
+rn_sort_key_put_exp(uint8_t *buf, int64_t exp) {
+    size_t n;
+
+    if (-0x40 < exp && exp < 0x40) {
+        buf[0] = (uint8_t)(0x80 + exp);
+        return 1;
+    }
+    if (exp > 0) {
+        n = u64_to_be_bytes(buf + 1, (uint64_t)exp);
+        buf[0] = (uint8_t)(0xc0 + n);
+    }
+    else {
+        n = u64_to_be_bytes(buf + 1, -(uint64_t)exp);
+        for (size_t i = 1; i <= n; ++i)
+            buf[i] ^= 0xffU;
+        buf[0] = (uint8_t)(0x40 - n);
+    }
+    return n + 1;
+}
+
+// Read <exp> from buf. Returns the number of bytes read, or 0 if buf does
+// not start with a valid <exp>.
+static inline size_t
+rn_sort_key_get_exp(int64_t *exp, const uint8_t *buf, size_t len) {
+    uint64_t t = 0;
+    size_t n;
+    bool neg;
+
+    if (len == 0)
+        return 0;
+    if (0x40 < buf[0] && buf[0] < 0xc0) {
+        *exp = (int64_t)buf[0] - 0x80;
+        return 1;
+    }
+    neg = buf[0] < 0x80;
+    n = neg ? 0x40U - buf[0] : buf[0] - 0xc0U;
+    if (n < 1 || n > 8 || n >= len)
+        return 0;
+    for (size_t i = 1; i <= n; ++i)
+        t = (t << 8U) + (neg ? buf[i] ^ 0xffU : buf[i]);
+    // encoding must be minimal
+    if (t < 0x40 || t >> (8U * (n - 1)) == 0 || t > RN_SORT_KEY_MAX_EXP)
+        return 0;
+    *exp = neg ? -(int64_t)t : (int64_t)t;
+    return n + 1;
+}
+
+// Write the base-100 digits given by the even number of decimal digits in
+// digits, omitting trailing zeros. Returns the number of bytes written.
+static inline size_t
+rn_sort_key_put_pairs(uint8_t *buf, const char *digits, size_t n_digits) {
+    size_t n = n_digits / 2;
+
+    while (n > 0 && digits[2 * n - 2] == '0' && digits[2 * n - 1] == '0')
+        --n;
+    for (size_t i = 0; i < n; ++i)
+        buf[i] = (uint8_t)(RN_SORT_KEY_PAIR_OFFSET +
+                           10 * (digits[2 * i] - '0') +
+                           (digits[2 * i + 1] - '0'));
+    return n;
+}
+
+// Write the term given by its n > 0 big-endian bytes (without leading
+// zeros). Returns the number of bytes written.
+static inline size_t
+rn_sort_key_put_term(uint8_t *buf, const uint8_t *bytes, size_t n,
+                     bool complement) {
+    const uint8_t mask = complement ? 0xffU : 0U;
+    size_t h;
+
+    if (n == 1 && bytes[0] < RN_SORT_KEY_TERM_1) {
+        buf[0] = bytes[0] ^ mask;
+        return 1;
+    }
+    if (n < RN_SORT_KEY_LONG_TERM - RN_SORT_KEY_TERM_1 + 1) {
+        buf[0] = (uint8_t)((RN_SORT_KEY_TERM_1 + n - 1) ^ mask);
+        h = 1;
+    }
+    else {
+        buf[0] = RN_SORT_KEY_LONG_TERM ^ mask;
+        for (size_t i = 8, t = n; i > 0; --i, t >>= 8U)
+            buf[i] = (uint8_t)((t & 0xffU) ^ mask);
+        h = 9;
+    }
+    for (size_t i = 0; i < n; ++i)
+        buf[h + i] = bytes[i] ^ mask;
+    return h + n;
+}
+
+static inline size_t
+rn_sort_key_put_u64_term(uint8_t *buf, uint64_t a, bool complement) {
+    uint8_t bytes[8];
+    size_t n = u64_to_be_bytes(bytes, a);
+
+    return rn_sort_key_put_term(buf, bytes, n, complement);
+}
+
+static inline size_t
+rn_sort_key_put_inf_term(uint8_t *buf, bool complement) {
+    buf[0] = complement ? 0U : RN_SORT_KEY_INF_TERM;
+    return 1;
+}
+
+// Write the terms of the continued fraction of 0 < p / q < 1, starting at
+// the given position, including the terminating infinite term.
+// Returns the number of bytes written, which is less than 100 *
+// RN_SORT_KEY_MAX_U64_TERM_LEN.
+static inline size_t
+rn_sort_key_put_u64_cont_frac(uint8_t *buf, uint64_t p, uint64_t q,
+                              size_t pos) {
+    uint8_t *cp = buf;
+
+    for (; p != 0; ++pos) {
+        uint64_t t = q % p;
+        cp += rn_sort_key_put_u64_term(cp, q / p, pos & 1U);
+        q = p;
+        p = t;
+    }
+    cp += rn_sort_key_put_inf_term(cp, pos & 1U);
+    return (size_t)(cp - buf);
+}
+
+// Read a term from buf. Its big-endian bytes are copied to bytes (providing
+// space for len bytes) and their number is stored in *n, or 0 for the
+// infinite term. Returns the number of bytes read, or 0 if buf does not start
+// with a valid term.
+static inline size_t
+rn_sort_key_get_term(uint8_t *bytes, size_t *n, const uint8_t *buf,
+                     size_t len, bool complement) {
+    const uint8_t mask = complement ? 0xffU : 0U;
+    uint8_t b;
+    size_t h;
+
+    if (len == 0 || (b = buf[0] ^ mask) == 0)
+        return 0;
+    if (b < RN_SORT_KEY_TERM_1) {
+        bytes[0] = b;
+        *n = 1;
+        return 1;
+    }
+    if (b == RN_SORT_KEY_INF_TERM) {
+        *n = 0;
+        return 1;
+    }
+    if (b < RN_SORT_KEY_LONG_TERM) {
+        *n = b - RN_SORT_KEY_TERM_1 + 1U;
+        h = 1;
+    }
+    else {
+        uint64_t t = 0;
+        if (len < 9)
+            return 0;
+        for (size_t i = 1; i <= 8; ++i)
+            t = (t << 8U) + (uint8_t)(buf[i] ^ mask);
+        if (t < RN_SORT_KEY_LONG_TERM - RN_SORT_KEY_TERM_1 + 1 || t > len)
+            return 0;
+        *n = (size_t)t;
+        h = 9;
+    }
+    if (h + *n > len)
+        return 0;
+    for (size_t i = 0; i < *n; ++i)
+        bytes[i] = buf[h + i] ^ mask;
+    // encoding must be minimal
+    if (bytes[0] == 0 || (*n == 1 && bytes[0] < RN_SORT_KEY_TERM_1))
+        return 0;
+    return h + *n;
+}
+
+#endif //RATIONAL_SORT_KEY_H
@@ -21,6 +21,11 @@ $Revision$
 
 #include "uint64_math.h"
 
+#if defined(_MSC_VER) && _MSC_VER >= 1920 && defined(_M_X64)
+#include <intrin.h>
+#define RN_MSVC_X64_INTRINSICS 1
+#endif
+
 // Large unsigned int
 typedef struct uint128 {
     uint64_t lo;
@@ -37,10 +42,6 @@ static const uint128_t UINT128_MAX = {UINT64_MAX, UINT64_MAX};
 *  Macros
 *****************************************************************************/
 
-// properties
-#define U128_MAGNITUDE(x) ((int) log10(((double) U128_HI(x)) * 0x100000000UL \
-                                       * 0x100000000UL + (double) U128_LO(x)))
-
 // byte assignment
 #define U128_RHS(lo, hi) {(lo), (hi)}
 #define U128_FROM_LO_HI(ui, l, h) do {((uint128_t *)ui)->lo = (l); \
@@ -105,6 +106,62 @@ u128_cmp(const uint128_t x, const uint128_t y) {
     return u128_gt(x, y) - u128_lt(x, y);
 }
 
+// Properties
+
+// powers of 10
+static const uint128_t U128_10_POWS[UINT128_10_POW_N_CUTOFF + 1] = {
+    U128_RHS(1UL, 0UL),
+    U128_RHS(10UL, 0UL),
+    U128_RHS(100UL, 0UL),
+    U128_RHS(1000UL, 0UL),
+    U128_RHS(10000UL, 0UL),
+    U128_RHS(100000UL, 0UL),
+    U128_RHS(1000000UL, 0UL),
+    U128_RHS(10000000UL, 0UL),
+    U128_RHS(100000000UL, 0UL),
+    U128_RHS(1000000000UL, 0UL),
+    U128_RHS(10000000000UL, 0UL),
+    U128_RHS(100000000000UL, 0UL),
+    U128_RHS(1000000000000UL, 0UL),
+    U128_RHS(10000000000000UL, 0UL),
+    U128_RHS(100000000000000UL, 0UL),
+    U128_RHS(1000000000000000UL, 0UL),
+    U128_RHS(10000000000000000UL, 0UL),
+    U128_RHS(100000000000000000UL, 0UL),
+    U128_RHS(1000000000000000000UL, 0UL),
+    U128_RHS(10000000000000000000UL, 0UL),
+    U128_RHS(7766279631452241920UL, 5UL),
+    U128_RHS(3875820019684212736UL, 54UL),
+    U128_RHS(1864712049423024128UL, 542UL),
+    U128_RHS(200376420520689664UL, 5421UL),
+    U128_RHS(2003764205206896640UL, 54210UL),
+    U128_RHS(1590897978359414784UL, 542101UL),
+    U128_RHS(15908979783594147840UL, 5421010UL),
+    U128_RHS(11515845246265065472UL, 54210108UL),
+    U128_RHS(4477988020393345024UL, 542101086UL),
+    U128_RHS(7886392056514347008UL, 5421010862UL),
+    U128_RHS(5076944270305263616UL, 54210108624UL),
+    U128_RHS(13875954555633532928UL, 542101086242UL),
+    U128_RHS(9632337040368467968UL, 5421010862427UL),
+    U128_RHS(4089650035136921600UL, 54210108624275UL),
+    U128_RHS(4003012203950112768UL, 542101086242752UL),
+    U128_RHS(3136633892082024448UL, 5421010862427522UL),
+    U128_RHS(12919594847110692864UL, 54210108624275221UL),
+    U128_RHS(68739955140067328UL, 542101086242752217UL),
+    U128_RHS(687399551400673280UL, 5421010862427522170UL)
+};
+
+// Exact magnitude (i.e. floor(log10(x))) of x > 0, see u64_magnitude
+static inline int
+u128_magnitude(const uint128_t x) {
+    unsigned t;
+
+    if (U128_HI(x) == 0)
+        return u64_magnitude(U128_LO(x));
+    t = ((128U - u64_n_leading_0_bits(U128_HI(x))) * 1233U) >> 12U;
+    return (int)t - u128_lt(x, U128_10_POWS[t]);
+}
+
 // Addition
 
 static inline void
@@ -162,6 +219,12 @@ u128_sub_u128(uint128_t *z, const uint128_t *x, const uint128_t *y) {
 
 static inline void
 u64_mul_u64(uint128_t *z, const uint64_t x, const uint64_t y) {
+#if defined(RN_X86_64_ASM)
+    __asm__("mulq %[y]" : "=a"(U128P_LO(z)), "=d"(U128P_HI(z))
+                        : "a"(x), [y]"rm"(y));
+#elif defined(RN_MSVC_X64_INTRINSICS)
+    U128P_LO(z) = _umul128(x, y, &U128P_HI(z));
+#else
     const uint64_t xl = U64_LO(x);
     const uint64_t xh = U64_HI(x);
     const uint64_t yl = U64_LO(y);
@@ -175,6 +238,7 @@ u64_mul_u64(uint128_t *z, const uint64_t x, const uint64_t y) {
     t = xh * yl + U64_LO(t);
     U128P_LO(z) += (U64_LO(t) << 32U);
     U128P_HI(z) += xh * yh + U64_HI(t);
+#endif
 }
 
 static inline void
@@ -242,13 +306,23 @@ u128_idiv_u32(uint128_t *x, uint32_t y) {
 // found at https://github.com/hcs0/Hackers-Delight/blob/master/divlu.c.txt.
 static inline uint64_t
 u128_idiv_u64_special(uint128_t *x, uint64_t y) {
+    assert(U64_HI(y) != 0);
+    assert(U128P_HI(x) < y);
+
+#if defined(RN_X86_64_ASM)
+    uint64_t r = u64_divq(&U128P_LO(x), U128P_HI(x), U128P_LO(x), y);
+    U128P_HI(x) = 0;
+    return r;
+#elif defined(RN_MSVC_X64_INTRINSICS)
+    uint64_t r;
+    U128P_LO(x) = _udiv128(U128P_HI(x), U128P_LO(x), y, &r);
+    U128P_HI(x) = 0;
+    return r;
+#else
     const uint64_t b = 1UL << 32U;
     unsigned n_bits;
     uint64_t xn0, xn1, xn10, xn32, yn0, yn1, q0, q1, t, rhat;
 
-    assert(U64_HI(y) != 0);
-    assert(U128P_HI(x) < y);
-
     // Normalize dividend and divisor, so that y > 2^63 (i.e. highest bit set)
     n_bits = u64_n_leading_0_bits(y);
     y <<= n_bits;
@@ -299,6 +373,7 @@ u128_idiv_u64_special(uint128_t *x, uint64_t y) {
     U128P_LO(x) = q1 * b + q0;
     // Denormalize remainder
     return (t * b + xn0 - q0 * y) >> n_bits;
+#endif
 }
 
 static inline uint64_t
@@ -344,12 +419,22 @@ u128_idiv_u128_special(uint128_t *r, uint128_t *x, const uint128_t *y) {
     // Normalize dividend and divisor, so that U128P_HI(y) > 2^63
     // (i.e. highest bit set)
     n_bits_left = u64_n_leading_0_bits(U128P_HI(y));   // n_bits_left < 64
-    n_bits_right = 64 - n_bits_left;
-    yn[0] = U128P_LO(y) << n_bits_left;
-    yn[1] = (U128P_HI(y) << n_bits_left) + (U128P_LO(y) >> n_bits_right);
-    xn[0] = U128P_LO(x) << n_bits_left;
-    xn[1] = (U128P_HI(x) << n_bits_left) + (U128P_LO(x) >> n_bits_right);
-    xn[2] = U128P_HI(x) >> n_bits_right;
+    if (n_bits_left == 0) {
+        // already normalized (and shifting by 64 bits would be undefined)
+        yn[0] = U128P_LO(y);
+        yn[1] = U128P_HI(y);
+        xn[0] = U128P_LO(x);
+        xn[1] = U128P_HI(x);
+        xn[2] = 0;
+    }
+    else {
+        n_bits_right = 64 - n_bits_left;
+        yn[0] = U128P_LO(y) << n_bits_left;
+        yn[1] = (U128P_HI(y) << n_bits_left) + (U128P_LO(y) >> n_bits_right);
+        xn[0] = U128P_LO(x) << n_bits_left;
+        xn[1] = (U128P_HI(x) << n_bits_left) + (U128P_LO(x) >> n_bits_right);
+        xn[2] = U128P_HI(x) >> n_bits_right;
+    }
 
     // m = 2, n = 2
     // D2: Loop j not nessary because j = m - n = 0
@@ -427,9 +512,22 @@ u128_shift_right(const uint128_t *x, unsigned n_bits) {
     assert(n_bits < 64U);
     uint128_t t;
 
+    if (n_bits == 0)
+        return *x;
     U128P_HI(&t) = U128P_HI(x) >> n_bits;
-    U128P_LO(&t) = ((U128P_HI(x) % (1U << n_bits)) << (64U - n_bits)) +
-                   (U128P_LO(x) >> n_bits);
+    U128P_LO(&t) = (U128P_HI(x) << (64U - n_bits)) + (U128P_LO(x) >> n_bits);
+    return t;
+}
+
+static inline uint128_t
+u128_shift_left(const uint128_t *x, unsigned n_bits) {
+    assert(n_bits < 64U);
+    uint128_t t;
+
+    if (n_bits == 0)
+        return *x;
+    U128P_HI(&t) = (U128P_HI(x) << n_bits) + (U128P_LO(x) >> (64U - n_bits));
+    U128P_LO(&t) = U128P_LO(x) << n_bits;
     return t;
 }
 
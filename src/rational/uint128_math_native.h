@@ -31,9 +31,6 @@ static const uint128_t UINT128_MAX =
 *  Macros
 *****************************************************************************/
 
-// properties
-#define U128_MAGNITUDE(x) ((int) log10((double) x))
-
 // byte assignment
 #define U128_RHS(lo, hi) (((uint128_t)(hi) << 64U) + (lo))
 #define U128_FROM_LO_HI(ui, lo, hi) *ui = U128_RHS((lo),( hi))
@@ -94,6 +91,62 @@ u128_cmp(const uint128_t x, const uint128_t y) {
     return u128_gt(x, y) - u128_lt(x, y);
 }
 
+// Properties
+
+// powers of 10
+static const uint128_t U128_10_POWS[UINT128_10_POW_N_CUTOFF + 1] = {
+    U128_RHS(1UL, 0UL),
+    U128_RHS(10UL, 0UL),
+    U128_RHS(100UL, 0UL),
+    U128_RHS(1000UL, 0UL),
+    U128_RHS(10000UL, 0UL),
+    U128_RHS(100000UL, 0UL),
+    U128_RHS(1000000UL, 0UL),
+    U128_RHS(10000000UL, 0UL),
+    U128_RHS(100000000UL, 0UL),
+    U128_RHS(1000000000UL, 0UL),
+    U128_RHS(10000000000UL, 0UL),
+    U128_RHS(100000000000UL, 0UL),
+    U128_RHS(1000000000000UL, 0UL),
+    U128_RHS(10000000000000UL, 0UL),
+    U128_RHS(100000000000000UL, 0UL),
+    U128_RHS(1000000000000000UL, 0UL),
+    U128_RHS(10000000000000000UL, 0UL),
+    U128_RHS(100000000000000000UL, 0UL),
+    U128_RHS(1000000000000000000UL, 0UL),
+    U128_RHS(10000000000000000000UL, 0UL),
+    U128_RHS(7766279631452241920UL, 5UL),
+    U128_RHS(3875820019684212736UL, 54UL),
+    U128_RHS(1864712049423024128UL, 542UL),
+    U128_RHS(200376420520689664UL, 5421UL),
+    U128_RHS(2003764205206896640UL, 54210UL),
+    U128_RHS(1590897978359414784UL, 542101UL),
+    U128_RHS(15908979783594147840UL, 5421010UL),
+    U128_RHS(11515845246265065472UL, 54210108UL),
+    U128_RHS(4477988020393345024UL, 542101086UL),
+    U128_RHS(7886392056514347008UL, 5421010862UL),
+    U128_RHS(5076944270305263616UL, 54210108624UL),
+    U128_RHS(13875954555633532928UL, 542101086242UL),
+    U128_RHS(9632337040368467968UL, 5421010862427UL),
+    U128_RHS(4089650035136921600UL, 54210108624275UL),
+    U128_RHS(4003012203950112768UL, 542101086242752UL),
+    U128_RHS(3136633892082024448UL, 5421010862427522UL),
+    U128_RHS(12919594847110692864UL, 54210108624275221UL),
+    U128_RHS(68739955140067328UL, 542101086242752217UL),
+    U128_RHS(687399551400673280UL, 5421010862427522170UL)
+};
+
+// Exact magnitude (i.e. floor(log10(x))) of x > 0, see u64_magnitude
+static inline int
+u128_magnitude(const uint128_t x) {
+    unsigned t;
+
+    if (U128_HI(x) == 0)
+        return u64_magnitude(U128_LO(x));
+    t = ((128U - u64_n_leading_0_bits(U128_HI(x))) * 1233U) >> 12U;
+    return (int)t - u128_lt(x, U128_10_POWS[t]);
+}
+
 // Addition
 
 static inline void
@@ -157,11 +210,31 @@ u128_imul_10_pow_n(uint128_t *x, const uint8_t n) {
 // Division
 
 static inline uint64_t
-u128_idiv_u32(uint128_t *x, uint32_t y) {
+u128_idiv_u64(uint128_t *x, const uint64_t y) {
     assert(y != 0);
+#ifdef RN_X86_64_ASM
+    uint64_t hi = U128P_HI(x);
+    uint64_t q_hi = 0;
+    uint64_t q_lo, r;
+
+    if (hi >= y) {
+        q_hi = hi / y;
+        hi %= y;
+    }
+    r = u64_divq(&q_lo, hi, U128P_LO(x), y);
+    *x = U128_RHS(q_lo, q_hi);
+    return r;
+#else
     uint128_t t = *x;
     *x /= y;
     return (uint64_t)(t - *x * y);
+#endif // RN_X86_64_ASM
+}
+
+static inline uint64_t
+u128_idiv_u32(uint128_t *x, uint32_t y) {
+    assert(y != 0);
+    return u128_idiv_u64(x, y);
 }
 
 // Not really needed, but to be compatible with uint128_math.h
@@ -169,34 +242,52 @@ static inline uint64_t
 u128_idiv_u64_special(uint128_t *x, uint64_t y) {
     assert(U64_HI(y) != 0);
     assert(U128P_HI(x) < y);
-    uint128_t t = *x;
-    *x /= y;
-    return (uint64_t)(t - *x * y);
+    return u128_idiv_u64(x, y);
 }
 
-static inline uint64_t
-u128_idiv_u64(uint128_t *x, const uint64_t y) {
-    assert(y != 0);
-    uint128_t t = *x;
-    *x /= y;
-    return (uint64_t)(t - *x * y);
-}
-
-// Not really needed, but to be compatible with uint128_math.h
 static inline void
 u128_idiv_u128_special(uint128_t *r, uint128_t *x, const uint128_t *y) {
     assert(U128P_HI(y) != 0);
     assert(u128_cmp(*x, *y) >= 0);
+#ifdef RN_X86_64_ASM
+    // Adapted from Henry S. Warren, Hacker's Delight, 2nd ed., 9-5:
+    // the quotient fits into 64 bits, so it can be estimated by dividing
+    // x / 2 by the normalized high word of y; the estimation is at most one
+    // too high or too low after de-normalization.
+    unsigned n_bits = u64_n_leading_0_bits(U128P_HI(y));
+    uint64_t y_hi = U128_HI(*y << n_bits);
+    uint128_t t = *x >> 1U;
+    uint64_t q;
+
+    u64_divq(&q, U128_HI(t), U128_LO(t), y_hi);
+    q >>= 63U - n_bits;
+    if (q != 0)
+        --q;
+    *r = *x - (uint128_t)q * *y;
+    if (*r >= *y) {
+        ++q;
+        *r -= *y;
+    }
+    *x = q;
+#else
     uint128_t t = *x;
     *x /= *y;
     *r = t - *x * *y;
+#endif // RN_X86_64_ASM
 }
 
 static inline void
 u128_idiv_u128(uint128_t *r, uint128_t *x, const uint128_t *y) {
-    uint128_t t = *x;
-    *x /= *y;
-    *r = t - *x * *y;
+    if (U128P_HI(y) == 0) {
+        *r = u128_idiv_u64(x, U128P_LO(y));
+        return;
+    }
+    if (*x < *y) {
+        *r = *x;
+        *x = 0;
+        return;
+    }
+    u128_idiv_u128_special(r, x, y);
 }
 
 static inline uint64_t
@@ -212,6 +303,12 @@ u128_shift_right(const uint128_t *x, unsigned n_bits) {
     return *x >> n_bits;
 }
 
+static inline uint128_t
+u128_shift_left(const uint128_t *x, unsigned n_bits) {
+    assert(n_bits < 64U);
+    return *x << n_bits;
+}
+
 static inline unsigned
 u128_eliminate_trailing_zeros(uint128_t *x, unsigned n_max) {
     unsigned n_trailing_zeros = 0;
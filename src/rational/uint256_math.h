@@ -0,0 +1,72 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Minimal unsigned 256-bit arithmetic: just enough to compare scaled
+ * 128-bit coefficients and cross products of quotients exactly. */
+
+#ifndef RATIONAL_UINT256_MATH_H
+#define RATIONAL_UINT256_MATH_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef __SIZEOF_INT128__
+#include "uint128_math_native.h"
+#else
+#include "uint128_math.h"
+#endif // __int128
+
+// little-endian 64-bit limbs
+typedef struct {
+    uint64_t w[4];
+} uint256_t;
+
+static inline void
+u256_from_u128(uint256_t *z, const uint128_t *x) {
+    z->w[0] = U128P_LO(x);
+    z->w[1] = U128P_HI(x);
+    z->w[2] = 0;
+    z->w[3] = 0;
+}
+
+// x *= y; the product must fit into 256 bits
+static inline void
+u256_imul_u64(uint256_t *x, const uint64_t y) {
+    uint64_t carry = 0;
+    uint128_t t;
+
+    for (unsigned i = 0; i < 4; ++i) {
+        u64_mul_u64(&t, x->w[i], y);
+        u128_iadd_u64(&t, carry);
+        x->w[i] = U128_LO(t);
+        carry = U128_HI(t);
+    }
+    assert(carry == 0);
+}
+
+// x *= 10 ^ n; the product must fit into 256 bits
+static inline void
+u256_imul_10_pow_n(uint256_t *x, unsigned n) {
+    for (; n > UINT64_10_POW_N_CUTOFF; n -= UINT64_10_POW_N_CUTOFF)
+        u256_imul_u64(x, u64_10_pow_n(UINT64_10_POW_N_CUTOFF));
+    if (n > 0)
+        u256_imul_u64(x, u64_10_pow_n(n));
+}
+
+static inline int
+u256_cmp(const uint256_t *x, const uint256_t *y) {
+    for (unsigned i = 4; i > 0; --i) {
+        if (x->w[i - 1] != y->w[i - 1])
+            return x->w[i - 1] < y->w[i - 1] ? -1 : 1;
+    }
+    return 0;
+}
+
+#endif //RATIONAL_UINT256_MATH_H
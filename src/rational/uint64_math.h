@@ -36,9 +36,6 @@ $Revision$
 #define FLOOR(a, b) (((a) % (b)) < 0 ? (a) / (b) - 1 : (a) / (b))
 #define MOD(a, b) ((a) - FLOOR((a), (b)) * (b))
 
-// properties
-#define U64_MAGNITUDE(x) ((int) log10(x))
-
 /*****************************************************************************
 *  Functions
 *****************************************************************************/
@@ -63,7 +60,21 @@ u64_most_signif_bit_pos(uint64_t x) {
 static inline unsigned
 u64_n_leading_0_bits(const uint64_t x) {
     if (x == 0) return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clzll(x);
+#else
     return 63 - u64_most_signif_bit_pos(x);
+#endif
+}
+
+static inline unsigned
+u64_n_trailing_0_bits(const uint64_t x) {
+    if (x == 0) return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    return u64_most_signif_bit_pos(x & -x);
+#endif
 }
 
 static inline bool
@@ -76,6 +87,25 @@ u64_is_even(const uint64_t x) {
     return !u64_is_uneven(x);
 }
 
+// Division
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// Division of a 128-bit int (given as hi, lo) by a 64-bit int can be done
+// with a single instruction on x86_64 (available on every CPU of this
+// architecture), provided the quotient fits into 64 bits, i.e. hi < y.
+// Otherwise the compiler calls __udivti3 / __umodti3 for a variable divisor.
+#define RN_X86_64_ASM 1
+
+static inline uint64_t
+u64_divq(uint64_t *q, uint64_t hi, uint64_t lo, uint64_t y) {
+    uint64_t r;
+
+    assert(hi < y);
+    __asm__("divq %[y]" : "=a"(*q), "=d"(r) : "a"(lo), "d"(hi), [y]"rm"(y));
+    return r;
+}
+#endif // x86_64
+
 // powers of 10
 #define UINT64_10_POW_N_CUTOFF 19
 static uint64_t U64_10_POWS[20] = {
@@ -107,4 +137,17 @@ u64_10_pow_n(unsigned int exp) {
     return U64_10_POWS[exp];
 }
 
+// properties
+
+// Exact magnitude (i.e. floor(log10(x))) of x > 0.
+// The number of significant bits of x times 1233 / 4096 (which is slightly
+// above log10(2)) gives an estimation which is either exact or one too high,
+// so it has to be corrected by a single comparison.
+static inline int
+u64_magnitude(const uint64_t x) {
+    assert(x != 0);
+    unsigned t = ((64U - u64_n_leading_0_bits(x)) * 1233U) >> 12U;
+    return (int)t - (x < U64_10_POWS[t]);
+}
+
 #endif //RATIONAL_UINT64_MATH_H
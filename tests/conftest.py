@@ -15,7 +15,9 @@
 
 import pytest
 
-from rational import Rounding, get_dflt_rounding_mode, set_dflt_rounding_mode
+from rational import (
+    Rounding, get_dflt_rounding_mode, set_dflt_rounding_mode, set_str_policy,
+)
 
 
 @pytest.fixture(scope="session",
@@ -37,3 +39,17 @@ def dflt_round(rnd):
 
 with_round_half_up = dflt_round(Rounding.ROUND_HALF_UP)
 with_round_half_even = dflt_round(Rounding.ROUND_HALF_EVEN)
+
+
+@pytest.fixture()
+def str_policy():
+    """Set the str policy given as arguments, restoring the previous one."""
+    prev_policy = []
+
+    def set_policy(*args, **kwds):
+        prev = set_str_policy(*args, **kwds)
+        if not prev_policy:
+            prev_policy.append(prev)
+    yield set_policy
+    if prev_policy:
+        set_str_policy(*prev_policy[0])
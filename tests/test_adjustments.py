@@ -61,8 +61,9 @@ def test_adjust_half_even_hypo_frac(with_round_half_even, value, prec):
 @pytest.mark.parametrize("value",
                          ("17.849",
                           ".".join(("1" * 3297, "4" * 33)),
-                          "0.00015"),
-                         ids=("compact", "large", "fraction"))
+                          "0.00015",
+                          7000),
+                         ids=("compact", "large", "fraction", "exact"))
 @pytest.mark.parametrize("prec", (1, -3, 5), ids=("1", "-3", "5"))
 def test_adjust_exam(rnd, value, prec):
     set_dflt_rounding_mode(rnd)
@@ -57,6 +57,116 @@ def test_cmp(op, x, y):
     assert op(y1, -x1) == op(y2, -x2)
 
 
+@pytest.mark.parametrize("x, y",
+                         (("1.5", "1.2"),
+                          (2 ** 128 - 1, "3.5E+38"),
+                          (2 ** 128 - 2, "3.40282366920938463463374607431"
+                                         "76821146E+38"),
+                          ("1/3", "2/7"),
+                          ("18446744073709551615/18446744073709551614",
+                           "18446744073709551614/18446744073709551613"),
+                          ("1/3", "0.3333333333333333333333333333333333333"),
+                          ("1/18446744073709551615",
+                           "5.42101086242752217003726400434970855712890625"
+                           "E-20"),
+                          ("12345678901234567890/7", str(12345678901234567890
+                                                         // 7)),
+                          ("3/7", "3/7")),
+                         ids=("fpdec", "fpdec_wide_gap", "fpdec_close",
+                              "u64_quot", "u64_quot_close", "u64_quot_fpdec",
+                              "u64_quot_fpdec_small", "u64_quot_fpdec_large",
+                              "u64_quot_eq"))
+@pytest.mark.parametrize("op",
+                         [op for op in CMP_OPS],
+                         ids=[op.__name__ for op in CMP_OPS])
+def test_cmp_same_magnitude(op, x, y):
+    x1 = Rational(x)
+    x2 = Fraction(x)
+    y1 = Rational(y)
+    y2 = Fraction(y)
+    assert op(x1, y1) == op(x2, y2)
+    assert op(y1, x1) == op(y2, x2)
+    assert op(-x1, -y1) == op(-x2, -y2)
+    assert op(-y1, -x1) == op(-y2, -x2)
+
+
+@pytest.mark.parametrize("y",
+                         (0, 7, -2 ** 63, 2 ** 63, 10 ** 40, True),
+                         ids=("zero", "compact", "int64_min", "uint64",
+                              "large", "bool"))
+@pytest.mark.parametrize("x",
+                         ("7", "-9223372036854775808", "6.99999", "7/3",
+                          "-1/18446744073709551616", "10" * 20 + "/3"),
+                         ids=("fpdec", "fpdec_int64_min", "fpdec_frac",
+                              "u64_quot", "small_quot", "large_quot"))
+@pytest.mark.parametrize("op",
+                         [op for op in CMP_OPS],
+                         ids=[op.__name__ for op in CMP_OPS])
+def test_cmp_int(op, x, y):
+    x1 = Rational(x)
+    x2 = Fraction(x)
+    assert op(x1, y) == op(x2, y)
+    assert op(y, x1) == op(y, x2)
+    assert op(-x1, y) == op(-x2, y)
+    assert op(y, -x1) == op(y, -x2)
+
+
+@pytest.mark.parametrize("y",
+                         (0.0, 7.0, 0.1, 1e-5, 2.0 ** -63, 2.0 ** 75,
+                          2.0 ** 76, sys.float_info.max,
+                          sys.float_info.min * sys.float_info.epsilon),
+                         ids=("zero", "compact", "fraction", "small",
+                              "u64_den", "u128_int", "large", "max",
+                              "min_subnormal"))
+@pytest.mark.parametrize("x",
+                         ("7", "0.1", "0.1000000000000000055511151231257827",
+                          "1/10", "1/9223372036854775808",
+                          str(2 ** 75), "10" * 20 + "/3"),
+                         ids=("fpdec", "fpdec_frac", "fpdec_close",
+                              "u64_quot", "u64_quot_pow2", "fpdec_pow2",
+                              "large_quot"))
+@pytest.mark.parametrize("op",
+                         [op for op in CMP_OPS],
+                         ids=[op.__name__ for op in CMP_OPS])
+def test_cmp_float(op, x, y):
+    x1 = Rational(x)
+    x2 = Fraction(x)
+    assert op(x1, y) == op(x2, y)
+    assert op(y, x1) == op(y, x2)
+    assert op(-x1, y) == op(-x2, y)
+    assert op(y, -x1) == op(y, -x2)
+    assert op(x1, -y) == op(x2, -y)
+
+
+@pytest.mark.parametrize("y",
+                         ("0", "-0", "12.340", "12.34000001", "1E+300",
+                          "1E-300", "1E+40000", "3.4E+38",
+                          "340282366920938463463374607431768211455",
+                          "1" * 50 + "E-30", "Infinity", "-Infinity"),
+                         ids=("zero", "neg_zero", "equal", "close",
+                              "large_exp", "small_exp", "huge_exp", "u128",
+                              "u128_max", "long", "inf", "neg_inf"))
+@pytest.mark.parametrize("x",
+                         ("12.34", "1E+300", "3.5E+38", "1/3",
+                          "11111111111111111111.11111111111111111111"
+                          "11111111111111111111",
+                          "1" * 50 + "E-30"),
+                         ids=("fpdec", "fpdec_large_exp", "fpdec_u128",
+                              "u64_quot", "large", "long"))
+@pytest.mark.parametrize("op",
+                         [op for op in CMP_OPS],
+                         ids=[op.__name__ for op in CMP_OPS])
+def test_cmp_decimal(op, x, y):
+    x1 = Rational(x)
+    x2 = Fraction(x)
+    y = Decimal(y)
+    y2 = Fraction(y) if y.is_finite() else y
+    assert op(x1, y) == op(x2, y2)
+    assert op(y, x1) == op(y2, x2)
+    assert op(-x1, y) == op(-x2, y2)
+    assert op(x1, -y) == op(x2, -y2)
+
+
 # noinspection PyMissingOrEmptyDocstring
 def chk_eq(dec, equiv):
     assert dec == equiv
@@ -138,6 +248,34 @@ def test_eq_complex(value):
     assert not(non_equiv == rn)
 
 
+HASH_MODULUS = sys.hash_info.modulus
+
+
+@pytest.mark.parametrize("num, den",
+                         ((-1, 1),
+                          (-3, 2),
+                          (17, 10 ** 40),
+                          (-12345678901234567890123456789, 10 ** 30),
+                          (7 * 10 ** 300, 1),
+                          (2 ** 64 - 1, 2 ** 64 - 59),
+                          (-1, HASH_MODULUS + 2),
+                          (10 ** 40 + 1, 3 ** 50),
+                          (-(HASH_MODULUS + 1), 3 ** 50),
+                          (1, HASH_MODULUS),
+                          (-5, 3 * HASH_MODULUS),
+                          (1, 2 ** 70 * HASH_MODULUS)),
+                         ids=("minus_one", "compact", "small_exp",
+                              "neg_exp", "large_exp", "u64_quot",
+                              "u64_quot_minus_one", "large",
+                              "large_minus_one", "den_mod_p", "neg_den_mod_p",
+                              "large_den_mod_p"))
+def test_hash(num, den):
+    rn = Rational(num, den)
+    assert hash(rn) == hash(Fraction(num, den))
+    if den == 1:
+        assert hash(rn) == hash(num)
+
+
 # noinspection PyMissingOrEmptyDocstring
 def chk_gt(rn, non_equiv_gt):
     assert rn != non_equiv_gt
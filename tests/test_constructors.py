@@ -12,16 +12,19 @@
 
 """Test driver for package 'rational' (constructors)."""
 
+from array import array
 import copy
 from decimal import Decimal
 from fractions import Fraction
 from numbers import Integral, Real
 import sys
+import unicodedata
 
 import pytest
 
 from rational import (
-    Rational, Rounding, get_dflt_rounding_mode, set_dflt_rounding_mode)
+    Parser, Rational, Rounding, get_dflt_rounding_mode, set_dflt_rounding_mode)
+import rational.rational as rational_module
 
 
 class IntWrapper:
@@ -150,24 +153,393 @@ def test_rational_from_str(value, prec, ratio):
     assert rn.denominator == ratio.denominator
 
 
-@pytest.mark.parametrize("value", ["\u1811\u1817.\u1814", "\u0f20.\u0f24"],
-                         ids=["mongolian", "tibetian"])
+@pytest.mark.parametrize("value", ["\u1811\u1817.\u1814", "\u0f20.\u0f24",
+                                   "\uff11\uff17.\uff15",
+                                   "\U0001D7CF\U0001D7D5.\U0001D7D3"],
+                         ids=["mongolian", "tibetian", "fullwidth",
+                              "math-bold"])
 def test_rational_from_non_ascii_digits(value):
     rn = Rational(value)
     assert isinstance(rn, Rational)
 
 
+def test_rational_from_each_non_ascii_digit():
+    # the digit table is generated from a fixed version of the Unicode
+    # database; with a different version only the digits already defined in
+    # Unicode 3.2 (and still defined now) can be relied on
+    same_version = rational_module._unidata_version == \
+        unicodedata.unidata_version
+    digits = [chr(cp) for cp in range(0x80, sys.maxunicode + 1)
+              if unicodedata.decimal(chr(cp), None) is not None and
+              (same_version or
+               unicodedata.ucd_3_2_0.decimal(chr(cp), None) is not None)]
+    for ch in digits:
+        assert Rational(f"1{ch}") == 10 + unicodedata.decimal(ch)
+        if not same_version:
+            continue
+        # neighbours of each range of digits
+        for cp in (ord(ch) - 1, ord(ch) + 1):
+            if unicodedata.decimal(chr(cp), None) is None:
+                with pytest.raises(ValueError):
+                    Rational(f"1{chr(cp)}")
+
+
+@pytest.mark.parametrize("value",
+                         ("17.5",
+                          "\u0661\u0667.\u0665",
+                          "\U0001E951\U0001E957.\U0001E955",
+                          "\U0001E9517.5",
+                          " " * 40 + "0" * 40 + "17.50",
+                          "\u0661\u0667.\u0665" + "\u0660" * 70),
+                         ids=("1-byte", "2-byte", "4-byte", "4-byte-mixed",
+                              "long-1-byte", "long-2-byte"))
+def test_rational_from_str_of_any_kind(value):
+    rn = Rational(value)
+    assert rn == Fraction(35, 2)
+
+
+@pytest.mark.parametrize(("n_int_digits", "n_frac_digits"),
+                         ((7, 0), (8, 0), (9, 0), (16, 0), (17, 1), (0, 8),
+                          (3, 16), (8, 8), (19, 19), (30, 8), (38, 0),
+                          (24, 15), (39, 0)),
+                         ids=lambda n: str(n))
+def test_rational_from_long_ascii_str(n_int_digits, n_frac_digits):
+    digits = "9876543210" * 4
+    int_part = digits[:n_int_digits]
+    frac_part = digits[-n_frac_digits:] if n_frac_digits else ""
+    value = f"{int_part}.{frac_part}"
+    rn = Rational(value)
+    assert rn == Fraction(value)
+    assert Rational(f"-{value}7e-3") == Fraction(f"-{value}7e-3")
+
+
+@pytest.mark.parametrize(("value", "ratio"),
+                         (("1.25/3", Fraction(5, 12)),
+                          ("-2e3/7", Fraction(-2000, 7)),
+                          (" .5/.25 ", Fraction(2)),
+                          ("1.5E-2/3e1", Fraction(1, 2000)),
+                          ("0.0/7.5", Fraction(0)),
+                          ("7e30/3", Fraction(7 * 10 ** 30, 3)),
+                          ("1/3e20", Fraction(1, 3 * 10 ** 20)),
+                          ("1.7e-200/3e-210", Fraction(17 * 10 ** 9, 3)),
+                          ("123456789012345678901234567.5/5",
+                           Fraction(246913578024691357802469135, 10)),
+                          ("98765432109876543210987654321/"
+                           "12345678901234567890.1",
+                           Fraction(987654321098765432109876543210,
+                                    123456789012345678901))),
+                         ids=("frac-num", "exp-num", "frac-only",
+                              "frac-exp", "zero", "large-num", "large-den",
+                              "small-exps", "u128-fpdec", "u128-quot"))
+def test_rational_from_quot_str(value, ratio):
+    rn = Rational(value)
+    assert rn == ratio
+    assert rn.numerator == ratio.numerator
+    assert rn.denominator == ratio.denominator
+
+
+@pytest.mark.parametrize(("value", "exc"),
+                         (("1.5/", ValueError), ("1/2/3", ValueError),
+                          ("1/-3", ValueError), ("1/e3", ValueError),
+                          ("1/.", ValueError), ("3.5/0.0e7", ZeroDivisionError)),
+                         ids=("missing-den", "two-slashes", "signed-den",
+                              "exp-only", "point-only", "zero-den"))
+def test_rational_from_quot_str_wrong_format(value, exc):
+    with pytest.raises(exc):
+        Rational(value)
+
+
+@pytest.mark.parametrize("value",
+                         ("-" + "31415926535897932384626433832795" * 3,
+                          "0.000" + "27182818284590452353602874713527" * 2,
+                          "1" + "0" * 80 + ".0000e-3",
+                          "\u0661" * 45 + ".\u0665" + "\u0660" * 20,
+                          "12345678901234567890e-50",
+                          "-1844674407370955161600/3",
+                          "9971120675909040510/4464930650000249",
+                          "7/100000000000000000000000000000000000000000",
+                          "1e-40000"),
+                         ids=("long-int", "long-frac", "trailing-zeros",
+                              "non-ascii", "small-exp", "long-num",
+                              "u64-num", "long-den", "large-exp"))
+def test_rational_from_long_str(value):
+    rn = Rational(value)
+    f = Fraction(value.translate({0x660 + i: 0x30 + i for i in range(10)}))
+    assert rn == f
+    assert rn.numerator == f.numerator
+    assert rn.denominator == f.denominator
+
+
+@pytest.mark.parametrize(("value", "exc"),
+                         (("1" * 50 + ".5.", ValueError),
+                          ("1" * 50 + "/1.5.", ValueError),
+                          ("1" * 50 + "e", ValueError),
+                          ("1" * 50 + "e99999999999", ValueError),
+                          ("1" * 50 + "/" + "0" * 50, ZeroDivisionError)),
+                         ids=("two-points", "two-points-den", "missing-exp",
+                              "exp-out-of-range", "zero-den"))
+def test_rational_from_long_str_wrong_format(value, exc):
+    with pytest.raises(exc):
+        Rational(value)
+
+
 @pytest.mark.parametrize("value",
                          (" 1.23.5", "1.24e", "--4.92", "", "   ", "3,49E-3",
-                          "\t+   \r\n"),
+                          "\t+   \r\n", "1\x002", "17.5\xe9",
+                          "1\u06617\uffff"),
                          ids=("two-points", "missing-exp", "double-sign",
                               "empty-string", "blanks", "invalid-char",
-                              "sign-only"))
+                              "sign-only", "embedded-nul", "latin-1-char",
+                              "2-byte-char"))
 def test_rational_from_str_wrong_format(value):
     with pytest.raises(ValueError):
         Rational(value)
 
 
+@pytest.mark.parametrize("value",
+                         (b"17.5", bytearray(b" 35/2\n"),
+                          memoryview(b"0.175e2"), array("b", b"+17.50"),
+                          b"175" + b"0" * 40 + b"e-41",
+                          memoryview(b"3_5_/_2")[::2]),
+                         ids=("bytes", "bytearray", "memoryview", "array",
+                              "large", "non-contiguous"))
+def test_rational_from_bytes_like(value):
+    rn = Rational(value)
+    assert rn == Fraction(35, 2)
+
+
+@pytest.mark.parametrize("value",
+                         (b"1.2.3", b"\xa017.5", b"17.5\xe9", b"1\x002",
+                          bytearray()),
+                         ids=("two-points", "nbsp", "latin-1-char",
+                              "embedded-nul", "empty"))
+def test_rational_from_bytes_like_wrong_format(value):
+    with pytest.raises(ValueError):
+        Rational(value)
+
+
+@pytest.mark.parametrize(("start", "end", "ratio"),
+                         ((None, 8, Fraction(-1, 3)),
+                          (9, None, Fraction(27, 2)),
+                          (9, 13, Fraction(27, 2)),
+                          (-4, None, Fraction(27, 2)),
+                          (9, 100, Fraction(27, 2)),
+                          (-100, -6, Fraction(-1, 3))),
+                         ids=("dflt-start", "dflt-end", "start-end",
+                              "negative-start", "end-too-large",
+                              "negative-end"))
+def test_rational_from_ascii(start, end, ratio):
+    buf = b" -1/3   ;13.5"
+    kwds = {}
+    if start is not None:
+        kwds["start"] = start
+    if end is not None:
+        kwds["end"] = end
+    # not contiguous
+    strided = memoryview(bytes(c for b in buf for c in (b, 0)))[::2]
+    for obj in (buf, bytearray(buf), memoryview(buf), strided):
+        rn = Rational.from_ascii(obj, **kwds)
+        assert rn == ratio
+
+
+@pytest.mark.parametrize(("value", "exc"),
+                         (("17.5", TypeError), (17, TypeError),
+                          (b"17.5;", ValueError)),
+                         ids=("str", "int", "invalid"))
+def test_rational_from_ascii_wrong_value(value, exc):
+    with pytest.raises(exc):
+        Rational.from_ascii(value)
+
+
+@pytest.mark.parametrize(("start", "end"),
+                         ((2, 1), (5, 0), (2, 2)),
+                         ids=("start-gt-end", "start-beyond-end",
+                              "start-eq-end"))
+@pytest.mark.parametrize("buf_type", (bytes, bytearray, memoryview, array),
+                         ids=("bytes", "bytearray", "memoryview", "array"))
+def test_rational_from_ascii_empty_slice(start, end, buf_type):
+    buf = buf_type(b"12") if buf_type is not array else array("b", b"12")
+    with pytest.raises(ValueError):
+        Rational.from_ascii(buf, start, end)
+
+
+@pytest.mark.parametrize(("literal", "kwds", "ratio"),
+                         (("1,234.56", {}, Fraction("1234.56")),
+                          ("  (12.50) ", {}, Fraction("-12.5")),
+                          ("12.50-", {}, Fraction("-12.5")),
+                          ("+1,000/3", {}, Fraction(1000, 3)),
+                          ("-1,500e-5", {}, Fraction(-15, 1000)),
+                          ("1,234,567.5", {}, Fraction("1234567.5")),
+                          ("12,345/678,901", {}, Fraction(12345, 678901)),
+                          ("1 234,56",
+                           {"decimal_point": ",", "group_sep": " "},
+                           Fraction("1234.56")),
+                          ("1.234,5-",
+                           {"decimal_point": ",", "group_sep": "."},
+                           Fraction("-1234.5")),
+                          ("1\u2009234,5",
+                           {"decimal_point": ",", "group_sep": "\u2009"},
+                           Fraction("1234.5")),
+                          ("\uff11\uff0c\uff12\uff13\uff14",
+                           {"group_sep": "\uff0c"}, Fraction(1234)),
+                          ("12,5", {"decimal_point": ",", "group_sep": None},
+                           Fraction("12.5")),
+                          ("(" + "1" + ",234" * 40 + ")", {},
+                           -Fraction("1" + "234" * 40))),
+                         ids=("group-sep", "paren", "trailing-sign",
+                              "quot", "exp", "groups", "grouped-quot",
+                              "space-sep", "point-sep",
+                              "thin-space-sep", "fullwidth", "no-sep",
+                              "long"))
+def test_rational_parse(literal, kwds, ratio):
+    rn = Rational.parse(literal, **kwds)
+    assert isinstance(rn, Rational)
+    assert rn == ratio
+
+
+@pytest.mark.parametrize(("literal", "kwds", "exc"),
+                         (("1,,234", {}, ValueError),
+                          (",1", {}, ValueError),
+                          ("1,", {}, ValueError),
+                          ("1.2,3", {}, ValueError),
+                          ("1,5", {}, ValueError),
+                          ("1,234,5678.0", {}, ValueError),
+                          ("1,2345", {}, ValueError),
+                          ("1234,567", {}, ValueError),
+                          ("1,23,456", {}, ValueError),
+                          ("1/1,5", {}, ValueError),
+                          ("(-1)", {}, ValueError),
+                          ("-1-", {}, ValueError),
+                          ("(1", {}, ValueError),
+                          ("1e", {}, ValueError),
+                          ("(1)", {"paren_negative": False}, ValueError),
+                          ("1-", {"trailing_sign": False}, ValueError),
+                          ("1.5", {"decimal_point": ","}, ValueError),
+                          ("1", {"decimal_point": ""}, ValueError),
+                          ("1", {"decimal_point": None}, TypeError),
+                          ("1", {"group_sep": "."}, ValueError),
+                          ("1", {"group_sep": ",,"}, ValueError),
+                          (b"1", {}, TypeError)),
+                         ids=("double-sep", "leading-sep", "trailing-sep",
+                              "sep-in-frac", "short-group", "long-last-group",
+                              "long-group", "long-leading-group",
+                              "short-inner-group", "short-group-in-den",
+                              "paren-and-sign",
+                              "two-signs", "unbalanced-paren", "no-exp",
+                              "paren-disabled", "trailing-sign-disabled",
+                              "wrong-point", "empty-point", "none-point",
+                              "point-eq-sep", "long-sep", "bytes"))
+def test_rational_parse_wrong_value(literal, kwds, exc):
+    with pytest.raises(exc):
+        Rational.parse(literal, **kwds)
+
+
+@pytest.mark.parametrize(("literal", "ratio"),
+                         (("0x1.8p-3", Fraction(3, 16)),
+                          ("  -0X.8P+1 ", Fraction(-1)),
+                          ("1ffp0", Fraction(511)),
+                          ("+0.0p99", Fraction(0)),
+                          ("ABC.DEF", Fraction(0xabcdef, 0x1000)),
+                          ("0x1p-127", Fraction(1, 2 ** 127)),
+                          ("0x1p-200", Fraction(1, 2 ** 200)),
+                          ("0x3p126", Fraction(3 * 2 ** 126)),
+                          ("0x" + "f" * 40 + ".8p-5",
+                           Fraction(2 * 16 ** 40 - 1, 64)),
+                          (float.hex(0.1), Fraction(0.1))),
+                         ids=("float-hex", "neg", "no-prefix", "zero",
+                              "upper", "den-128", "den-large", "int-128",
+                              "long", "float"))
+def test_rational_fromhex(literal, ratio):
+    rn = Rational.fromhex(literal)
+    assert isinstance(rn, Rational)
+    assert rn == ratio
+
+
+@pytest.mark.parametrize(("literal", "exc"),
+                         (("", ValueError),
+                          ("0x", ValueError),
+                          ("0x.p1", ValueError),
+                          ("1p", ValueError),
+                          ("1.8q", ValueError),
+                          ("1 2", ValueError),
+                          ("inf", ValueError),
+                          ("0x\uff11", ValueError),
+                          ("1p99999999999", ValueError),
+                          (b"0x1p0", TypeError)),
+                         ids=("empty", "prefix-only", "no-digits",
+                              "no-exp", "invalid-char", "space", "inf",
+                              "non-ascii", "exp-overflow", "bytes"))
+def test_rational_fromhex_wrong_value(literal, exc):
+    with pytest.raises(exc):
+        Rational.fromhex(literal)
+
+
+parser_input = b"  17.5 -1/3\n2e3\t\t0.%s/7\r\n  -.25e-2 " % (b"1" * 60)
+parser_ratios = [Fraction("17.5"), Fraction(-1, 3), Fraction(2000),
+                 Fraction(int(b"1" * 60), 7 * 10 ** 60), Fraction(-1, 400)]
+
+
+@pytest.mark.parametrize("chunk_size", (1, 2, 3, 7, 16, 1000))
+def test_parser(chunk_size):
+    parser = Parser()
+    res = []
+    for i in range(0, len(parser_input), chunk_size):
+        chunk = parser_input[i:i + chunk_size]
+        rns = parser.feed(memoryview(chunk) if i % 2 else bytearray(chunk))
+        assert all(isinstance(rn, Rational) for rn in rns)
+        res.extend(rns)
+    res.extend(parser.close())
+    assert res == parser_ratios
+    assert parser.pending == b""
+    assert parser.close() == []
+
+
+def test_parser_pending():
+    parser = Parser()
+    assert parser.feed(b"1 2") == [Rational(1)]
+    assert parser.pending == b"2"
+    assert parser.feed(b"5") == []
+    assert parser.pending == b"25"
+    assert parser.feed(b"") == []
+    assert parser.feed(b" ") == [Rational(25)]
+    assert parser.pending == b""
+
+
+@pytest.mark.parametrize(("chunks", "exc", "kept"),
+                         (([b"17.5", b"x"], ValueError, []),
+                          ([b"1 x 2"], ValueError, [1, 2]),
+                          ([b"1 2/", b"x "], ValueError, []),
+                          ([b"17;"], ValueError, []),
+                          (["17.5 "], TypeError, []),
+                          ([17], TypeError, [])),
+                         ids=("invalid-at-close", "invalid", "invalid-split",
+                              "invalid-char", "str", "int"))
+def test_parser_wrong_input(chunks, exc, kept):
+    parser = Parser()
+    with pytest.raises(exc):
+        for chunk in chunks:
+            parser.feed(chunk)
+        parser.close()
+    # values around the invalid literal are kept
+    assert parser.close() == kept
+    assert parser.pending == b""
+    assert parser.feed(b"3 ") == [Rational(3)]
+
+
+def test_parser_resume_after_invalid():
+    parser = Parser()
+    assert parser.feed(b"1 ") == [Rational(1)]
+    with pytest.raises(ValueError):
+        parser.feed(b"5 6 x7 8 9")
+    assert parser.pending == b" 8 9"
+    with pytest.raises(ValueError):
+        parser.feed(b"0 y 4")
+    assert parser.feed(b"2 ") == [Rational(5), Rational(6), Rational(8),
+                                  Rational(90), Rational(42)]
+    assert parser.pending == b""
+    assert parser.close() == []
+
+
 @pytest.mark.parametrize("ratio",
                          (compact_ratio, small_ratio, large_ratio),
                          ids=("compact", "small", "large"))
@@ -178,6 +550,51 @@ def test_rational_from_rational(ratio):
     assert rn.as_fraction() == ratio
 
 
+@pytest.mark.parametrize("prec", (-3, 0, 2, 8, 25))
+@pytest.mark.parametrize(("num", "den"),
+                         (("17.5", None),
+                         ("-0.0000000123456789", None),
+                         ("5960065801598922562/1810326583139", None),
+                         (Fraction(-2, 3), None),
+                         (Decimal("123456789012345678901234567890.125"),
+                          None),
+                         (7, 400),
+                         (-10 ** 30 - 1, 3),
+                         (Rational("2.5"), None),
+                         (1.1, None)),
+                         ids=("dec", "small_dec", "u64_quot", "fraction",
+                              "large_dec", "int_ratio", "large_ratio",
+                              "rational", "float"))
+def test_rational_with_precision(rnd, num, den, prec):
+    rn = Rational(num, den, prec, rnd)
+    prev_rnd = get_dflt_rounding_mode()
+    set_dflt_rounding_mode(rnd)
+    try:
+        assert rn == Rational(num, den).adjusted(prec)
+        assert Rational(num, den, precision=prec) == rn
+    finally:
+        set_dflt_rounding_mode(prev_rnd)
+    num, den = Rational(num, den).as_integer_ratio()
+    if den in (1, 400):
+        quant = Decimal("1e%i" % -prec)
+        eq_dec = (Decimal(num) / den).quantize(quant, rnd.name)
+        assert rn == eq_dec
+
+
+@pytest.mark.parametrize(("kwds", "exc"),
+                         (({"precision": 2.0}, TypeError),
+                          ({"precision": "2"}, TypeError),
+                          ({"precision": 10 ** 5}, ValueError),
+                          ({"precision": 2, "rounding": "ROUND_UP"},
+                           TypeError),
+                          ({"precision": 2, "rounding": 7}, TypeError)),
+                         ids=("float_prec", "str_prec", "prec_too_large",
+                              "str_rounding", "int_rounding"))
+def test_rational_with_precision_wrong_type(kwds, exc):
+    with pytest.raises(exc):
+        Rational("1.25", **kwds)
+
+
 @pytest.mark.parametrize(("value", "prec", "ratio"),
                          ((Decimal("123.4567"), 4,
                            Fraction(1234567, 10000)),
@@ -202,13 +619,16 @@ def test_rational_from_decimal_cls_meth_wrong_type(value):
                          ((compact_coeff, Fraction(compact_coeff, 1)),
                           (small_coeff, Fraction(small_coeff, 1)),
                           (large_coeff, Fraction(large_coeff, 1)),
-                          (IntWrapper(328), Fraction(328, 1))),
-                         ids=("compact", "small", "large", "IntWrapper"))
+                          (IntWrapper(328), Fraction(328, 1)),
+                          (-2 ** 63, Fraction(-2 ** 63, 1))),
+                         ids=("compact", "small", "large", "IntWrapper",
+                              "int64_min"))
 def test_rational_from_integral(value, ratio):
     rn = Rational(value)
     assert isinstance(rn, Rational)
     # assert rn._prec == 0
     assert rn.as_fraction() == ratio
+    assert str(rn) == str(ratio.numerator)
 
 
 @pytest.mark.parametrize(("value", "prec", "ratio"),
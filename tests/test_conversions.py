@@ -12,12 +12,15 @@
 
 
 """Test driver for package 'rational' (conversions)."""
+from decimal import Decimal, localcontext
 import math
 from fractions import Fraction
 
 import pytest
 
-from rational import Rational
+from rational import (
+    Rational, get_str_policy, set_dflt_rounding_mode, set_str_policy,
+)
 
 
 @pytest.mark.parametrize("value",
@@ -126,13 +129,316 @@ def test_str(value, str_):
                           ("-20.7e-3", b"-0.0207"),
                           ("0.0000000000207", b"0.0000000000207"),
                           (887 * 10 ** 14, b"887" + b"0" * 14),
-                          ("-287/8290", b"-287/8290")),
+                          ("-287/8290", b"-287/8290"),
+                          ("-12345678901234567890123456/1234567",
+                           b"-12345678901234567890123456/1234567")),
                          ids=lambda p: str(p))
 def test_bytes(value, bstr):
     q = Rational(value)
     assert bytes(q) == bstr
 
 
+@pytest.mark.parametrize(("value", "sci_str", "eng_str"),
+                         ((None, "0e+00", "0e+00"),
+                          (10 ** 12, "1e+12", "1e+12"),
+                          ("-0.00012345", "-1.2345e-04", "-123.45e-06"),
+                          ("123.45", "1.2345e+02", "123.45e+00"),
+                          ("1.5e30001", "1.5e+30001", "15e+30000"),
+                          (Fraction(1, 2 ** 63),
+                           "1.08420217248550443400745280086994171142578125"
+                           "e-19",
+                           "108.420217248550443400745280086994171142578125"
+                           "e-21"),
+                          (Fraction(-(3 ** 100), 10 ** 200),
+                           "-5.15377520732011331036461129765621272702107522001"
+                           "e-153",
+                           "-5.15377520732011331036461129765621272702107522001"
+                           "e-153")),
+                         ids=("zero", "int", "neg", "fpdec", "large-exp",
+                              "quot", "large-quot"))
+def test_to_sci_str(value, sci_str, eng_str):
+    q = Rational(value)
+    assert q.to_sci_str() == sci_str
+    assert q.to_sci_str(engineering=True) == eng_str
+    assert Rational(sci_str) == Rational(eng_str) == q
+
+
+@pytest.mark.parametrize("value", ("1/3", "-7/10000000000000000000003"),
+                         ids=lambda p: str(p))
+def test_to_sci_str_not_decimal(value):
+    q = Rational(value)
+    with pytest.raises(ValueError):
+        q.to_sci_str()
+
+
+@pytest.mark.parametrize(("value", "engineering", "str_"),
+                         (("1.5e30", False, "1.5e+30"),
+                          ("1.5e30", True, "1.5e+30"),
+                          ("-0.0000012", False, "-0.0000012"),
+                          ("-0.00000012", False, "-1.2e-07"),
+                          ("-0.00000012", True, "-120e-09"),
+                          ("12345678.9", False, "1.23456789e+07"),
+                          ("12345678.9", True, "12.3456789e+06"),
+                          ("1234567.8", False, "1234567.8"),
+                          ("-2/3", False, "-2/3"),
+                          (Fraction(10 ** 50), False, "1e+50"),
+                          (Fraction(-1, 10 ** 50), True, "-10e-51"),
+                          (Fraction(1, 2 ** 30), False,
+                           "9.31322574615478515625e-10"),
+                          (Fraction(10 ** 50, 3), False,
+                           "100000000000000000000000000000000000000000000000000"
+                           "/3")),
+                         ids=lambda p: str(p)[:20])
+def test_str_policy(str_policy, value, engineering, str_):
+    q = Rational(value)
+    str_policy(8, engineering=engineering)
+    assert str(q) == str_
+    assert bytes(q) == str_.encode()
+    assert eval(repr(q)) == q
+    assert format(q, "") == str_
+    assert format(q, ">40") == str_.rjust(40)
+    assert q.to_decimal_str() == Rational(value).to_decimal_str()
+    str_policy()
+    assert get_str_policy() == (None, False)
+    assert "e" not in str(q)
+
+
+@pytest.mark.parametrize(("sci_threshold", "exc"),
+                         ((0, ValueError),
+                          (-5, ValueError),
+                          (1.5, TypeError),
+                          ("5", TypeError),
+                          (True, TypeError)),
+                         ids=lambda p: str(p))
+def test_str_policy_wrong_threshold(sci_threshold, exc):
+    with pytest.raises(exc):
+        set_str_policy(sci_threshold)
+    assert get_str_policy() == (None, False)
+
+
+@pytest.mark.parametrize("value",
+                         (None, "-20.7e-3", "1e60", "-287/8290",
+                          "12345678901234567890123456/1234567"),
+                         ids=lambda p: str(p))
+@pytest.mark.parametrize("offset", (0, 3), ids=("start", "offset"))
+def test_write_into(value, offset):
+    q = Rational(value)
+    bstr = bytes(q)
+    buf = bytearray(b"#" * (offset + len(bstr) + 2))
+    assert q.write_into(buf, offset) == offset + len(bstr)
+    assert buf == b"#" * offset + bstr + b"##"
+    view = memoryview(bytearray(len(bstr)))
+    assert q.write_into(view) == len(bstr)
+    assert view.tobytes() == bstr
+
+
+@pytest.mark.parametrize(("buffer", "offset", "exc"),
+                         ((bytearray(4), 0, ValueError),
+                          (bytearray(8), 4, ValueError),
+                          (bytearray(8), -1, ValueError),
+                          (b"12345678", 0, TypeError),
+                          (memoryview(b"12345678"), 0, TypeError),
+                          (memoryview(b"12"), 0, TypeError),
+                          (memoryview(bytearray(40))[::2], 0, BufferError),
+                          ("12345678", 0, TypeError)),
+                         ids=("too-small", "offset-too-large",
+                              "neg-offset", "bytes", "read-only",
+                              "read-only-too-small", "non-contiguous",
+                              "str"))
+def test_write_into_wrong_buffer(buffer, offset, exc):
+    q = Rational("-1.255")
+    with pytest.raises(exc):
+        q.write_into(buffer, offset)
+
+
+@pytest.mark.parametrize(("value", "fmt_spec", "formatted"),
+                         ((None, "", "0"),
+                          ("-287/8290", "", "-287/8290"),
+                          ("17.5", "", "17.5"),
+                          ("17.5", ".3f", "17.500"),
+                          ("-17.5", "+.0f", "-18"),
+                          ("17.5", "+.0f", "+18"),
+                          ("-0.0049", ".2f", "-0.00"),
+                          ("-0.0049", "z.2f", "0.00"),
+                          ("1234567.891", ",.2f", "1,234,567.89"),
+                          ("-1234567.891", "_.1f", "-1_234_567.9"),
+                          ("1234", "08,", "0,001,234"),
+                          ("-12.5", "010.2f", "-000012.50"),
+                          ("12.5", "*^11.2f", "***12.50***"),
+                          ("12.5", "\u20ac<8", "12.5\u20ac\u20ac\u20ac\u20ac"),
+                          ("-12.5", "=+8", "-   12.5"),
+                          ("3", "#.0f", "3."),
+                          ("3", "#", "3."),
+                          ("-1/3", "#", "-1/3"),
+                          ("-3/4", "#", "-0.75"),
+                          (Fraction(10 ** 30), ">5,", "1" + ",000" * 10),
+                          ("1/3", "", "1/3"),
+                          ("-1/3", ">6", "  -1/3"),
+                          ("1/3", ".4", "0.3333"),
+                          ("2/3", "f", "0.666667"),
+                          ("2/3", ".3e", "6.667e-01"),
+                          ("2/3", "E", "6.666667E-01"),
+                          ("1500", "e", "1.5e+03"),
+                          ("0", ".2e", "0.00e+00"),
+                          ("123456789", ".3g", "1.23e+08"),
+                          ("9.99", ".2g", "10"),
+                          ("0.0001234", "g", "0.0001234"),
+                          ("0.00001234", "G", "1.234E-05"),
+                          ("1/7", "g", "0.142857"),
+                          ("1/8", "#.4g", "0.1250"),
+                          ("0.125", "%", "12.5%"),
+                          ("1/3", ".1%", "33.3%"),
+                          ("-98765432109876543210987654321/7", ".3e",
+                           "-1.411e+28"),
+                          ("1e-40", ".2e", "1.00e-40"),
+                          (Fraction(10 ** 50 + 1, 2), ".1f",
+                           "5" + "0" * 49 + ".5")),
+                         ids=lambda p: str(p))
+def test_format(with_round_half_even, value, fmt_spec, formatted):
+    q = Rational(value)
+    assert format(q, fmt_spec) == formatted
+
+
+@pytest.mark.parametrize("value",
+                         ("17.845", "-0.0125", "2/3", "-5/8",
+                          "123456789012345678901234567890.125"),
+                         ids=lambda p: str(p))
+@pytest.mark.parametrize("fmt_spec", (".2f", ".0f", ".1%"),
+                         ids=lambda p: str(p))
+def test_format_rounding(rnd, value, fmt_spec):
+    set_dflt_rounding_mode(rnd)
+    q = Rational(value)
+    num, den = q.as_integer_ratio()
+    with localcontext() as ctx:
+        ctx.prec = 100
+        ctx.rounding = rnd.name
+        dec = Decimal(num) / Decimal(den)
+        assert format(q, fmt_spec) == format(dec, fmt_spec)
+
+
+@pytest.mark.parametrize("fmt_spec",
+                         ("x", "n", ".f", "10.2fx", "+-5", ",_", "5,,"),
+                         ids=lambda p: str(p))
+def test_format_wrong_spec(fmt_spec):
+    q = Rational("1.5")
+    with pytest.raises(ValueError):
+        format(q, fmt_spec)
+
+
+@pytest.mark.parametrize(("value", "hex_"),
+                         ((None, "0x0p+0"),
+                          (1, "0x1p+0"),
+                          (Fraction(3, 16), "0x1.8p-3"),
+                          ("-20.5", "-0x1.48p+4"),
+                          ("0.0625e3", "0x1.f4p+5"),
+                          (Fraction(-1, 2 ** 64), "-0x1p-64"),
+                          (2 ** 127 + 2 ** 5, "0x1." + "0" * 30 + "4p+127"),
+                          (Fraction(2 ** 200 + 1, 2 ** 70),
+                           "0x1." + "0" * 49 + "1p+130")),
+                         ids=("zero", "one", "quot", "fpdec", "fpdec-exp",
+                              "quot-64", "int-128", "large"))
+def test_hex(value, hex_):
+    q = Rational(value)
+    assert q.hex() == hex_
+    assert float.fromhex(hex_) == float(q)
+
+
+@pytest.mark.parametrize("value",
+                         ("1e100", "-3679299.0270955860614776611328125",
+                          "3/1267650600228229401496703205376",
+                          Fraction(-(3 ** 100), 2 ** 1000)),
+                         ids=("int", "fpdec", "quot", "large"))
+def test_hex_roundtrip(value):
+    q = Rational(value)
+    assert Rational.fromhex(q.hex()) == q
+
+
+@pytest.mark.parametrize("value",
+                         ("1/3", "0.1", "1e-30", "-7/10"),
+                         ids=lambda p: str(p))
+def test_hex_not_dyadic(value):
+    q = Rational(value)
+    with pytest.raises(ValueError):
+        q.hex()
+
+
+@pytest.mark.parametrize(("value", "dec_str"),
+                         ((None, "0"),
+                          ("-15.40", "-15.4"),
+                          ("1/8", "0.125"),
+                          ("1/3", "0.(3)"),
+                          ("1/6", "0.1(6)"),
+                          ("22/7", "3.(142857)"),
+                          ("-1/12", "-0.08(3)"),
+                          (Fraction(1, 3 * 2 ** 70), "0." + "0" * 21 +
+                           "2823443157514334463561075002265473206837972005208"
+                           "(3)"),
+                          (Fraction(10 ** 30, 10 ** 24 - 1),
+                           "1000000.(000000000000000001000000)")),
+                         ids=("zero", "fpdec", "dyadic", "period", "prefix",
+                              "integral", "neg", "large-den",
+                              "large-cofactor"))
+def test_to_decimal_str(value, dec_str):
+    q = Rational(value)
+    assert q.to_decimal_str() == dec_str
+
+
+@pytest.mark.parametrize(("num", "den"),
+                         ((17, 7 * 11 * 13 * 4),
+                          (-1, 97),
+                          (123456789, 7 ** 3 * 5 ** 40),
+                          (10 ** 20 + 1, 3 * 2 ** 64),
+                          (1, 9973 * 8),
+                          (1, 2 ** 70 * 99991),
+                          (7 * 10 ** 5000 + 3, 3 * 2 ** 70),
+                          (5, 7 * (10 ** 23 - 1) // 9 * 2 ** 5),
+                          (1, (10 ** 23 - 1) // 9 * 97 * 109 * 113)),
+                         ids=("small", "long-period", "long-prefix",
+                              "large-den", "large-order", "many-digits",
+                              "large-int", "u128-cofactor",
+                              "u128-large-order"))
+def test_to_decimal_str_roundtrip(num, den):
+    dec_str = Rational(num, den).to_decimal_str(max_digits=10 ** 7)
+    neg = dec_str.startswith("-")
+    int_part, _, frac_part = dec_str.lstrip("-").partition(".")
+    prefix, _, period = frac_part.rstrip(")").partition("(")
+    # Decimal is not subject to the limit on int-to-str conversions
+    f = int(Decimal(int_part)) + Fraction(int(Decimal(prefix or 0)),
+                                          10 ** len(prefix))
+    if period:
+        f += Fraction(int(Decimal(period)),
+                      10 ** len(prefix) * (10 ** len(period) - 1))
+    assert (-f if neg else f) == Fraction(num, den)
+
+
+@pytest.mark.parametrize(("value", "max_digits"),
+                         (("0.001", 2),
+                          ("1/7", 5),
+                          ("1/12", 2),
+                          (Fraction(1, 2 ** 64 + 1), 1000),
+                          (Fraction(1, 3 ** 50), 1000)),
+                         ids=lambda p: str(p))
+def test_to_decimal_str_max_digits(value, max_digits):
+    q = Rational(value)
+    with pytest.raises(ValueError):
+        q.to_decimal_str(max_digits)
+
+
+def test_to_decimal_str_too_long():
+    # period of 3 ** 48 digits, detected without generating any digit
+    q = Rational(1, 3 ** 50)
+    with pytest.raises(MemoryError):
+        q.to_decimal_str()
+
+
+@pytest.mark.parametrize("max_digits", (-1, 1.5, "3"),
+                         ids=lambda p: str(p))
+def test_to_decimal_str_wrong_max_digits(max_digits):
+    q = Rational(1, 3)
+    with pytest.raises((TypeError, ValueError)):
+        q.to_decimal_str(max_digits)
+
+
 @pytest.mark.parametrize(("value", "repr_"),
                          ((None, "Rational(0)"),
                           ("15", "Rational(15)"),
@@ -144,8 +450,107 @@ def test_bytes(value, bstr):
                           ("27/63", "Rational(3, 7)"),
                           ("-287/8290", "Rational(-287, 8290)"),
                           ("12345678901234567890123456/1234567",
-                           "Rational(12345678901234567890123456, 1234567)"),),
+                           "Rational(12345678901234567890123456, 1234567)"),
+                          ("-18446744073709551615/7",
+                           "Rational(-18446744073709551615, 7)"),
+                          (Fraction(1, 2 ** 63),
+                           "Rational(1, 9223372036854775808)"),),
                          ids=lambda p: str(p))
 def test_repr(value, repr_):
     q = Rational(value)
     assert repr(q) == repr_
+
+
+@pytest.mark.parametrize("value", ("-1.5", "1e12", "-2/7", "3" * 40 + "/7"),
+                         ids=("fpdec", "int", "quot", "large-quot"))
+def test_repr_renamed_type(value):
+    q = Rational(value)
+    name = Rational.__name__
+    args = repr(q)[len(name):]
+    try:
+        Rational.__name__ = "Ratiönal"
+        assert repr(q) == "Ratiönal" + args
+    finally:
+        Rational.__name__ = name
+    assert repr(q) == name + args
+
+
+SORT_KEY_VALUES = ("-1e30000", Fraction(-(10 ** 50 + 1), 3), "-12.5",
+                   "-1/3", "-0.0000001", "-1e-30000", None, "1e-30000",
+                   Fraction(1, 2 ** 64), "0.000000999", "0.000001",
+                   Fraction(10 ** 60 + 1, 10 ** 66), "1/3", "0.5",
+                   "4/7", Fraction(4 * 10 ** 40 + 1, 7 * 10 ** 40), 1,
+                   "12.5", "99.999999999999999999999999999999999999",
+                   Fraction(10 ** 45 - 1, 10 ** 43), 100,
+                   "18446744073709551615/7", 10 ** 50 + 1,
+                   Fraction(3 ** 200, 7 ** 50), "1e30000")
+
+
+def test_sort_key_order():
+    values = [Rational(v) for v in SORT_KEY_VALUES]
+    keys = [q.sort_key() for q in values]
+    assert sorted(keys) == keys
+    assert len(set(keys)) == len(keys)
+    assert [Fraction(q) for q in values] == \
+        sorted(Fraction(q) for q in values)
+
+
+@pytest.mark.parametrize(("value", "key"),
+                         ((None, b"\x02"),
+                          ("12.5", b"\x03\x80\x0e4\x00"),
+                          ("-12.5", b"\x01\x7f\xf1\xcb\xff"),
+                          ("0.0007", b"\x03~\t\x00"),
+                          ("1e200", b"\x03\xc1d\x03\x00")),
+                         ids=("zero", "pos", "neg", "small", "large"))
+def test_sort_key(value, key):
+    q = Rational(value)
+    assert q.sort_key() == key
+
+
+@pytest.mark.parametrize("value",
+                         ("-12.5", "1/3", "-4/7", "0.000000999",
+                          "18446744073709551615/7", "1e-30000",
+                          Fraction(3 ** 200, 7 ** 50),
+                          Fraction(-(10 ** 50 + 1), 3)),
+                         ids=("fpdec", "quot", "neg-quot", "small",
+                              "u64-quot", "tiny", "large", "large-neg"))
+@pytest.mark.parametrize("buf_type", (bytes, bytearray, memoryview),
+                         ids=("bytes", "bytearray", "memoryview"))
+def test_from_sort_key(value, buf_type):
+    q = Rational(value)
+    assert Rational.from_sort_key(buf_type(q.sort_key())) == q
+
+
+@pytest.mark.parametrize(("key", "exc"),
+                         ((b"", ValueError),
+                          (b"\x00", ValueError),
+                          (b"\x02\x00", ValueError),
+                          (b"\x03\x80\x0e4", ValueError),
+                          (b"\x03\x80\x0e4\x02\x00", ValueError),
+                          (b"\x03\x80\x02\x0e\x00", ValueError),
+                          (b"\x03\x80\x0ef\x00", ValueError),
+                          (b"\x03\x80\x0e\x01\xfe\xff", ValueError),
+                          (b"\x03\x80\x0e\x00\x00", ValueError),
+                          (bytes.fromhex("013bfaefe1c4efe1c4efe1c4efe1c4efe1"
+                                         "c4efe1c4effe03fdff"), ValueError),
+                          ("\x02", TypeError)),
+                         ids=("empty", "no-sign", "zero-trailing",
+                              "no-end", "trailing-pair", "leading-pair",
+                              "pair-range", "cont-frac-one", "trailing-byte",
+                              "inexact-exp", "str"))
+def test_from_sort_key_wrong_value(key, exc):
+    with pytest.raises(exc):
+        Rational.from_sort_key(key)
+
+
+@pytest.mark.parametrize("value",
+                         (Fraction(10 ** 131076, 3),
+                          Fraction(-1, 3 * 10 ** 131072)),
+                         ids=("large", "tiny"))
+def test_sort_key_inexact_limit(value):
+    q = Rational(value)
+    with pytest.raises(ValueError):
+        q.sort_key()
+    # values within the limit round-trip
+    q = Rational(value * 10 ** 4 if abs(value) < 1 else value / 10 ** 4)
+    assert Rational.from_sort_key(q.sort_key()) == q
@@ -0,0 +1,155 @@
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Test driver for librational (the Python-free core of package
+ * 'rational'). */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "librational.h"
+
+static int n_failed = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, \
+                    __LINE__, #cond); \
+            ++n_failed; \
+        } \
+    } while (0)
+
+// Parse literal and format the result.
+static rn_error_t
+parse_and_format(char *buf, size_t size, const char *literal) {
+    rn_fpdec_t dec;
+    rn_quot_t quot;
+    bool is_quot;
+    rn_error_t rc;
+
+    rc = rn_parse(literal, &dec, &quot, &is_quot);
+    if (rc != RN_OK)
+        return rc;
+    if (is_quot)
+        rn_quot_to_chars(buf, size, &quot);
+    else
+        rn_fpdec_to_chars(buf, size, &dec);
+    return RN_OK;
+}
+
+static void
+test_parse_and_format(void) {
+    static const struct {
+        const char *literal;
+        rn_error_t rc;
+        const char *repr;
+    } cases[] = {
+        {"0", RN_OK, "0"},
+        {"  17.80 ", RN_OK, "17.80"},
+        {"-0.00014", RN_OK, "-0.00014"},
+        {"+12e3", RN_OK, "12000"},
+        {"1.5e-7", RN_OK, "0.00000015"},
+        {"-.5", RN_OK, "-0.5"},
+        {"99999999999999999999999999999999999999", RN_OK,
+         "99999999999999999999999999999999999999"},
+        {"5/7", RN_OK, "5/7"},
+        {"-10/4", RN_OK, "-10/4"},
+        {"1.5/2", RN_OK, "15/20"},
+        {"2e3/.7", RN_OK, "20000/7"},
+        {"123456789012345678901/3", RN_LIMIT_EXCEEDED, ""},
+        {"123456789012345678901234567890123456789", RN_LIMIT_EXCEEDED, ""},
+        {"1e99999", RN_LIMIT_EXCEEDED, ""},
+        {"", RN_INVALID_LITERAL, ""},
+        {"1.5.3", RN_INVALID_LITERAL, ""},
+        {"abc", RN_INVALID_LITERAL, ""},
+        {"3/0", RN_DIVISION_BY_ZERO, ""},
+    };
+    char buf[64];
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        rn_error_t rc;
+
+        buf[0] = 0;
+        rc = parse_and_format(buf, sizeof(buf), cases[i].literal);
+        CHECK(rc == cases[i].rc);
+        CHECK(rc != RN_OK || strcmp(buf, cases[i].repr) == 0);
+    }
+}
+
+static void
+test_format_small_buffer(void) {
+    rn_fpdec_t dec = {true, -3, 12345, 0};
+    rn_quot_t quot = {false, 5, 7};
+    char buf[6] = "xxxxx";
+
+    CHECK(rn_fpdec_to_chars(buf, sizeof(buf), &dec) == 7);
+    CHECK(buf[0] == 0);
+    CHECK(rn_fpdec_to_chars(NULL, 0, &dec) == 7);
+    CHECK(rn_quot_to_chars(buf, 4, &quot) == 3);
+    CHECK(strcmp(buf, "5/7") == 0);
+}
+
+static void
+test_adjust(void) {
+    rn_fpdec_t dec = {false, -3, 17845, 0};
+    rn_quot_t quot = {true, 2, 777};
+    char buf[64];
+
+    CHECK(rn_fpdec_adjust(&dec, 2, RN_ROUND_HALF_EVEN) == RN_OK);
+    rn_fpdec_to_chars(buf, sizeof(buf), &dec);
+    CHECK(strcmp(buf, "17.84") == 0);
+    CHECK(rn_fpdec_adjust(&dec, 1, RN_ROUND_HALF_UP) == RN_OK);
+    rn_fpdec_to_chars(buf, sizeof(buf), &dec);
+    CHECK(strcmp(buf, "17.8") == 0);
+    CHECK(rn_quot_adjust(&quot, 3, RN_ROUND_FLOOR) == RN_OK);
+    rn_quot_to_chars(buf, sizeof(buf), &quot);
+    CHECK(strcmp(buf, "-3/1000") == 0);
+}
+
+static void
+test_convert_and_compare(void) {
+    rn_quot_t quot = {false, 21, 12};
+    rn_fpdec_t x, y = {false, -2, 175, 0};
+
+    CHECK(rn_fpdec_from_quot(&x, &quot) == RN_OK);
+    CHECK(rn_fpdec_cmp(&x, &y) == 0);
+    CHECK(rn_fpdec_magnitude(&x) == 0);
+    quot.den = 3;
+    CHECK(rn_fpdec_from_quot(&x, &quot) == RN_OK);
+    CHECK(rn_fpdec_cmp(&x, &y) == 1);
+    CHECK(rn_fpdec_cmp(&y, &x) == -1);
+    quot.num = 1;
+    CHECK(rn_fpdec_from_quot(&x, &quot) == RN_LIMIT_EXCEEDED);
+    CHECK(rn_quot_magnitude(&quot) == -1);
+    y.neg = true;
+    x = (rn_fpdec_t){true, 0, 2, 0};
+    CHECK(rn_fpdec_cmp(&x, &y) == -1);
+    // 2 ^ 128 - 1 < 3.5E+38, with 35 * 10 ^ 37 exceeding 128 bits
+    x = (rn_fpdec_t){false, 0, UINT64_MAX, UINT64_MAX};
+    y = (rn_fpdec_t){false, 37, 35, 0};
+    CHECK(rn_fpdec_cmp(&x, &y) == -1);
+    CHECK(rn_fpdec_cmp(&y, &x) == 1);
+    x.neg = y.neg = true;
+    CHECK(rn_fpdec_cmp(&x, &y) == 1);
+}
+
+int
+main(void) {
+    test_parse_and_format();
+    test_format_small_buffer();
+    test_adjust();
+    test_convert_and_compare();
+    if (n_failed > 0) {
+        fprintf(stderr, "%d check(s) failed\n", n_failed);
+        return 1;
+    }
+    return 0;
+}
@@ -45,6 +45,34 @@ def test_magnitude_hypo_dec(value):
     assert rn.magnitude == magn
 
 
+@pytest.mark.parametrize(("value", "magn"),
+                         ((10 ** 15 - 1, 14),
+                          (10 ** 15, 15),
+                          (10 ** 19 - 1, 18),
+                          (10 ** 19, 19),
+                          (2 ** 64 - 1, 19),
+                          (10 ** 38 - 1, 37),
+                          (10 ** 38, 38),
+                          ("0.999999999999999999", -1),
+                          ((10 ** 17 - 1, 3 * 10 ** 17), -1),
+                          ((10 ** 17 + 1, 10 ** 17 * 3), -1),
+                          ((3 * 10 ** 18, 3), 18),
+                          ((3 * 10 ** 18 - 1, 3), 17),
+                          ((1, 3 * 10 ** 18), -19),
+                          ((1, 10 ** 19 - 1), -19)),
+                         ids=("1e15-1", "1e15", "1e19-1", "1e19", "2^64-1",
+                              "1e38-1", "1e38", "0.9..9", "q<1/3",
+                              "q>1/3", "q=1e18", "q<1e18", "q=1/3e18",
+                              "q=1/(1e19-1)"))
+def test_magnitude_near_pow10(value, magn):
+    if isinstance(value, tuple):
+        rn = Rational(*value)
+    else:
+        rn = Rational(value)
+    assert rn.magnitude == magn
+    assert (-rn).magnitude == magn
+
+
 def test_magnitude_fail_on_zero():
     rn = Rational()
     with pytest.raises(OverflowError):
@@ -0,0 +1,144 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# ----------------------------------------------------------------------------
+# Copyright:   (c) 2021 ff. Michael Amrhein (michael@adrhinum.de)
+# License:     This program is part of a larger application. For license
+#              details please read the file LICENSE.TXT provided together
+#              with the application.
+# ----------------------------------------------------------------------------
+# $Source$
+# $Revision$
+
+
+"""Generate src/rational/non_ascii_digits.h from the Unicode database.
+
+The header provides a two-level lookup table mapping non-ascii code points
+to the value of the decimal digit they represent: the first level maps
+blocks of BLOCK_SIZE code points to an index into the second level, which
+holds the digit values (or -1) of all code points of a block. Blocks
+without digits share the first entry of the second level.
+
+The table reflects the Unicode database of the Python running this script.
+Its version is recorded in NON_ASCII_DIGIT_UNIDATA_VERSION and exported as
+rational.rational._unidata_version. Python versions based on a different
+version of the Unicode database may therefore accept more or fewer digits
+in int() and str.isdecimal() than the parser does.
+
+Usage: gen_non_ascii_digits.py [output file]
+"""
+
+import os
+import sys
+import textwrap
+import unicodedata
+
+BLOCK_BITS = 6
+BLOCK_SIZE = 1 << BLOCK_BITS
+
+HEADER = """\
+/* ---------------------------------------------------------------------------
+Copyright:   (c) 2020 ff. Michael Amrhein (michael@adrhinum.de)
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+/* Generated by tools/gen_non_ascii_digits.py from the Unicode database
+ * (version {version}) - do not edit. */
+
+#ifndef RATIONAL_NON_ASCII_DIGITS_H
+#define RATIONAL_NON_ASCII_DIGITS_H
+
+#include <stdint.h>
+
+#define NON_ASCII_DIGIT_UNIDATA_VERSION "{version}"
+
+#define NON_ASCII_DIGIT_MIN 0x{min:08X}
+#define NON_ASCII_DIGIT_MAX 0x{max:08X}
+
+#define NON_ASCII_DIGIT_BLOCK_BITS {block_bits}
+#define NON_ASCII_DIGIT_BLOCK_MASK ((1U << NON_ASCII_DIGIT_BLOCK_BITS) - 1U)
+
+"""
+
+FOOTER = """\
+// Value of the decimal digit represented by the non-ascii code point uch,
+// or -1
+static inline int
+lookup_non_ascii_digit(uint32_t uch) {{
+    if (uch < NON_ASCII_DIGIT_MIN || uch > NON_ASCII_DIGIT_MAX)
+        return -1;
+    return NON_ASCII_DIGIT_VALUES
+        [NON_ASCII_DIGIT_BLOCKS[uch >> NON_ASCII_DIGIT_BLOCK_BITS]]
+        [uch & NON_ASCII_DIGIT_BLOCK_MASK];
+}}
+
+#endif //RATIONAL_NON_ASCII_DIGITS_H
+"""
+
+
+def digit_zeros():
+    for cp in range(0x80, sys.maxunicode + 1):
+        if unicodedata.decimal(chr(cp), -1) == 0:
+            yield cp
+
+
+def main(path):
+    zeros = list(digit_zeros())
+    min_cp = zeros[0]
+    max_cp = zeros[-1] + 9
+    values = {}
+    names = {}
+    for zero in zeros:
+        name = unicodedata.name(chr(zero)).replace(" ZERO", "")
+        for cp in range(zero, zero + 10):
+            assert unicodedata.decimal(chr(cp)) == cp - zero
+            values[cp] = cp - zero
+            names.setdefault(cp >> BLOCK_BITS, []).append(name)
+    n_blocks = (max_cp >> BLOCK_BITS) + 1
+    block_idx = [0] * n_blocks
+    rows = [[-1] * BLOCK_SIZE]
+    comments = ["no digits"]
+    for block in sorted(names):
+        block_idx[block] = len(rows)
+        base = block << BLOCK_BITS
+        rows.append([values.get(base + i, -1) for i in range(BLOCK_SIZE)])
+        comments.append(f"0x{base:05X}: " +
+                        ", ".join(dict.fromkeys(names[block])))
+    assert len(rows) < 256
+    out = [HEADER.format(version=unicodedata.unidata_version, min=min_cp,
+                         max=max_cp, block_bits=BLOCK_BITS)]
+    out.append("// index into NON_ASCII_DIGIT_VALUES per block of code "
+               "points\n")
+    out.append(f"static const uint8_t NON_ASCII_DIGIT_BLOCKS[{n_blocks}] "
+               "= {\n")
+    for i in range(0, n_blocks, 16):
+        out.append("    " +
+                   ", ".join(f"{idx:2d}" for idx in block_idx[i:i + 16]) +
+                   ",\n")
+    out.append("};\n\n")
+    out.append("// digit values of the code points of a block\n")
+    out.append("static const int8_t NON_ASCII_DIGIT_VALUES"
+               f"[{len(rows)}][{BLOCK_SIZE}] = {{\n")
+    for row, comment in zip(rows, comments):
+        for line in textwrap.wrap(comment, 72, subsequent_indent="  "):
+            out.append(f"    // {line}\n")
+        out.append("    {")
+        for i in range(0, BLOCK_SIZE, 16):
+            sep = "\n     " if i else ""
+            out.append(sep + ", ".join(f"{v:2d}" for v in row[i:i + 16]) +
+                       ("," if i + 16 < BLOCK_SIZE else ""))
+        out.append("},\n")
+    out.append("};\n\n")
+    out.append(FOOTER.format())
+    with open(path, "w") as f:
+        f.write("".join(out))
+
+
+if __name__ == "__main__":
+    dflt_path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             "..", "src", "rational", "non_ascii_digits.h")
+    main(sys.argv[1] if len(sys.argv) > 1 else dflt_path)